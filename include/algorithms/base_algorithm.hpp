@@ -6,6 +6,9 @@
 #include <vector>
 
 namespace vcompress {
+namespace utils {
+class ThreadPool;
+}
 namespace algorithm {
 
 /// Enums
@@ -14,7 +17,26 @@ namespace algorithm {
 // Key frames are complete frames that can be decoded independently, while delta frames contain only the
 // changes from the previous frame.
 // This allows for efficient storage compression and transmission of video data.
-enum FrameType { KEY_FRAME, DELTA_FRAME };
+// Interpolated frames are dropped by temporal downsampling; only motion fields are stored and the frame
+// is rebuilt from the surrounding key/delta frames (anchors) on decode.
+// Predicted frames are delta frames coded as a residual against the previous anchor's payload;
+// bidirectional frames are predicted from the anchors on both sides and are coded after the later one.
+// Enhancement layers are optional side records written right before the base record of their frame; they
+// refine the decoded frame and can be dropped without affecting any other record.
+// Film grain records carry the grain parameters of a GOP, ahead of its key frame; the decoder adds
+// synthesized grain to every frame it outputs until the next set.
+// Background frames carry the long-term background reference, coded as an inter record; they are never
+// displayed, and the decoder drops the background at every key frame.
+enum FrameType {
+    KEY_FRAME,
+    DELTA_FRAME,
+    INTERPOLATED_FRAME,
+    PREDICTED_FRAME,
+    BIDIRECTIONAL_FRAME,
+    ENHANCEMENT_LAYER,
+    FILM_GRAIN,
+    BACKGROUND_FRAME
+};
 
 /// Structs
 // Frame: Represents a single video frame with all necessary metadata
@@ -32,15 +54,56 @@ struct Frame {
     Frame(int w, int h) : width(w), height(h), timestamp(0), type(KEY_FRAME) {}
 };
 
+// RegionOfInterest: A rectangle (in original frame pixels) that should keep more detail than the rest
+struct RegionOfInterest {
+    int x;
+    int y;
+    int width;
+    int height;
+    // Constructors
+    RegionOfInterest() : x(0), y(0), width(0), height(0) {}
+    RegionOfInterest(int x, int y, int w, int h) : x(x), y(y), width(w), height(h) {}
+};
+
+// PayloadLayout: Where the raw samples sit inside a compressed payload.
+// Payloads that expose their layout can be predicted from other frames in the payload domain (inter-frame
+// coding); everything before the samples is header, everything after them is coded losslessly.
+struct PayloadLayout {
+    size_t header_bytes;
+    size_t sample_bytes;
+    int width;    // Sample plane width
+    int height;   // Sample plane height
+    int channels; // Interleaved channels per sample
+    // Constructors
+    PayloadLayout() : header_bytes(0), sample_bytes(0), width(0), height(0), channels(0) {}
+};
+
 // Configuration Settings for Video Compression (to control quality vs. size tradeoffs)
 struct CompressionConfig {
     int quality;
     int target_bitrate;
     int key_frame_interval;
+    // Static ROIs applied to every frame, and an optional sidecar file with per-frame ROIs
+    std::vector<RegionOfInterest> roi_regions;
+    std::string roi_sidecar_path;
+    // Pick the downsample factor per GOP from the key frame's complexity instead of the quality alone
+    bool adaptive_factor;
+    // Extra downsample steps on top of the quality derived factor (live mode degrades under load)
+    int degradation_level;
+    // Decoder post-processing fused into the upsampler: unsharp mask strength (0-10, 0 = off),
+    // debanding of flat gradients, and ordered dithering of the final rounding
+    int sharpen_strength;
+    bool deband;
+    bool dither;
+    // Bits per stored sample of the downsampled plane (5-8); below 8 the plane is dithered and bit-packed
+    int bit_depth;
     // Constructors
-    CompressionConfig() : quality(75), target_bitrate(0), key_frame_interval(30) {}
+    CompressionConfig()
+        : quality(75), target_bitrate(0), key_frame_interval(30), adaptive_factor(false),
+          degradation_level(0), sharpen_strength(0), deband(false), dither(false), bit_depth(8) {}
     CompressionConfig(int q, int bitrate, int kfi)
-        : quality(q), target_bitrate(bitrate), key_frame_interval(kfi) {}
+        : quality(q), target_bitrate(bitrate), key_frame_interval(kfi), adaptive_factor(false),
+          degradation_level(0), sharpen_strength(0), deband(false), dither(false), bit_depth(8) {}
 };
 
 // Error Handling for Compression Algorithms (to report specific error conditions)
@@ -75,6 +138,53 @@ class BaseCompressionAlgorithm {
     /// And the compression/decompression cycle preserves as much visual quality as possible.
     virtual Frame decompressFrame(const std::vector<uint8_t> &compressed_data) = 0;
 
+    /// Describe the sample layout of a payload produced by compressFrame.
+    /// Returns false (the default) for payloads without a plain sample plane; such frames are always
+    /// intra coded.
+    virtual bool describePayload(const std::vector<uint8_t> &compressed_data, PayloadLayout &layout) const {
+        (void)compressed_data;
+        (void)layout;
+        return false;
+    }
+
+    /// Whether describePayload describes the payloads compressFrame produces under `config`, so they can be
+    /// predicted and refreshed. Returns false (the default) for payloads without a plain sample plane.
+    virtual bool describesSamplePlane(const CompressionConfig &config) const {
+        (void)config;
+        return false;
+    }
+
+    /// Rewrite a payload produced by compressFrame at a coarser downsample factor, working on the stored
+    /// samples only (no full-resolution reconstruction). Returns false (the default) for payloads without
+    /// a downsample factor.
+    virtual bool resamplePayload(const std::vector<uint8_t> &compressed_data, int factor,
+                                 std::vector<uint8_t> &resampled) const {
+        (void)compressed_data;
+        (void)factor;
+        (void)resampled;
+        return false;
+    }
+
+    /// Whether resamplePayload can rewrite the payloads of this algorithm. Returns false (the default) for
+    /// payloads without a downsample factor.
+    virtual bool resamplesPayloads() const { return false; }
+
+    /// Whether compressFrame honours a bit_depth below 8 by bit-packing its stored plane. Returns false (the
+    /// default) for algorithms that always store 8-bit samples.
+    virtual bool packsBitDepth() const { return false; }
+
+    /// Whether adaptive_factor picks the downsample factor per GOP. Returns false (the default) for
+    /// algorithms that ignore it.
+    virtual bool adaptsFactor() const { return false; }
+
+    /// Whether degradation_level raises the downsample factor. Returns false (the default) for algorithms
+    /// that ignore it.
+    virtual bool degradesFactor() const { return false; }
+
+    /// Run the parallel parts of compression on a pool shared with the caller's other work; the pool must
+    /// outlive the algorithm. Without one (the default) everything runs on the calling thread.
+    virtual void setThreadPool(utils::ThreadPool *pool) { (void)pool; }
+
     /// Get the name of the algorithm
     virtual std::string getAlgorithmName() const = 0;
 
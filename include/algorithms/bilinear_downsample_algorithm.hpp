@@ -2,10 +2,15 @@
 
 #include "base_algorithm.hpp"
 #include <opencv2/opencv.hpp>
+#include <tuple>
 
 namespace vcompress {
 namespace algorithm {
 
+/// Bilinear sampling helpers, shared with the motion-compensated warp in utils/motion
+std::tuple<int, int, float> calculateInterpolationParams(float pos, float ratio, int max_dim);
+uint8_t getPixelValue(const uint8_t *src, int src_width, int y, int x, int c);
+
 /// @brief By reducing the spatial resolution of each frame.
 class BilinearDownsampleAlgorithm : public BaseCompressionAlgorithm {
   public:
@@ -15,34 +20,72 @@ class BilinearDownsampleAlgorithm : public BaseCompressionAlgorithm {
     bool initialize(const CompressionConfig &config) override;
     std::vector<uint8_t> compressFrame(const Frame &frame) override;
     Frame decompressFrame(const std::vector<uint8_t> &compressed_data) override;
+    bool describePayload(const std::vector<uint8_t> &compressed_data, PayloadLayout &layout) const override;
+    /// A bit-packed plane has no per-sample bytes, so only 8-bit payloads are described
+    bool describesSamplePlane(const CompressionConfig &config) const override {
+        return config.bit_depth >= 8;
+    }
+    bool resamplePayload(const std::vector<uint8_t> &compressed_data, int factor,
+                         std::vector<uint8_t> &resampled) const override;
+    bool resamplesPayloads() const override { return true; }
+    bool packsBitDepth() const override { return true; }
+    bool adaptsFactor() const override { return true; }
+    bool degradesFactor() const override { return true; }
     std::string getAlgorithmName() const override { return "BilinearDownsample"; }
     std::string getStats() const override;
-    CompressionError getLastError() const override { return CompressionError(); }
+    CompressionError getLastError() const override { return m_last_error; }
     void reset() override;
 
   protected:
     // Shared by All instances
     static const size_t WIDTH_BYTES = 4;
     static const size_t HEIGHT_BYTES = 4;
-    static const size_t METADATA_BYTES = WIDTH_BYTES + HEIGHT_BYTES;
+    static const size_t FACTOR_BYTES = 1;
+    static const size_t METADATA_BYTES = WIDTH_BYTES + HEIGHT_BYTES + FACTOR_BYTES;
+    /// Factor bytes with this bit set are followed by a sample depth byte and a bit-packed plane
+    static const uint8_t PACKED_FLAG = 0x80;
+    static const size_t DEPTH_BYTES = 1;
 
     CompressionConfig m_config;
     CompressionError m_last_error;
+    /// Factor derived from the quality setting, and the factor used for the current GOP
     int m_downsample_factor;
+    int m_gop_factor;
 
     struct {
         int frames_compressed;
         int frames_decompressed;
         double average_compression_ratio;
+        double average_factor;
         double total_compression_time_ms;
         double total_decompression_time_ms;
     } m_stats;
 
+    /// Select the factor of the frame; with adaptive factors a new one is picked at every key frame
+    int selectFrameFactor(const Frame &frame);
+    void writeMetadata(uint8_t *buffer, int width, int height, int factor) const;
+    void readMetadata(const uint8_t *buffer, int &width, int &height, int &factor) const;
+    /// Read the metadata of a payload to decode; false (and the last error set) if it cannot be decoded
+    bool checkPayload(const std::vector<uint8_t> &compressed_data, int &width, int &height, int &factor);
+    /// Sample depth of a payload: 8, or the depth of a bit-packed plane
+    int payloadBitDepth(const std::vector<uint8_t> &compressed_data) const;
+    /// Replace the plane of an 8-bit payload by its bit-packed form at `bits` per sample
+    void packPayload(std::vector<uint8_t> &compressed_data, int plane_width, int plane_height,
+                     int bits) const;
+    /// The 8-bit plane of a payload; a bit-packed plane is expanded into `buffer`
+    const uint8_t *payloadPlane(const std::vector<uint8_t> &compressed_data, size_t plane_bytes,
+                                std::vector<uint8_t> &buffer) const;
+
     void downsampleBilinear(const uint8_t *src, uint8_t *dst, int src_width, int src_height, int dst_width,
-                            int dst_height);
+                            int dst_height) const;
 
     void upsampleBilinear(const uint8_t *src, uint8_t *dst, int src_width, int src_height, int dst_width,
                           int dst_height);
+
+    /// True when the config asks for any of the post-processing steps of upsamplePostProcessed
+    bool hasPostProcessing() const;
+    void upsamplePostProcessed(const uint8_t *src, uint8_t *dst, int src_width, int src_height, int dst_width,
+                               int dst_height) const;
 };
 
 /**
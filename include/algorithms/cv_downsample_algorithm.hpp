@@ -15,20 +15,35 @@ class CVDownsampleAlgorithm : public BaseCompressionAlgorithm {
     bool initialize(const CompressionConfig &config) override;
     std::vector<uint8_t> compressFrame(const Frame &frame) override;
     Frame decompressFrame(const std::vector<uint8_t> &compressed_data) override;
+    bool describePayload(const std::vector<uint8_t> &compressed_data, PayloadLayout &layout) const override;
+    /// A bit-packed plane has no per-sample bytes, so only 8-bit payloads are described
+    bool describesSamplePlane(const CompressionConfig &config) const override {
+        return config.bit_depth >= 8;
+    }
+    bool resamplePayload(const std::vector<uint8_t> &compressed_data, int factor,
+                         std::vector<uint8_t> &resampled) const override;
+    bool resamplesPayloads() const override { return true; }
+    bool packsBitDepth() const override { return true; }
+    bool adaptsFactor() const override { return true; }
+    bool degradesFactor() const override { return true; }
     std::string getAlgorithmName() const override { return "CVDownsample"; }
     std::string getStats() const override;
-    CompressionError getLastError() const override { return CompressionError(); }
+    CompressionError getLastError() const override { return m_last_error; }
     void reset() override;
 
     void updateCompressionStats(const cv::Mat &original, const cv::Mat &compressed);
-    void copyMatToBuffer(const cv::Mat &mat, int w, int h, uint8_t *buffer);
-    cv::Mat copyBufferToMat(const uint8_t *buffer, int &w, int &h, size_t bufferSize);
+    void copyMatToBuffer(const cv::Mat &mat, int w, int h, int factor, uint8_t *buffer);
+    cv::Mat copyBufferToMat(const uint8_t *buffer, int &w, int &h, size_t bufferSize) const;
 
   private:
     // Shared by All instances
     static const size_t WIDTH_BYTES = 4;
     static const size_t HEIGHT_BYTES = 4;
-    static const size_t METADATA_BYTES = WIDTH_BYTES + HEIGHT_BYTES;
+    static const size_t FACTOR_BYTES = 1;
+    static const size_t METADATA_BYTES = WIDTH_BYTES + HEIGHT_BYTES + FACTOR_BYTES;
+    /// Factor bytes with this bit set are followed by a sample depth byte and a bit-packed plane
+    static const uint8_t PACKED_FLAG = 0x80;
+    static const size_t DEPTH_BYTES = 1;
 
     CompressionConfig m_config;
     CompressionError m_last_error;
@@ -36,11 +51,14 @@ class CVDownsampleAlgorithm : public BaseCompressionAlgorithm {
     /// Downsampling factor - higher number means more compression
     /// 2 = half resolution, 4 = quarter resolution, etc.
     int m_downsample_factor;
+    /// Factor of the current GOP (differs from m_downsample_factor only with adaptive factors)
+    int m_gop_factor;
 
     struct {
         int frames_compressed;
         int frames_decompressed;
         double average_compression_ratio;
+        double average_factor;
         double total_compression_time_ms;
         double total_decompression_time_ms;
     } m_stats;
@@ -48,6 +66,14 @@ class CVDownsampleAlgorithm : public BaseCompressionAlgorithm {
     /// Convert between our Frame struct and OpenCV's Mat class
     cv::Mat frameToMat(const Frame &frame);
     Frame matToFrame(const cv::Mat &mat);
+
+    /// Select the factor of the frame; with adaptive factors a new one is picked at every key frame
+    int selectFrameFactor(const Frame &frame);
+    /// Whether the configured depth bit-packs the stored plane
+    bool packsPlane() const;
+    /// Replace the plane of an 8-bit payload by its bit-packed form at `bits` per sample
+    void packPayload(std::vector<uint8_t> &compressed_data, int plane_width, int plane_height,
+                     int bits) const;
 };
 
 } // namespace algorithm
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "bilinear_downsample_algorithm.hpp"
+#include <map>
+
+namespace vcompress {
+namespace algorithm {
+
+/**
+ * @brief Region-of-interest downsampling with a spatially varying factor.
+ *  The frame is split into square tiles; tiles touching a ROI are kept at factor 1-2 while the background
+ *  is reduced by 4 or more. The factor of every tile is recorded in the payload, so the decoder can
+ *  reassemble the full resolution frame without knowing the ROIs.
+ */
+class ROIDownsampleAlgorithm : public BilinearDownsampleAlgorithm {
+  public:
+    ROIDownsampleAlgorithm();
+    ~ROIDownsampleAlgorithm() override;
+
+    bool initialize(const CompressionConfig &config) override;
+    std::vector<uint8_t> compressFrame(const Frame &frame) override;
+    Frame decompressFrame(const std::vector<uint8_t> &compressed_data) override;
+    bool describePayload(const std::vector<uint8_t> &compressed_data, PayloadLayout &layout) const override;
+    bool describesSamplePlane(const CompressionConfig &) const override { return true; }
+    /// Tiles are stored at different factors, there is no single plane to resample
+    bool resamplesPayloads() const override { return false; }
+    bool packsBitDepth() const override { return false; }
+    bool adaptsFactor() const override { return false; }
+    bool degradesFactor() const override { return false; }
+    std::string getAlgorithmName() const override { return "ROIDownsample"; }
+    std::string getStats() const override;
+    CompressionError getLastError() const override { return m_last_error; }
+    void reset() override;
+
+  private:
+    static constexpr size_t TILE_SIZE_BYTES = 2;
+    static constexpr size_t ROI_METADATA_BYTES = METADATA_BYTES + TILE_SIZE_BYTES;
+    static constexpr int TILE_SIZE = 32; // Divisible by every factor used below
+
+    int m_roi_factor;
+    int m_background_factor;
+
+    /// Per-frame ROIs loaded from the sidecar file, keyed by frame number (timestamp)
+    std::map<int, std::vector<RegionOfInterest>> m_frame_rois;
+
+    /// Share of tiles coded at the ROI factor, for the statistics
+    double m_roi_tile_ratio;
+
+    bool loadSidecar(const std::string &path);
+    const std::vector<RegionOfInterest> &regionsForFrame(int frame_number) const;
+    std::vector<uint8_t> selectTileFactors(const std::vector<RegionOfInterest> &regions, int width,
+                                           int height, int tiles_x, int tiles_y) const;
+    static int clampTileFactor(int factor, int tile_width, int tile_height);
+};
+
+} // namespace algorithm
+} // namespace vcompress
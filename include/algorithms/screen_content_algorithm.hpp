@@ -0,0 +1,64 @@
+#pragma once
+
+#include "base_algorithm.hpp"
+#include "utils/bitstream.hpp"
+#include <opencv2/opencv.hpp>
+
+namespace vcompress {
+namespace algorithm {
+
+/**
+ * @brief Screen-content coding for UI, slide and terminal recordings.
+ *  The frame is split into square tiles. Tiles with at most MAX_PALETTE distinct colors are coded losslessly
+ *  at full resolution as palette indices, with index runs and copy-from-above runs; a tile identical to an
+ *  earlier palette tile of the frame (found by hash) is coded as a copy of it. All other (natural) tiles
+ *  take the CVDownsample path: their cells of the area-downsampled plane are stored raw and the decoder
+ *  upsamples the plane bilinearly, so sharp text costs a few bits per run instead of being blurred away.
+ */
+class ScreenContentAlgorithm : public BaseCompressionAlgorithm {
+  public:
+    ScreenContentAlgorithm();
+    ~ScreenContentAlgorithm() override;
+
+    bool initialize(const CompressionConfig &config) override;
+    std::vector<uint8_t> compressFrame(const Frame &frame) override;
+    Frame decompressFrame(const std::vector<uint8_t> &compressed_data) override;
+    /// Only the natural (non-palette) tiles are downsampled, at a factor fixed for the stream
+    bool degradesFactor() const override { return true; }
+    std::string getAlgorithmName() const override { return "ScreenContent"; }
+    std::string getStats() const override;
+    CompressionError getLastError() const override { return m_last_error; }
+    void reset() override;
+
+  private:
+    /// Payload: | width (4) | height (4) | factor (1) | tile size (1) | tile stream bytes (4) |
+    ///          | tile stream (mode and palette data per tile) | natural cells of the downsampled plane |
+    static constexpr size_t METADATA_BYTES = 4 + 4 + 1 + 1 + 4;
+    static constexpr int TILE_SIZE = 24; // Divisible by factors 2, 3, 4, 6 and 8
+    static constexpr int MAX_PALETTE = 8;
+    enum TileMode : uint32_t { NATURAL = 0, PALETTE = 1, COPY = 2 };
+
+    CompressionConfig m_config;
+    CompressionError m_last_error;
+    int m_downsample_factor;
+
+    struct {
+        int frames_compressed;
+        int frames_decompressed;
+        double palette_tile_ratio;
+        double copy_tile_ratio;
+        double average_compression_ratio;
+        double total_compression_time_ms;
+        double total_decompression_time_ms;
+    } m_stats;
+
+    static int countColors(const uint8_t *frame, int width, int x0, int y0, int tile_width, int tile_height,
+                           uint32_t *palette);
+    static void encodePaletteTile(utils::BitWriter &writer, const uint8_t *frame, int width, int x0, int y0,
+                                  int tile_width, int tile_height, const uint32_t *palette, int colors);
+    static bool decodePaletteTile(utils::BitReader &reader, uint8_t *frame, int width, int x0, int y0,
+                                  int tile_width, int tile_height);
+};
+
+} // namespace algorithm
+} // namespace vcompress
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "base_algorithm.hpp"
+#include "utils/thread_pool.hpp"
+#include <opencv2/opencv.hpp>
+
+namespace vcompress {
+namespace algorithm {
+
+/**
+ * @brief Vector quantization of the downsampled frame with a codebook trained per GOP.
+ *  The frame is area-downsampled as in CVDownsample, split into 2x2 (or 4x4 at low quality) pixel blocks,
+ *  and every block is replaced by the index of its nearest codeword. The codebook (up to 256 codewords) is
+ *  trained with mini-batch k-means on each key frame and sent with it; the delta frames of the GOP only
+ *  carry indices and the codebook id.
+ *
+ *  Decoding is a table lookup: every codeword is upsampled to a full-resolution tile once per codebook,
+ *  and a frame is assembled by copying one tile per index, so there is no per-frame upsampling.
+ */
+class VQAlgorithm : public BaseCompressionAlgorithm {
+  public:
+    VQAlgorithm();
+    ~VQAlgorithm() override;
+
+    bool initialize(const CompressionConfig &config) override;
+    std::vector<uint8_t> compressFrame(const Frame &frame) override;
+    Frame decompressFrame(const std::vector<uint8_t> &compressed_data) override;
+    bool adaptsFactor() const override { return true; }
+    bool degradesFactor() const override { return true; }
+    std::string getAlgorithmName() const override { return "VQ"; }
+    std::string getStats() const override;
+    CompressionError getLastError() const override { return m_last_error; }
+    void reset() override;
+    void setThreadPool(utils::ThreadPool *pool) override { m_pool = pool; }
+
+  private:
+    /// Payload: | width (4) | height (4) | factor (1) | block size (1) | codewords (2) | codebook id (4) |
+    ///          | has codebook (1) | [codebook: codewords * block * block * 3] | indices (1 per block) |
+    static constexpr size_t METADATA_BYTES = 4 + 4 + 1 + 1 + 2 + 4 + 1;
+    static constexpr int MAX_CODEWORDS = 256;
+
+    CompressionConfig m_config;
+    CompressionError m_last_error;
+    int m_downsample_factor;
+    int m_block_size;
+    utils::ThreadPool *m_pool;
+
+    /// Encoder: the codebook of the current GOP (padded codewords) and its id
+    int m_gop_factor;
+    int m_codewords;
+    int m_padded_dim;
+    std::vector<uint8_t> m_codebook;
+    uint32_t m_codebook_id;
+
+    /// Decoder: the last received codebook, expanded to full-resolution tiles
+    uint32_t m_decoder_codebook_id;
+    int m_tile_size;
+    std::vector<uint8_t> m_tiles;
+
+    struct {
+        int frames_compressed;
+        int frames_decompressed;
+        int codebooks_trained;
+        double average_compression_ratio;
+        double average_distortion;
+        double total_compression_time_ms;
+        double total_decompression_time_ms;
+    } m_stats;
+
+    std::vector<uint8_t> extractBlocks(const cv::Mat &plane, int blocks_x, int blocks_y,
+                                       int padded_dim) const;
+    void trainCodebook(const std::vector<uint8_t> &blocks, int block_count, int padded_dim);
+    double assignBlocks(const std::vector<uint8_t> &blocks, int block_count, uint8_t *indices);
+    void expandCodebook(const uint8_t *codebook, int codewords, int block_size, int factor);
+};
+
+} // namespace algorithm
+} // namespace vcompress
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "core/decoder.hpp"
+#include "core/encoder.hpp"
+#include "utils/buffer_pool.hpp"
+#include "utils/thread_pool.hpp"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace vcompress {
+namespace core {
+
+/// @brief One job of a batch manifest
+struct BatchJob {
+    std::string id;                          // Names the result file (default: job<index>)
+    std::string mode = "encode";             // "encode" or "decode"
+    std::string input;                       // Source video (encode) or .vcomp file (decode)
+    std::string output;                      // .vcomp file (encode) or decoded video (decode)
+    std::string algorithmName = "CVDownsample";
+    int quality = 75;
+    int keyFrameInterval = 30;
+    int temporalFactor = 1;
+    int bFrames = 0;
+    int intraRefreshPeriod = 0;
+    bool interPrediction = false;
+    bool blockCoding = false;
+    bool backgroundReference = false;
+    int referenceFrames = 1;                 // Encode: anchors a predicted anchor picks from (1-4)
+    bool adaptiveFactor = false;
+    int enhancementQuantStep = 0;            // Encode: enhancement layer quantizer step (0 = none)
+    int denoiseStrength = 0;                 // Encode: temporal denoise prefilter strength (0 = off)
+    int bitDepth = 8;                        // Encode: bits per stored sample (5-8, 8 = no packing)
+    bool filmGrain = false;                  // Encode: grain parameters per GOP, denoised picture
+    bool synthesizeGrain = true;             // Decode: add the film grain back
+    bool baseLayerOnly = false;              // Decode: skip the enhancement layers
+    int sharpenStrength = 0;                 // Decode: unsharp mask in the upsampler (0 = off)
+    bool deband = false;                     // Decode: smooth banded gradients while upsampling
+    bool dither = false;                     // Decode: ordered dither on the upsampler's rounding
+    std::string audioPath;                   // Encode: extract the audio here; decode: mux this audio
+    std::string ladder;                      // Encode a ladder "ALGO:Q,..." instead of a single output
+    std::string gopCacheDir;                 // Reuse unchanged GOPs of earlier encodes (empty = off)
+    std::string frameCacheDir;               // Reuse decoded frames of earlier encodes (empty = off)
+};
+
+/// @brief Resource limits and output location of a batch
+struct BatchConfig {
+    int threads = 0;               // Shared worker threads (0 = one per hardware thread)
+    int maxConcurrentJobs = 0;     // Jobs running at once (0 = one per worker thread)
+    int64_t maxMemoryBytes = 0;    // Estimated frame memory of the running jobs (0 = unlimited)
+    std::string resultsDir = ".";  // Receives <job id>.json per job (empty = no result files)
+};
+
+/// @brief Outcome of one job
+struct BatchResult {
+    bool success = false;
+    std::string error;
+    int frames = 0;
+    int64_t inputBytes = 0;
+    int64_t outputBytes = 0;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Runs the encode/decode jobs of a JSON manifest in one process
+ *
+ * Manifest:
+ *   { "threads": 8, "max_concurrent_jobs": 4, "max_memory_mb": 2048, "results_dir": "results",
+ *     "jobs": [ { "id": "clip1", "mode": "encode", "input": "clip1.mp4", "output": "clip1.vcomp",
+ *                 "algorithm": "CVDownsample", "quality": 60, "bframes": 2, "gop_cache": "cache", ... },
+ *               ... ] }
+ * Jobs run as tasks of one work-stealing pool, which also runs their inner parallel work (ladder rungs),
+ * and recycle frame buffers through one shared buffer pool. A job is admitted once a job slot is free and
+ * its estimated frame memory fits the budget; a job larger than the whole budget runs alone. Every job
+ * writes a JSON result with its status and statistics.
+ */
+class BatchRunner {
+  public:
+    using ProgressCallback = std::function<void(int)>;
+    using CompletionCallback = std::function<void(const BatchResult &)>;
+
+    BatchRunner();
+    ~BatchRunner();
+
+    /**
+     * @brief Read the limits and jobs of a manifest
+     *
+     * @param path JSON manifest file
+     * @return true if the manifest was read and all of its jobs are valid
+     */
+    bool loadManifest(const std::string &path);
+
+    /**
+     * @brief Read one job object of a manifest or a daemon request
+     *
+     * @param node The job object; missing fields keep their defaults
+     * @param job Receives the job
+     * @param error Receives the reason if the job is invalid
+     */
+    static bool parseJob(const cv::FileNode &node, BatchJob &job, std::string &error);
+
+    /// @brief The loaded limits, which may be changed before the first job is submitted
+    BatchConfig &config() { return m_config; }
+
+    /// @brief Jobs read from the manifest
+    const std::vector<BatchJob> &jobs() const { return m_jobs; }
+
+    /**
+     * @brief Run every job of the manifest and wait for them
+     *
+     * @return true if all jobs succeeded
+     */
+    bool run();
+
+    /**
+     * @brief Start one job on the shared pools
+     *  Blocks until the job is admitted, then returns while the job runs. The callbacks run on the job's
+     *  worker thread.
+     *
+     * @param onProgress Called with the frames done so far (encode/decode jobs, not ladders)
+     * @param onComplete Called with the result once the result file is written
+     */
+    void submit(const BatchJob &job, ProgressCallback onProgress = nullptr,
+                CompletionCallback onComplete = nullptr);
+
+    /// @brief Block until every submitted job has finished
+    void wait();
+
+    /// @brief One job result as a JSON object
+    static std::string formatResult(const BatchJob &job, const BatchResult &result);
+
+    /**
+     * @brief Get batch statistics
+     *
+     * @return String containing statistics
+     */
+    std::string getStats() const;
+
+  private:
+    BatchConfig m_config;
+    std::vector<BatchJob> m_jobs;
+    std::unique_ptr<utils::ThreadPool> m_pool;
+    utils::ThreadPool::TaskGroup m_running;
+    utils::BufferPool m_bufferPool;
+
+    /// Admission control
+    std::mutex m_admissionMutex;
+    std::condition_variable m_admissionChanged;
+    int m_runningJobs;
+    int64_t m_reservedMemory;
+
+    struct {
+        int jobsSucceeded;
+        int jobsFailed;
+        int64_t peakReservedMemory;
+        double totalProcessingTime;
+    } m_stats;
+
+    void startPool();
+    void admit(int64_t memory);
+    void retire(int64_t memory, bool success);
+    int64_t estimateMemory(const BatchJob &job) const;
+    void runJob(const BatchJob &job, const ProgressCallback &onProgress, BatchResult &result);
+    bool runEncode(const BatchJob &job, const ProgressCallback &onProgress, BatchResult &result);
+    bool runDecode(const BatchJob &job, const ProgressCallback &onProgress, BatchResult &result);
+    void writeResult(const BatchJob &job, const BatchResult &result) const;
+};
+
+} // namespace core
+} // namespace vcompress
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "algorithms/base_algorithm.hpp"
+#include "core/inter_coder.hpp"
 #include "utils/audio.hpp"
 #include "utils/compressed_format.hpp"
 #include "utils/file_reader.hpp"
 #include "utils/file_writer.hpp"
+#include "utils/film_grain.hpp"
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -16,12 +20,18 @@ struct DecoderConfig {
     std::string compressedDataPath = "data.vcomp";
     std::string tempVideoPath = "temp_processed_video.mp4";
     std::string tempAudioPath = "temp_audio.aac";
-    std::string inputPath;      // Input compressed video file path
-    std::string outputPath;     // Output decompressed video file path
-    std::string algorithmName;  // Decompression algorithm to use
-    int quality = 75;           // Quality setting (may affect some algorithms)
-    bool keepAudio = true;      // Whether to preserve audio
-    bool keepTempFiles = false; // Whether to keep temporary files
+    std::string inputPath;       // Input compressed video file path
+    std::string outputPath;      // Output decompressed video file path
+    std::string algorithmName;   // Decompression algorithm to use
+    int quality = 75;            // Quality setting (may affect some algorithms)
+    int seekFrame = 0;           // Start output at the first recovery point at or after this frame
+    bool baseLayerOnly = false;  // Skip enhancement layer records (fast preview)
+    bool synthesizeGrain = true; // Add film grain back when the stream carries grain parameters
+    int sharpenStrength = 0;     // Unsharp mask fused into the upsampler (0-10, 0 = off)
+    bool deband = false;         // Smooth banded gradients while upsampling
+    bool dither = false;         // Ordered dither on the upsampler's final rounding
+    bool keepAudio = true;       // Whether to preserve audio
+    bool keepTempFiles = false;  // Whether to keep temporary files
 
     DecoderConfig() = default;
     DecoderConfig(const std::string &input, const std::string &output, const std::string &algo, int q,
@@ -63,6 +73,16 @@ class VideoDecoder {
      */
     bool decode();
 
+    /**
+     * @brief Decode the compressed file into frames handed to the caller instead of an output video
+     *  Frames arrive in display order, exactly as decoded (no lossy output codec, no audio), which is what
+     *  verification needs. Reads DecoderConfig::compressedDataPath and keeps it.
+     *
+     * @param onFrame Called with every output frame; its timestamp is the frame number
+     * @return false if the compressed file could not be read
+     */
+    bool decodeFrames(std::function<void(const algorithm::Frame &)> onFrame);
+
     /**
      * @brief Get decoding statistics
      *
@@ -70,6 +90,22 @@ class VideoDecoder {
      */
     std::string getStats() const;
 
+    /// @brief Statistics for machine-readable reports
+    int getFramesProcessed() const { return m_stats.framesProcessed; }
+    int64_t getTotalInputSize() const { return m_stats.totalInputSize; }
+    int64_t getTotalOutputSize() const { return m_stats.totalOutputSize; }
+    double getTotalProcessingTime() const { return m_stats.totalProcessingTime; }
+
+    /// @brief Called with the number of frames written so far after every output frame
+    void setProgressCallback(std::function<void(int)> callback) { m_progressCallback = std::move(callback); }
+
+    /**
+     * @brief Run the deblocking of block records on a pool, which may be shared with other work
+     *  Must be called before configure(); without a pool it runs on the decoding thread. The pool must
+     *  outlive the decoder.
+     */
+    void setThreadPool(utils::ThreadPool *pool) { m_threadPool = pool; }
+
   private:
     /// Configuration
     DecoderConfig m_config;
@@ -78,10 +114,33 @@ class VideoDecoder {
     std::unique_ptr<algorithm::BaseCompressionAlgorithm> m_algorithm;
     std::unique_ptr<utils::FileWriter> m_fileWriter;
     std::unique_ptr<utils::CompressedFormat> m_compressedFormat;
+    std::unique_ptr<InterFrameCoder> m_interCoder;
+    std::function<void(int)> m_progressCallback;
+    std::function<void(const algorithm::Frame &)> m_frameCallback;
+    utils::ThreadPool *m_threadPool;
+
+    /// Reorder buffer: decoded frames keyed by display timestamp, and the next timestamp to write
+    static constexpr size_t MAX_REORDER_FRAMES = 16;
+    std::map<int, algorithm::Frame> m_reorderBuffer;
+    int m_nextTimestamp;
+
+    /// Recovery: output starts at a key frame or once a full intra refresh cycle has been decoded
+    bool m_recovered;
+    int m_refreshCount;
+
+    /// Enhancement layer waiting for the base record of its frame
+    int m_enhancementTimestamp;
+    std::vector<uint8_t> m_enhancementLayer;
+
+    /// Film grain of the current GOP, added to every output frame while active
+    bool m_grainActive;
+    utils::FilmGrainParams m_grain;
+    utils::FilmGrainSynthesizer m_grainSynthesizer;
 
     /// Statistics
     struct {
         int framesProcessed;
+        int enhancementLayersApplied;
         int64_t totalInputSize;
         int64_t totalOutputSize;
         double averageTimePerFrame;
@@ -91,6 +150,13 @@ class VideoDecoder {
     // Helper methods
     bool createAlgorithm();
     bool processVideo();
+    bool reachesRecoveryPoint(uint8_t frameType, const std::vector<uint8_t> &record);
+    void applyEnhancementLayer(algorithm::Frame &frame, int timestamp);
+    void writeInterpolatedFrames(const std::vector<std::pair<int, std::vector<uint8_t>>> &records,
+                                 const algorithm::Frame &previousAnchor, const algorithm::Frame &nextAnchor);
+    void queueOutputFrame(algorithm::Frame frame, int timestamp);
+    void drainReorderBuffer(bool flush);
+    void writeOutputFrame(const algorithm::Frame &frame);
     bool combineVideoWithAudio(const std::string &videoFile, const std::string &audioFile,
                                const std::string &outputFile);
 };
@@ -1,10 +1,17 @@
 #pragma once
 
 #include "algorithms/base_algorithm.hpp"
+#include "core/inter_coder.hpp"
 #include "utils/audio.hpp"
+#include "utils/background_model.hpp"
+#include "utils/buffer_pool.hpp"
 #include "utils/compressed_format.hpp"
 #include "utils/file_reader.hpp"
 #include "utils/file_writer.hpp"
+#include "utils/reference_buffer.hpp"
+#include "utils/temporal_denoiser.hpp"
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -22,9 +29,33 @@ struct EncoderConfig {
     int quality = 75;                  // Quality setting (1-100)
     int bitrate = 0;                   // Target bitrate in kbps (0 = variable)
     int keyFrameInterval = 30;         // Number of frames between key frames
+    int temporalFactor = 1;            // Store every Nth frame; the rest is interpolated on decode
+    int bFrames = 0;                   // Bidirectional frames between anchors (implies inter prediction)
+    int intraRefreshPeriod = 0;        // Frames per rolling intra refresh cycle, no key frames (0 = off)
     bool visualizeCompression = false; // Whether to show the compressed frames directly
     bool keepAudio = true;             // Whether to preserve audio
     bool keepTempFiles = false;        // Whether to keep temporary files
+    bool adaptiveFactor = false;       // Pick the downsample factor per GOP from the content complexity
+    bool interPrediction = false;      // Code delta frames as residuals against the previous anchor
+    bool blockCoding = false;          // Per-block residual quantizers, deblocked in the loop (implies inter)
+    bool backgroundReference = false;  // Long-term background model as a second reference (implies inter)
+    int referenceFrames = 1;           // Anchors a predicted anchor picks from per block (1-4, >1 = inter)
+    bool liveMode = false;             // Paced capture thread, no lookahead, every frame flushed
+    double latencyBudgetMs = 0.0;      // Live capture-to-packet latency budget (0 = one frame interval)
+    bool resume = false;               // Continue an interrupted encode from its checkpoint
+    double checkpointSeconds = 10.0;   // Minimum time between checkpoints, taken at key frames (0 = each)
+    int startFrame = 0;                // First source frame to encode (a key frame when > 0)
+    int endFrame = 0;                  // Source frame to stop before (0 = end of the input)
+    std::string gopCacheDir;           // Reuse GOPs encoded from identical frames and settings (empty = off)
+    std::string frameCacheDir;         // Keep decoded source frames for later encodes (empty = off)
+    int enhancementQuantStep = 0;      // Quantizer step of the enhancement layer (0 = base layer only)
+    int denoiseStrength = 0;           // Temporal denoise prefilter strength, 1-10 (0 = off)
+    int bitDepth = 8;                  // Bits per stored sample of the downsampled plane (5-8, 8 = off)
+    bool filmGrain = false;            // Send grain parameters per GOP and denoise (decoder adds grain back)
+
+    // Region-of-interest coding (ROI-aware algorithms only)
+    std::vector<algorithm::RegionOfInterest> roiRegions; // Static ROIs applied to every frame
+    std::string roiSidecarPath;                          // Per-frame ROIs, one "frame x y w h" per line
 
     EncoderConfig() = default;
     EncoderConfig(const std::string &input, const std::string &output, const std::string &algo, int q, int b,
@@ -73,6 +104,44 @@ class VideoEncoder {
      */
     std::string getStats() const;
 
+    /// @brief Statistics for machine-readable reports
+    int getFramesProcessed() const { return m_stats.framesProcessed; }
+    int64_t getTotalInputSize() const { return m_stats.totalInputSize; }
+    int64_t getTotalOutputSize() const { return m_stats.totalOutputSize; }
+    double getTotalProcessingTime() const { return m_stats.totalProcessingTime; }
+    int getGopCacheHits() const { return m_stats.gopCacheHits; }
+    int getGopCacheMisses() const { return m_stats.gopCacheMisses; }
+
+    /**
+     * @brief Recycle input frame buffers through a pool, which may be shared with other encoders
+     *  The pool must outlive the encoder.
+     */
+    void setBufferPool(utils::BufferPool *pool) { m_bufferPool = pool; }
+
+    /**
+     * @brief Run the in-loop deblocking and the algorithm's parallel work (VQ codebook training) on a pool,
+     *  which may be shared with other encoders
+     *  Must be called before configure(); without a pool both run on the encoding thread. The pool must
+     *  outlive the encoder.
+     */
+    void setThreadPool(utils::ThreadPool *pool) { m_threadPool = pool; }
+
+    /// @brief Called with the number of frames coded so far after every frame (on the encoding thread)
+    void setProgressCallback(std::function<void(int)> callback) { m_progressCallback = std::move(callback); }
+
+    /**
+     * @brief Encode frames pushed by the caller instead of read from the input file
+     *  beginStream opens the compressed output, encodeFrame takes the frames in display order (wrapped by
+     *  makeInputFrame) and endStream flushes held back frames and closes the output. Used by the ladder
+     *  encoder to feed several encoders from one source decode.
+     */
+    bool beginStream(const std::string &outputPath, int width, int height, double fps);
+    void encodeFrame(const algorithm::Frame &frame);
+    void endStream();
+
+    /// @brief Wrap a decoded image as the input frame with the given frame number
+    algorithm::Frame makeInputFrame(const cv::Mat &frame, int frameNumber) const;
+
   private:
     /// Configuration
     EncoderConfig m_config;
@@ -81,6 +150,32 @@ class VideoEncoder {
     std::unique_ptr<algorithm::BaseCompressionAlgorithm> m_algorithm;
     std::unique_ptr<utils::FileReader> m_fileReader;
     std::unique_ptr<utils::CompressedFormat> m_compressedFormat;
+    std::unique_ptr<InterFrameCoder> m_interCoder;
+    std::unique_ptr<utils::TemporalDenoiser> m_denoiser;
+    utils::BufferPool *m_bufferPool;
+    utils::ThreadPool *m_threadPool;
+    std::function<void(int)> m_progressCallback;
+
+    /// Denoised copy of the current input frame
+    algorithm::Frame m_denoisedFrame;
+
+    /// Frames held back since the last anchor (dropped or B-frames), and that anchor's source pixels
+    std::vector<algorithm::Frame> m_pendingFrames;
+    algorithm::Frame m_previousAnchor;
+
+    /// Inter prediction: reconstructed payloads of the last two anchors, as the decoder will see them
+    std::vector<uint8_t> m_pastReference;
+    std::vector<uint8_t> m_futureReference;
+
+    /// Background reference: the long-term model of the anchor payloads, the copy the decoder holds (empty
+    /// until it is sent in the current GOP), the model as it was last sent, and the anchors since then
+    utils::BackgroundModel m_backgroundModel;
+    std::vector<uint8_t> m_background;
+    std::vector<uint8_t> m_sentBackground;
+    int m_anchorsSinceBackground;
+
+    /// Multiple references: the reconstructions of the last anchors of the GOP, as the decoder keeps them
+    utils::ReferenceBuffer m_references;
 
     /// Statistics
     struct {
@@ -88,14 +183,85 @@ class VideoEncoder {
         int64_t totalInputSize;
         int64_t totalOutputSize;
         double compressionRatio;
+        int64_t largestFrameSize;
         double averageTimePerFrame;
         double totalProcessingTime;
+        int gopCacheHits;
+        int gopCacheMisses;
+        int64_t enhancementBytes;
+        double denoiseTimeMs;
+        int filmGrainRecords;
+        int backgroundRecords;
     } m_stats;
 
+    /// GOP cache: records of the GOP being encoded, serialized as in a cache entry
+    bool m_capturingGop;
+    std::vector<uint8_t> m_gopRecords;
+    uint32_t m_gopRecordCount;
+    int m_gopStartTimestamp;
+
+    /// Start of the current stream, for the processing time
+    std::chrono::high_resolution_clock::time_point m_streamStartTime;
+
+    /// Checkpoints of file encodes: <output>.ckpt, rewritten at key frames every few seconds
+    struct Checkpoint {
+        std::string settings;
+        int64_t offset = 0;
+        int nextFrame = 0;
+        int framesProcessed = 0;
+        int64_t totalInputSize = 0;
+        int64_t totalOutputSize = 0;
+        int64_t largestFrameSize = 0;
+        double averageTimePerFrame = 0.0;
+    };
+    std::string m_checkpointPath;
+    std::chrono::high_resolution_clock::time_point m_lastCheckpointTime;
+
+    /// Live mode latency tracking
+    struct {
+        double budgetMs;
+        double lastMs;
+        double averageMs;
+        double maxMs;
+        int frames;
+        int framesOverBudget;
+        int overBudgetStreak;
+        int underBudgetStreak;
+        int degradationLevel;
+        int targetLevel; // Level chosen by updateLatency, applied at the next frame as a key frame
+    } m_live;
+
     /// Helper methods
     bool createAlgorithm();
+    algorithm::CompressionConfig makeAlgorithmConfig() const;
     bool extractAudioFromVideo(const std::string &inputVideo, const std::string &outputAudio);
     bool processVideo(const std::string &inputVideo, const std::string &outputVideo);
+    int encodeFrames(int firstFrame);
+    int encodeLive(double fps, bool paced);
+    void updateLatency(double latencyMs);
+    void recordFrameTime(double frameTime);
+    bool isAnchorFrame(int frameNumber, bool isKeyFrame) const;
+    void encodeAnchor(const algorithm::Frame &frame);
+    std::vector<uint8_t> encodeInter(const std::vector<uint8_t> &payload,
+                                     const std::vector<uint8_t> *prediction,
+                                     const std::vector<uint8_t> *background, int quantStep,
+                                     std::vector<uint8_t> &reconstruction) const;
+    void updateBackground(const std::vector<uint8_t> &payload, const algorithm::Frame &frame);
+    void writeInterpolatedFrames(const algorithm::Frame &nextAnchor);
+    void writeBidirectionalFrames();
+    const algorithm::Frame &denoiseFrame(const algorithm::Frame &frame);
+    void writeFilmGrain(const algorithm::Frame &keyFrame);
+    void writeEnhancementLayer(const algorithm::Frame &frame, const std::vector<uint8_t> &basePayload);
+    void writeRecord(const std::vector<uint8_t> &data, algorithm::FrameType type, int timestamp);
+    std::string checkpointSettings() const;
+    void writeCheckpoint(int nextFrame);
+    bool readCheckpoint(Checkpoint &checkpoint) const;
+    bool resumeStream(const std::string &outputPath, const Checkpoint &checkpoint);
+    void flushPendingFrames();
+    void encodeGop(std::vector<algorithm::Frame> &gop, bool lastGop);
+    std::string gopCacheKey(const std::vector<algorithm::Frame> &gop) const;
+    bool loadCachedGop(const std::string &path, const std::vector<algorithm::Frame> &gop);
+    void storeCachedGop(const std::string &path, const std::vector<algorithm::Frame> &gop) const;
 };
 
 } // namespace core
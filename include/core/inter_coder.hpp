@@ -0,0 +1,177 @@
+#pragma once
+
+#include "algorithms/base_algorithm.hpp"
+#include "utils/thread_pool.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace core {
+
+/**
+ * @brief Payload-domain inter-frame coder
+ *
+ * Predicts the sample plane of a compressed payload (see BaseCompressionAlgorithm::describePayload) from
+ * the reconstructed payload of a reference frame and entropy codes the quantized residual. Records are:
+ * - | 0 | payload |                                   raw, no usable prediction
+ * - | 1 | quant step (1) | coded residual |           residual against the prediction
+ * - | 2 | quant step (1) | band (2) | bands (2) | payload size (4) | header size (2) | header |
+ *   | band samples | coded residual of the other samples |   intra refresh
+ * - | 3 | quant step (1) | block size (1) | per block: class (2 bits), coded residual | side information |
+ *                                                     block-quantized residual, deblocked in the loop
+ * - | 4 | block size (1) | map size (4) | reference map | residual or block record |
+ *                                                     residual against a per-block mix of the prediction
+ *                                                     and a long-term background reference
+ * - | 5 | block size (1) | short-term references (1) | long-term references (1) | map size (4) |
+ *   reference map | residual or block record |       residual against a per-block mix of the last anchors
+ *                                                     (newest first) and the background
+ * The payload header is taken from the prediction, so both payloads must share it; otherwise the frame
+ * is stored raw. Refresh records carry their own header and do not depend on a prediction being present.
+ */
+class InterFrameCoder {
+  public:
+    /// References of a multi-reference record, newest first
+    using ReferenceList = std::vector<const std::vector<uint8_t> *>;
+
+    explicit InterFrameCoder(const algorithm::BaseCompressionAlgorithm *algorithm);
+
+    /**
+     * @brief Deblock block records in stripes on a pool shared with other work
+     *  Without a pool (the default) the deblocking filter runs on the calling thread. The pool must outlive
+     *  the coder.
+     */
+    void setThreadPool(utils::ThreadPool *pool) { m_pool = pool; }
+
+    /**
+     * @brief Code a payload against a prediction
+     *
+     * @param payload Payload produced by the algorithm's compressFrame
+     * @param prediction Reconstructed reference payload, or nullptr for raw coding
+     * @param quantStep Quantizer step of the sample residual (1 = lossless)
+     * @param reconstruction Receives the payload the decoder will reconstruct
+     * @return The inter record
+     */
+    std::vector<uint8_t> encode(const std::vector<uint8_t> &payload, const std::vector<uint8_t> *prediction,
+                                int quantStep, std::vector<uint8_t> &reconstruction) const;
+
+    /**
+     * @brief Code a payload with one horizontal band of its sample plane stored intra (rolling intra refresh)
+     *  The band is stored verbatim and the other samples are coded against the prediction. A missing or
+     *  incompatible prediction is replaced by mid-gray on both sides, so decoding can start at any refresh
+     *  record and is clean once every band has been refreshed.
+     *
+     * @param band,bands The refreshed band and the number of bands per refresh cycle
+     */
+    std::vector<uint8_t> encodeRefresh(const std::vector<uint8_t> &payload,
+                                       const std::vector<uint8_t> *prediction, int quantStep, int band,
+                                       int bands, std::vector<uint8_t> &reconstruction) const;
+
+    /**
+     * @brief Code a payload against a prediction block by block, for payloads with a sample plane
+     *  Every block of the plane takes its own quantizer step from its activity: flat blocks, where
+     *  quantization noise shows, half the step and textured blocks, which mask it, twice the step. Blocks
+     *  whose residual would quantize to zero are skipped. The reconstruction is deblocked (see
+     *  utils::deblockPlane) on both sides, so the next frame is predicted from the filtered samples.
+     *  Payloads without a sample plane are coded like encode().
+     */
+    std::vector<uint8_t> encodeBlocks(const std::vector<uint8_t> &payload,
+                                      const std::vector<uint8_t> *prediction, int quantStep,
+                                      std::vector<uint8_t> &reconstruction) const;
+
+    /**
+     * @brief Code a payload against the better of two references, chosen per block of the sample plane
+     *  Every block is predicted from whichever of the prediction and the background has the smaller sum of
+     *  absolute differences to the payload, so a region uncovered by a moving object is predicted from the
+     *  background while the object itself is predicted from the previous frame. The choice is stored as
+     *  one bit per block; the payload is then coded against the mixed prediction with encodeBlocks or
+     *  encode. Without a usable background, or when no block picks it, the record is a plain one.
+     *
+     * @param background Long-term reference the decoder holds as well, or nullptr
+     * @param blocks Code the mixed prediction with encodeBlocks instead of encode
+     */
+    std::vector<uint8_t> encodeMixed(const std::vector<uint8_t> &payload,
+                                     const std::vector<uint8_t> *prediction,
+                                     const std::vector<uint8_t> *background, int quantStep, bool blocks,
+                                     std::vector<uint8_t> &reconstruction) const;
+
+    /**
+     * @brief Code a payload against the best of several references, chosen per block of the sample plane
+     *  Like encodeMixed with a reference index per block instead of a bit: references[0] is the prediction
+     *  (the last anchor), the others older anchors, and the background, when given, comes last. The
+     *  record stores how many of each kind it indexes, so the decoder picks the same list from its own
+     *  window. Blocks pick the lowest index among equally good references.
+     *
+     * @param references Short-term references, newest first (at most 255)
+     * @param background Long-term reference the decoder holds as well, or nullptr
+     */
+    std::vector<uint8_t> encodeMulti(const std::vector<uint8_t> &payload, const ReferenceList &references,
+                                     const std::vector<uint8_t> *background, int quantStep, bool blocks,
+                                     std::vector<uint8_t> &reconstruction) const;
+
+    /**
+     * @brief Reconstruct the payload of an inter record
+     * @param background Long-term reference of mixed and multi-reference records, or nullptr
+     * @param references Short-term references of multi-reference records, newest first, or nullptr
+     * @return false if the record is corrupt or needs a prediction that is not available
+     */
+    bool decode(const std::vector<uint8_t> &record, const std::vector<uint8_t> *prediction,
+                std::vector<uint8_t> &payload, const std::vector<uint8_t> *background = nullptr,
+                const ReferenceList *references = nullptr) const;
+
+    /// @brief Rounded byte-wise average of two reference payloads; empty if their sizes differ
+    static std::vector<uint8_t> averagePrediction(const std::vector<uint8_t> &a,
+                                                  const std::vector<uint8_t> &b);
+
+    /// @brief Band position of a refresh record; false for other records
+    static bool refreshBand(const std::vector<uint8_t> &record, int &band, int &bands);
+
+    /// @brief True for records written by encodeBlocks
+    static bool isBlockRecord(const std::vector<uint8_t> &record);
+
+    /// @brief The record wrapped by a mixed or multi-reference record; empty for other records
+    static std::vector<uint8_t> mixedInnerRecord(const std::vector<uint8_t> &record);
+
+    /// @brief Short- and long-term reference counts of a multi-reference record; false for other records
+    static bool multiReferenceCounts(const std::vector<uint8_t> &record, int &shortTerm, int &longTerm);
+
+  private:
+    enum Mode : uint8_t { RAW = 0, RESIDUAL = 1, REFRESH = 2, BLOCKS = 3, MIXED = 4, MULTI = 5 };
+    enum BlockClass : uint32_t { FINE = 0, NORMAL = 1, COARSE = 2, SKIP = 3 };
+    static constexpr size_t REFRESH_HEADER_BYTES = 1 + 1 + 2 + 2 + 4 + 2;
+    static constexpr size_t BLOCK_HEADER_BYTES = 1 + 1 + 1;
+    static constexpr size_t MIXED_HEADER_BYTES = 1 + 1 + 4;
+    static constexpr size_t MULTI_HEADER_BYTES = 1 + 1 + 1 + 1 + 4;
+    static constexpr int BLOCK_SIZE = 8;
+
+    bool isPredictable(const std::vector<uint8_t> &payload, const std::vector<uint8_t> *prediction,
+                       algorithm::PayloadLayout &layout) const;
+    bool decodeRefresh(const std::vector<uint8_t> &record, const std::vector<uint8_t> *prediction,
+                       std::vector<uint8_t> &payload) const;
+    bool decodeBlocks(const std::vector<uint8_t> &record, const std::vector<uint8_t> *prediction,
+                      std::vector<uint8_t> &payload) const;
+    bool decodeMixed(const std::vector<uint8_t> &record, const std::vector<uint8_t> *prediction,
+                     const std::vector<uint8_t> *background, std::vector<uint8_t> &payload) const;
+    bool decodeMulti(const std::vector<uint8_t> &record, const std::vector<uint8_t> *background,
+                     const ReferenceList *references, std::vector<uint8_t> &payload) const;
+    bool codeMixture(const std::vector<uint8_t> &payload, const ReferenceList &references, int quantStep,
+                     bool blocks, std::vector<uint8_t> &referenceMap, std::vector<uint8_t> &inner,
+                     std::vector<uint8_t> &reconstruction) const;
+    bool decodeMixture(const std::vector<uint8_t> &record, size_t headerBytes,
+                       const ReferenceList &references, std::vector<uint8_t> &payload) const;
+    std::vector<uint8_t> selectReferences(const std::vector<uint8_t> &payload,
+                                          const ReferenceList &references,
+                                          const algorithm::PayloadLayout &layout) const;
+    static void mixReferences(const std::vector<uint8_t> &indices, const ReferenceList &references,
+                              const algorithm::PayloadLayout &layout, int blockSize,
+                              std::vector<uint8_t> &mixed);
+    static int indexBits(size_t references);
+    static int blockStep(uint32_t blockClass, int quantStep);
+    static void bandRange(const algorithm::PayloadLayout &layout, int band, int bands, size_t &begin,
+                          size_t &end);
+
+    const algorithm::BaseCompressionAlgorithm *m_algorithm;
+    utils::ThreadPool *m_pool;
+};
+
+} // namespace core
+} // namespace vcompress
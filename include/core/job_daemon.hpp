@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core/batch_runner.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace vcompress {
+namespace core {
+
+/**
+ * @brief Long-running job server on a Unix domain socket
+ *
+ * Every message in both directions is a 4-byte big-endian length followed by that many bytes of JSON.
+ * A client sends one request object per message and gets one response object back:
+ *   { "command": "submit", "job": { <manifest job fields> } }  -> { "status": "queued", "id": ... }
+ *   { "command": "status", "id": "clip1" }                     -> { "status": "ok", "jobs": [ ... ] }
+ *   { "command": "status" }                                    -> every job the daemon has seen
+ *   { "command": "shutdown" }                                  -> finishes queued jobs, then exits
+ * Each job entry carries its state (queued, running, done, failed), the frames done so far and, once
+ * finished, the job result. Jobs run on one BatchRunner for the lifetime of the daemon, so its thread
+ * pool, buffer pool and the registered algorithms stay warm between clips.
+ */
+class JobDaemon {
+  public:
+    JobDaemon();
+    ~JobDaemon();
+
+    /**
+     * @brief Bind the socket, readable and writable by the owner only
+     *  A stale socket at the path is replaced; any other kind of file is left alone and fails the call.
+     *
+     * @param socketPath Filesystem path of the Unix socket
+     * @param config Job slots, memory budget and result directory shared by all jobs
+     * @return true if the socket is listening
+     */
+    bool open(const std::string &socketPath, const BatchConfig &config);
+
+    /**
+     * @brief Queue a job as if a client had submitted it
+     *
+     * @param job The job; an empty id is replaced by a generated one
+     * @return false if a job with the same id is still queued or running
+     */
+    bool enqueue(BatchJob &job);
+
+    /**
+     * @brief Serve clients until a shutdown request, then finish the queued jobs
+     *
+     * @return true if the daemon shut down cleanly
+     */
+    bool serve();
+
+  private:
+    struct TrackedJob {
+        BatchJob job;
+        std::string state = "queued";
+        std::atomic<int> frames{0};
+        BatchResult result;
+    };
+
+    std::string m_socketPath;
+    int m_listenFd;
+    std::atomic<bool> m_stopping;
+    BatchRunner m_runner;
+
+    /// Jobs by id, and the ids waiting for admission in submission order
+    std::mutex m_mutex;
+    std::condition_variable m_queueChanged;
+    std::map<std::string, std::shared_ptr<TrackedJob>> m_jobs;
+    std::deque<std::shared_ptr<TrackedJob>> m_queue;
+    int m_nextJobNumber;
+
+    /// A connection's thread; finished ones are joined before the next accept
+    struct Client {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    std::thread m_dispatcher;
+    std::list<Client> m_clients;
+
+    void dispatch();
+    void reapClients(bool all);
+    void serveClient(int fd, Client &client);
+    std::string handleRequest(const std::string &request);
+    std::string describeJobs(const std::string &id);
+};
+
+} // namespace core
+} // namespace vcompress
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "core/encoder.hpp"
+#include "utils/file_reader.hpp"
+#include "utils/thread_pool.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vcompress {
+namespace core {
+
+/// @brief One output of a bitrate ladder
+struct LadderRung {
+    std::string algorithmName;
+    int quality = 75;
+    std::string compressedDataPath; // Empty: derived from the base path, algorithm and quality
+
+    LadderRung() = default;
+    LadderRung(const std::string &algo, int q) : algorithmName(algo), quality(q) {}
+};
+
+/// @brief Configuration for ladder encoding
+struct LadderConfig {
+    EncoderConfig base;            // Shared settings: input, GOP structure, inter coding, audio
+    std::vector<LadderRung> rungs; // Algorithm and quality of every output
+    int threads = 0;               // Worker threads encoding the rungs (0 = one per rung)
+};
+
+/**
+ * @brief Encodes one source into several outputs (a bitrate ladder) from a single decode
+ *
+ * Every source frame is decoded and wrapped once, then handed read-only to one VideoEncoder per rung;
+ * the rungs encode it in parallel on a thread pool. All rungs share the GOP structure, so key frames are
+ * aligned across the outputs and a player can switch between them at any key frame.
+ */
+class LadderEncoder {
+  public:
+    LadderEncoder();
+    ~LadderEncoder();
+
+    /**
+     * @brief Configure one encoder per rung
+     *
+     * @param config Shared settings and the list of rungs
+     * @return true if every rung was configured successfully; false as well for settings the ladder
+     *         cannot honour (live mode, GOP cache, resume, frame ranges)
+     */
+    bool configure(const LadderConfig &config);
+
+    /**
+     * @brief Decode the source once and encode all rungs
+     *
+     * @return true if encoding was successful, false otherwise
+     */
+    bool encode();
+
+    /**
+     * @brief Get the statistics of every rung
+     *
+     * @return String containing statistics
+     */
+    std::string getStats() const;
+
+    /// @brief Number of source frames decoded and handed to the rungs
+    int getFramesDecoded() const { return m_stats.framesDecoded; }
+
+    /**
+     * @brief Run the rungs on a pool shared with other work instead of a private one
+     *  Must be called before configure(); the pool must outlive the encoder.
+     */
+    void setThreadPool(utils::ThreadPool *pool) { m_pool = pool; }
+
+    /**
+     * @brief Parse a rung list "ALGO:Q,ALGO:Q,..." (a missing quality takes the default)
+     * @return false if an algorithm is not registered or a quality is not a number
+     */
+    static bool parseRungs(const std::string &spec, int defaultQuality, std::vector<LadderRung> &rungs);
+
+    /// @brief Output path of a rung: <base stem>_<algorithm>_q<quality><base extension>
+    static std::string rungPath(const std::string &basePath, const LadderRung &rung);
+
+  private:
+    LadderConfig m_config;
+    std::unique_ptr<utils::FileReader> m_fileReader;
+    std::vector<std::unique_ptr<VideoEncoder>> m_encoders;
+    std::unique_ptr<utils::ThreadPool> m_ownedPool;
+    utils::ThreadPool *m_pool;
+
+    struct {
+        int framesDecoded;
+        double totalProcessingTime;
+    } m_stats;
+};
+
+} // namespace core
+} // namespace vcompress
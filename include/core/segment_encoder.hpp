@@ -0,0 +1,82 @@
+#pragma once
+
+#include "core/encoder.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vcompress {
+namespace core {
+
+/// @brief Configuration of a distributed encode coordinated through a shared directory
+struct SegmentConfig {
+    EncoderConfig encoder;       // Input, output (compressedDataPath), coding settings and audio
+    std::string sharedDir;       // Directory on a filesystem every worker node mounts
+    int segmentGops = 10;        // Key frame intervals per segment
+    int leaseSeconds = 600;      // A claimed segment without progress for this long is handed out again
+    int localWorkers = 0;        // Worker processes the coordinator starts on its own node
+};
+
+/**
+ * @brief Coordinator of a distributed encode
+ *
+ * The input is split into segments that start at key frames and end right before one, so every segment
+ * encodes exactly the records a single encode would produce for those frames. The shared directory holds:
+ *   settings             coding settings, ROIs and the absolute input and sidecar paths, read by workers
+ *   todo/seg_NNNNN       unclaimed segments ("start end" source frames)
+ *   claimed/seg_NNNNN    segments being encoded; the worker refreshes the file time as it progresses
+ *   done/seg_NNNNN.vcomp finished segments
+ *   failed/seg_NNNNN.ID  one file per failed attempt of a worker
+ *   complete             written once the output is assembled; idle workers exit when they see it
+ * Workers claim a segment by renaming it from todo/ to claimed/, which succeeds for exactly one of them.
+ * Segments whose claim goes stale (a crashed node) or whose encode fails are moved back to todo/, up to
+ * a few times before the encode fails. Once every segment is done, the coordinator concatenates their
+ * records into the output and removes everything but the complete marker. A coordinator restarted on
+ * an unfinished plan continues it, if the plan was made with the same settings.
+ */
+class SegmentCoordinator {
+  public:
+    /**
+     * @brief Plan the segments, wait for the workers and assemble the output
+     *
+     * @return true if the output was written
+     */
+    bool run(const SegmentConfig &config);
+
+  private:
+    SegmentConfig m_config;
+    std::vector<std::string> m_segments;
+    std::map<std::string, int> m_staleClaims; // Requeues of stale claims per segment
+
+    bool planSegments();
+    bool settingsText(std::string &text) const;
+    bool writeSettings() const;
+    int requeueStaleClaims();
+    std::string exhaustedSegment() const;
+    bool concatenateSegments() const;
+    void removePlan() const;
+};
+
+/**
+ * @brief Worker of a distributed encode: claims and encodes segments until the encode is complete
+ */
+class SegmentWorker {
+  public:
+    /**
+     * @brief Work on the encode in `sharedDir`
+     *
+     * @return false if the settings are missing or a segment failed to encode (it is handed out again)
+     */
+    bool run(const std::string &sharedDir);
+
+  private:
+    std::string m_sharedDir;
+    EncoderConfig m_encoder;
+
+    bool readSettings();
+    bool claimSegment(std::string &name);
+    bool encodeSegment(const std::string &name);
+};
+
+} // namespace core
+} // namespace vcompress
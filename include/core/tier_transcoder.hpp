@@ -0,0 +1,98 @@
+#pragma once
+
+#include "algorithms/base_algorithm.hpp"
+#include "core/inter_coder.hpp"
+#include "utils/reference_buffer.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vcompress {
+namespace core {
+
+/// @brief Configuration for moving a compressed file to a lower storage tier
+struct RetierConfig {
+    std::string inputPath;     // Compressed input (.vcomp)
+    std::string outputPath;    // Compressed output at the new factor
+    std::string algorithmName; // Algorithm the input was encoded with
+    int targetFactor = 4;      // Downsample factor of the output payloads (0 = keep the payloads)
+};
+
+/**
+ * @brief Rewrites a compressed file at a coarser downsample factor in the payload domain
+ *
+ * Every record is brought back to its stored payload (inter records are decoded against the input's own
+ * references), the payload's sample plane is resampled to the target factor, and the result is coded
+ * again with the record's type, timestamp and quantizer step. Inter records of the output are predicted
+ * from the output's own reconstructions, so there is no drift. Background records are rewritten the same
+ * way and advance the background references instead of the anchors, and multi-reference records choose
+ * their blocks again from as many of the output's last anchors as the input record used. Interpolated
+ * records only hold motion fields in full-resolution pixels and film grain records only parameters; both
+ * are copied unchanged.
+ * No frame is ever upsampled to full resolution, so the work is proportional to the stored samples rather
+ * than the original pixels.
+ *
+ * Enhancement layers are always dropped: they refine the input's base layer, not the resampled one. With a
+ * target factor of 0 the base records are copied as they are, which strips the enhancement layers only.
+ */
+class TierTranscoder {
+  public:
+    TierTranscoder();
+    ~TierTranscoder();
+
+    /**
+     * @brief Configure the transcoder
+     *
+     * @param config Input, output, algorithm and target factor
+     * @return true if the algorithm exists and can resample its payloads
+     */
+    bool configure(const RetierConfig &config);
+
+    /**
+     * @brief Rewrite the input into the output
+     *
+     * @return true if every record was rewritten
+     */
+    bool run();
+
+    /**
+     * @brief Get transcoding statistics
+     *
+     * @return String containing statistics
+     */
+    std::string getStats() const;
+
+  private:
+    RetierConfig m_config;
+    std::unique_ptr<algorithm::BaseCompressionAlgorithm> m_algorithm;
+    std::unique_ptr<InterFrameCoder> m_interCoder;
+
+    struct {
+        int recordsResampled;
+        int recordsCopied;
+        int recordsSkipped;
+        int layersDropped;
+        int64_t inputBytes;
+        int64_t outputBytes;
+        double totalProcessingTime;
+    } m_stats;
+
+    bool recode(uint8_t frameType, const std::vector<uint8_t> &record, std::vector<uint8_t> &output);
+    bool recodeBackground(const std::vector<uint8_t> &record, std::vector<uint8_t> &output);
+    std::vector<uint8_t> encodeLike(const std::vector<uint8_t> &record, const std::vector<uint8_t> &payload,
+                                    const std::vector<uint8_t> *prediction,
+                                    const std::vector<uint8_t> *background,
+                                    std::vector<uint8_t> &reconstruction) const;
+    static int quantStepOf(const std::vector<uint8_t> &record);
+
+    /// Reconstructed payloads of the last two anchors and the background reference, on the input and on
+    /// the output side
+    std::vector<uint8_t> m_inputPast, m_inputFuture, m_inputBackground;
+    std::vector<uint8_t> m_outputPast, m_outputFuture, m_outputBackground;
+    /// The last anchors of the GOP, indexed by multi-reference records, on the input and on the output side
+    utils::ReferenceBuffer m_inputReferences, m_outputReferences;
+};
+
+} // namespace core
+} // namespace vcompress
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/batch_runner.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace vcompress {
+namespace core {
+
+/// @brief Configuration of a watched ingest directory
+struct WatchConfig {
+    std::string directory;  // Directory the capture boxes write into
+    std::string outputDir;  // Receives <name>.vcomp, <name>.aac and <name>.json per file (extension kept)
+    std::string statePath;  // Finished files (default: <outputDir>/.vcompress_watch_state)
+    bool keepAudio = true;  // Extract each file's audio next to its .vcomp
+    BatchJob jobTemplate;   // Encoding settings applied to every file; paths and id are filled in
+    BatchConfig batch;      // Concurrency and memory limits
+};
+
+/**
+ * @brief Encodes video files as they are completed in a directory
+ *
+ * Files are picked up by inotify when their writer closes them (IN_CLOSE_WRITE) or when they are renamed
+ * into the directory (IN_MOVED_TO), so only complete files are encoded and there is no polling latency.
+ * Files already present at startup are picked up once they have not been modified for a few seconds; the
+ * ones still too recent are checked again every second until they are. Outputs are named after the whole
+ * file name, so a.mp4 and a.mov do not overwrite each other's results.
+ * Encodes run concurrently on a BatchRunner within its limits. Every finished file is appended to the
+ * state file with its size and modification time, so after a restart only new or rewritten files are
+ * encoded again.
+ */
+class WatchFolder {
+  public:
+    WatchFolder();
+    ~WatchFolder();
+
+    /**
+     * @brief Configure the watcher and load the state of a previous run
+     *
+     * @return true if the directories exist and the state file is readable
+     */
+    bool configure(const WatchConfig &config);
+
+    /**
+     * @brief Watch until requestStop(), then wait for the running encodes
+     *
+     * @return true if the watch ended without an inotify error
+     */
+    bool run();
+
+    /// @brief Ask run() to return; async-signal-safe
+    static void requestStop();
+
+  private:
+    WatchConfig m_config;
+    BatchRunner m_runner;
+
+    /// File name -> "<size> <mtime>" of the version that was encoded
+    std::mutex m_mutex;
+    std::map<std::string, std::string> m_finished;
+    std::set<std::string> m_inFlight;
+    /// Files skipped as too recently modified, checked again until they settle (run thread only)
+    std::set<std::string> m_unsettled;
+
+    static std::atomic<bool> s_stopRequested;
+
+    bool loadState();
+    void recordFinished(const std::string &name, const std::string &signature);
+    void scanDirectory();
+    void checkUnsettled();
+    void considerFile(const std::string &name, bool requireSettled);
+};
+
+} // namespace core
+} // namespace vcompress
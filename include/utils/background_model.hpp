@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Long-term background of a sample plane, kept as the value each sample settles on
+ *
+ * A mode-like estimate: every sample counts the updates for which it stayed within a few levels of its
+ * previous value, and only once it has been still for SETTLE_UPDATES in a row does the background move
+ * towards it (a quarter of the difference per update, with 8 fractional bits, which also averages out
+ * noise). A person walking past never keeps a sample still for long, so the background behind them is
+ * kept, while something that stops (a parked car) is taken over within a second or so. The kernel is
+ * branch-free integer arithmetic over contiguous samples, so the compiler vectorizes it.
+ */
+class BackgroundModel {
+  public:
+    /**
+     * @brief Update the model with a plane
+     *  The first plane, or a plane of another size, restarts the model from it.
+     */
+    void update(const uint8_t *samples, size_t count);
+
+    /// @brief Write the background rounded to 8 bits, size() samples
+    void read(uint8_t *samples) const;
+
+    /// @brief Mean absolute difference between the background and size() samples, in levels
+    double distance(const uint8_t *samples) const;
+
+    size_t size() const { return m_background.size(); }
+    void reset();
+
+  private:
+    static constexpr int FRACTION_BITS = 8;
+    static constexpr int STILL_LEVELS = 4;    // Largest change between updates that counts as still
+    static constexpr int SETTLE_UPDATES = 16; // Still updates in a row before the background follows
+    std::vector<uint16_t> m_background;
+    std::vector<uint8_t> m_last;
+    std::vector<uint8_t> m_still;
+};
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/// Supported reduced sample depths; 8 means no reduction
+static constexpr int MIN_BIT_DEPTH = 5;
+static constexpr int MAX_BIT_DEPTH = 8;
+
+/**
+ * @brief Bytes of `count` samples packed at `bits` per sample
+ *  Samples are packed in groups of eight, each group taking `bits` bytes, so the last group is zero padded.
+ */
+size_t packedSize(size_t count, int bits);
+
+/**
+ * @brief Quantize an interleaved plane to `bits` (5-7) per sample and bit-pack it
+ *  The quantizer rounds against a 4x4 ordered (Bayer) dither, shared by the channels of a pixel: gradients
+ *  turn into a fine fixed pattern instead of bands, and unchanged content quantizes identically from frame
+ *  to frame (error diffusion would make it flicker). Group k of eight samples is stored little-endian as
+ *  sample 0 in the lowest bits.
+ *
+ * @param packed Output buffer of packedSize(width * height * channels, bits) bytes
+ */
+void packBitDepth(const uint8_t *plane, int width, int height, int channels, int bits, uint8_t *packed);
+
+/**
+ * @brief Unpack `count` samples written by packBitDepth, expanding them back to 8 bits with a lookup table
+ */
+void unpackBitDepth(const uint8_t *packed, size_t count, int bits, uint8_t *plane);
+
+/**
+ * @brief Replace the 8-bit plane that follows the first `header_bytes` of a payload by its packed form:
+ *  | header | depth (1) | plane packed at `bits` |
+ *  The header is kept as is; flagging it as packed is up to the payload format.
+ */
+void packPayloadPlane(std::vector<uint8_t> &payload, size_t header_bytes, int width, int height, int channels,
+                      int bits);
+
+} // namespace utils
+} // namespace vcompress
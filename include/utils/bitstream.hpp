@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief MSB-first bit writer appending to a byte vector
+ *
+ * Supports fixed-width fields and Exp-Golomb codes (ue/se), which are used for the entropy coding of
+ * residuals and other small integers in frame payloads.
+ */
+class BitWriter {
+  public:
+    explicit BitWriter(std::vector<uint8_t> &out) : m_out(out), m_accumulator(0), m_bits(0) {}
+    ~BitWriter() { flush(); }
+
+    /**
+     * @brief Write the lowest `count` bits of `value` (count <= 32)
+     */
+    void putBits(uint32_t value, int count) {
+        uint32_t mask = count == 32 ? 0xFFFFFFFFu : ((1u << count) - 1);
+        m_accumulator = (m_accumulator << count) | (value & mask);
+        m_bits += count;
+        while (m_bits >= 8) {
+            m_bits -= 8;
+            m_out.push_back(static_cast<uint8_t>(m_accumulator >> m_bits));
+        }
+    }
+
+    /**
+     * @brief Unsigned Exp-Golomb code: N leading zeros, then value + 1 in N + 1 bits (value < 2^31)
+     */
+    void putUE(uint32_t value) {
+        uint64_t coded = static_cast<uint64_t>(value) + 1;
+        int length = 0;
+        while ((coded >> (length + 1)) != 0) length++;
+        if (length > 0) putBits(0, length);
+        putBits(static_cast<uint32_t>(coded), length + 1);
+    }
+
+    /**
+     * @brief Signed Exp-Golomb code: 0, 1, -1, 2, -2, ... map to 0, 1, 2, 3, 4, ...
+     */
+    void putSE(int32_t value) {
+        putUE(value > 0 ? static_cast<uint32_t>(value) * 2 - 1
+                        : static_cast<uint32_t>(-static_cast<int64_t>(value)) * 2);
+    }
+
+    /**
+     * @brief Pad the last partial byte with zero bits
+     */
+    void flush() {
+        if (m_bits > 0) {
+            m_out.push_back(static_cast<uint8_t>(m_accumulator << (8 - m_bits)));
+            m_bits = 0;
+        }
+        m_accumulator = 0;
+    }
+
+  private:
+    std::vector<uint8_t> &m_out;
+    uint64_t m_accumulator;
+    int m_bits;
+};
+
+/**
+ * @brief MSB-first bit reader over a byte buffer; reads past the end fail instead of overrunning
+ */
+class BitReader {
+  public:
+    BitReader(const uint8_t *data, size_t size)
+        : m_data(data), m_size(size), m_position(0), m_accumulator(0), m_bits(0) {}
+
+    /**
+     * @brief Read `count` bits (count <= 32) into `value`
+     * @return false if the buffer is exhausted
+     */
+    bool getBits(int count, uint32_t &value) {
+        while (m_bits < count) {
+            if (m_position >= m_size) return false;
+            m_accumulator = (m_accumulator << 8) | m_data[m_position++];
+            m_bits += 8;
+        }
+        m_bits -= count;
+        uint64_t mask = (1ull << count) - 1;
+        value = static_cast<uint32_t>((m_accumulator >> m_bits) & mask);
+        return true;
+    }
+
+    bool getUE(uint32_t &value) {
+        int length = 0;
+        uint32_t bit = 0;
+        while (true) {
+            if (!getBits(1, bit)) return false;
+            if (bit) break;
+            if (++length > 31) return false;
+        }
+        uint32_t rest = 0;
+        if (length > 0 && !getBits(length, rest)) return false;
+        value = static_cast<uint32_t>(((1ull << length) | rest) - 1);
+        return true;
+    }
+
+    bool getSE(int32_t &value) {
+        uint32_t coded;
+        if (!getUE(coded)) return false;
+        value = (coded & 1) ? static_cast<int32_t>((coded + 1) / 2) : -static_cast<int32_t>(coded / 2);
+        return true;
+    }
+
+    /**
+     * @brief Byte offset just past the data consumed so far (partial bytes count as consumed)
+     */
+    size_t bytesConsumed() const { return m_position; }
+
+  private:
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_position;
+    uint64_t m_accumulator;
+    int m_bits;
+};
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Thread-safe cache of byte buffers, shared by concurrent encoders
+ *
+ * Frame buffers are large and all of the same few sizes, so recycling them saves an allocation and the
+ * page faults of touching fresh memory for every frame. Buffers beyond the cache limit are freed.
+ */
+class BufferPool {
+  public:
+    /**
+     * @param maxCachedBytes Upper bound of the memory kept in released buffers
+     */
+    explicit BufferPool(size_t maxCachedBytes = 256u << 20);
+
+    /// @brief A buffer of `size` bytes (contents unspecified), reusing a cached one when it fits
+    std::vector<uint8_t> acquire(size_t size);
+
+    /// @brief Return a buffer to the cache
+    void release(std::vector<uint8_t> &&buffer);
+
+    /// @brief Bytes currently held in released buffers
+    size_t cachedBytes() const;
+
+  private:
+    mutable std::mutex m_mutex;
+    std::vector<std::vector<uint8_t>> m_free;
+    size_t m_cachedBytes;
+    size_t m_maxCachedBytes;
+};
+
+} // namespace utils
+} // namespace vcompress
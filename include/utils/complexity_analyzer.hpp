@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Luma plane of a BGR frame sampled every `step` pixels in both directions
+ *
+ * @param bgr Interleaved 8-bit BGR pixels (OpenCV channel order)
+ * @param width,height Frame dimensions in pixels
+ * @param step Decimation step (>= 1)
+ * @param luma_width,luma_height Receive the dimensions of the returned plane
+ */
+std::vector<uint8_t> decimatedLuma(const uint8_t *bgr, int width, int height, int step, int &luma_width,
+                                   int &luma_height);
+
+/**
+ * @brief Cheap spatial complexity measure of a BGR frame
+ *  Computes the mean absolute horizontal + vertical luma gradient on a grid decimated by `step` in both
+ *  directions, so the cost is roughly (width * height) / step^2 pixel reads.
+ *
+ * @param bgr Interleaved 8-bit BGR pixels (OpenCV channel order)
+ * @param width,height Frame dimensions in pixels
+ * @param step Decimation step of the luma grid (>= 1)
+ * @return Mean gradient energy per decimated sample (0 for flat frames, up to ~510)
+ */
+double gradientEnergy(const uint8_t *bgr, int width, int height, int step = 4);
+
+/**
+ * @brief Pick a downsample factor for a group of pictures from its gradient energy
+ *  Detailed content moves one step below the quality derived factor, flat content one step above it;
+ *  the result is clamped to [min_factor, max_factor].
+ *
+ * @param energy Gradient energy of the GOP's key frame (see gradientEnergy)
+ * @param base_factor The factor derived from the quality setting
+ */
+int selectDownsampleFactor(double energy, int base_factor, int min_factor = 2, int max_factor = 4);
+
+} // namespace utils
+} // namespace vcompress
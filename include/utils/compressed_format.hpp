@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -19,10 +23,20 @@ namespace utils {
  *   - FPS (4 bytes, float)
  *   - Algorithm ID (2 bytes)
  *
- * - For each frame:
- *   - Frame type (1 byte) - 0: Key frame, 1: Delta frame
+ * - For each frame, in decode order:
+ *   - Frame type (1 byte) - 0: Key frame, 1: Delta frame, 2: Interpolated frame (motion fields only),
+ *                           3: Predicted frame, 4: Bidirectional frame (inter records),
+ *                           5: Enhancement layer (residual for the base record that follows it),
+ *                           6: Film grain (grain parameters of the GOP that follows),
+ *                           7: Background (long-term reference of the predicted frames that follow)
+ *   - Display timestamp (4 bytes, frame number in display order)
  *   - Frame size (4 bytes)
  *   - Compressed frame data (variable size)
+ *
+ * Reference management of predicted frames: every key and predicted frame enters a sliding window of the
+ * last four anchors, which a key frame empties first, and a background record replaces the long-term
+ * reference, which a key frame drops. Multi-reference records state how many of the window's newest
+ * anchors they index and whether they index the long-term reference, so no further marking is stored.
  */
 class CompressedFormat {
   public:
@@ -71,6 +85,40 @@ class CompressedFormat {
         return !m_file.fail();
     }
 
+    /**
+     * @brief Reopens a partially written file to continue writing at `offset`
+     *  Everything after `offset` (records of an interrupted encode) is cut off.
+     *
+     * @param filename File written by openForWriting
+     * @param offset Byte offset of the first record to rewrite, as reported by getWritePosition
+     * @return true if the header is intact and the file is at least `offset` bytes long
+     */
+    bool openForResuming(const std::string &filename, int64_t offset) {
+        close();
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(filename, error);
+        if (error || offset < HEADER_BYTES || size < static_cast<uintmax_t>(offset)) return false;
+        std::filesystem::resize_file(filename, offset, error);
+        if (error) return false;
+
+        if (!openForReading(filename)) return false;
+        m_file.close();
+        m_isWriteMode = true;
+        m_file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+        if (!m_file.is_open()) return false;
+        m_isOpen = true;
+        m_file.seekp(offset);
+        return !m_file.fail();
+    }
+
+    /**
+     * @brief Byte offset at which the next record will be written (-1 if not writing)
+     */
+    int64_t getWritePosition() {
+        if (!m_file.is_open() || !m_isWriteMode) return -1;
+        return static_cast<int64_t>(m_file.tellp());
+    }
+
     /**
      * @brief Opens a file for reading compressed data
      *
@@ -111,18 +159,20 @@ class CompressedFormat {
      * @brief Writes a compressed frame to the file
      *
      * @param frameData Compressed frame data
+     * @param frameType Frame type byte (algorithm::FrameType)
+     * @param timestamp Display timestamp of the frame
      * @return true if frame was written successfully
      */
-    bool writeFrame(const std::vector<uint8_t> &frameData, bool isKeyFrame) {
+    bool writeFrame(const std::vector<uint8_t> &frameData, uint8_t frameType, int32_t timestamp) {
         if (!m_file.is_open() || !m_isWriteMode) return false;
 
-        uint8_t frameType = isKeyFrame ? 0 : 1;
         uint32_t frameSize = static_cast<uint32_t>(frameData.size());
 
-        std::vector<std::byte> batchBuffer(1 + 4 + frameData.size());
-        auto [typeOffset, sizeOffset, dataOffset] = std::make_tuple(0, 1, 5);
+        std::vector<std::byte> batchBuffer(1 + 4 + 4 + frameData.size());
+        auto [typeOffset, timestampOffset, sizeOffset, dataOffset] = std::make_tuple(0, 1, 5, 9);
 
         std::memcpy(batchBuffer.data() + typeOffset, &frameType, sizeof(frameType));
+        std::memcpy(batchBuffer.data() + timestampOffset, &timestamp, sizeof(timestamp));
         std::memcpy(batchBuffer.data() + sizeOffset, &frameSize, sizeof(frameSize));
         std::memcpy(batchBuffer.data() + dataOffset, frameData.data(), frameData.size());
         m_file.write(reinterpret_cast<const char *>(batchBuffer.data()), batchBuffer.size());
@@ -134,27 +184,36 @@ class CompressedFormat {
      * @brief Reads the next compressed frame from the file
      *
      * @param frameData Vector to store the compressed frame data
+     * @param frameType Receives the frame type byte (algorithm::FrameType)
+     * @param timestamp Receives the display timestamp of the frame
      * @return true if a frame was successfully read
      */
-    bool readFrame(std::vector<uint8_t> &frameData, bool &isKeyFrame) {
+    bool readFrame(std::vector<uint8_t> &frameData, uint8_t &frameType, int32_t &timestamp) {
         if (!m_file.is_open() || m_isWriteMode) return false;
 
-        constexpr long HEADER_SIZE = 5;
+        constexpr long HEADER_SIZE = 9;
         std::array<std::byte, HEADER_SIZE> header;
         m_file.read(reinterpret_cast<char *>(header.data()), header.size());
         if (m_file.eof() && m_file.gcount() == 0) return false;
         if (m_file.gcount() < HEADER_SIZE || m_file.fail()) return false;
 
-        uint8_t frameType = std::to_integer<uint8_t>(header[0]);
-        isKeyFrame = (frameType == 0);
+        frameType = std::to_integer<uint8_t>(header[0]);
+        std::memcpy(&timestamp, &header[1], sizeof(timestamp));
         uint32_t frameSize;
-        std::memcpy(&frameSize, &header[1], sizeof(frameSize));
+        std::memcpy(&frameSize, &header[5], sizeof(frameSize));
         frameData.resize(frameSize);
         m_file.read(reinterpret_cast<char *>(frameData.data()), frameSize);
 
         return !m_file.fail();
     }
 
+    /**
+     * @brief Pushes buffered records to the file, so a live reader sees every frame as soon as it is written
+     */
+    void flush() {
+        if (m_file.is_open()) m_file.flush();
+    }
+
     /**
      * @brief Closes the file
      */
@@ -189,6 +248,8 @@ class CompressedFormat {
     bool isOpen() const { return m_file.is_open(); }
 
   private:
+    static constexpr int64_t HEADER_BYTES = 4 + 4 + 4 + 2;
+
     std::fstream m_file;
     bool m_isOpen;
     bool m_isWriteMode;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Fast, deterministic 128-bit content hash for cache keys
+ *
+ * Two 64-bit lanes with different multipliers mix every 8-byte word, and a Murmur3 finalizer spreads
+ * them once all data is in. Not cryptographic: it identifies content, it does not authenticate it.
+ */
+class ContentHash {
+  public:
+    ContentHash() : m_lanes{0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full}, m_length(0) {}
+
+    void update(const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        m_length += size;
+        for (; size >= 8; bytes += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes, 8);
+            mix(word);
+        }
+        if (size > 0) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes, size);
+            mix(word ^ (static_cast<uint64_t>(size) << 56));
+        }
+    }
+
+    void update(const std::string &text) { update(text.data(), text.size()); }
+
+    void update(int64_t value) { update(&value, sizeof(value)); }
+
+    /// @brief The hash as 32 lowercase hex digits
+    std::string hex() const {
+        uint64_t first = finalize(m_lanes[0] ^ m_length);
+        uint64_t second = finalize(m_lanes[1] + first);
+        static const char DIGITS[] = "0123456789abcdef";
+        std::string text(32, '0');
+        for (int i = 0; i < 16; i++) {
+            text[15 - i] = DIGITS[(first >> (4 * i)) & 15];
+            text[31 - i] = DIGITS[(second >> (4 * i)) & 15];
+        }
+        return text;
+    }
+
+  private:
+    uint64_t m_lanes[2];
+    uint64_t m_length;
+
+    static uint64_t rotateLeft(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+    void mix(uint64_t word) {
+        m_lanes[0] = rotateLeft(m_lanes[0] ^ (word * 0x87C37B91114253D5ull), 31) * 0x4CF5AD432745937Full;
+        m_lanes[1] = rotateLeft(m_lanes[1] + (word * 0x52DCE729DA3ED5C1ull), 27) * 0x9E3779B97F4A7C15ull +
+                     m_lanes[0];
+    }
+
+    static uint64_t finalize(uint64_t value) {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+};
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "utils/thread_pool.hpp"
+#include <cstdint>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief In-loop deblocking of a sample plane whose blocks were quantized with their own steps
+ *
+ * Every edge between two blocks is smoothed with the H.264 normal filter: where the jump across the edge is
+ * below alpha and both sides are flat (below beta), p0 and q0 move towards each other by at most tc. The
+ * thresholds grow with the larger quantizer step of the two blocks, so quantization steps are removed while
+ * real image edges, which are larger than the quantization error, stay intact. Edges between two lossless
+ * blocks (step 1) are never touched.
+ *
+ * Vertical edges are filtered first, then horizontal edges. An edge segment reads p1..q1 and writes p0 and
+ * q0 only, so with blocks of at least 4 samples all segments of a pass are independent: each pass runs in
+ * horizontal stripes on the pool, with the same result as a serial run.
+ *
+ * @param plane Interleaved samples, width * height * channels
+ * @param blockSize Block size in pixels (>= 4)
+ * @param blockSteps Quantizer step per block, raster order, ceil(width / blockSize) per block row
+ * @param pool Pool for the stripes, or nullptr to filter on the calling thread
+ */
+void deblockPlane(uint8_t *plane, int width, int height, int channels, int blockSize,
+                  const uint8_t *blockSteps, ThreadPool *pool);
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Serialize an enhancement layer record:
+ *  | width (4) | height (4) | quant step (1) | residual stream |
+ *  The residual between the source frame and the decoded base layer is quantized with `quantStep` and
+ *  entropy coded with encodeResidual. Applying the record to the decoded base gives the enhanced frame.
+ *
+ * @param source The source frame (BGR, width * height * 3)
+ * @param base The decoded base layer of the same frame, as a decoder of the base records reconstructs it
+ * @param quantStep Quantizer step (1-255); step 1 restores the source exactly
+ */
+std::vector<uint8_t> packEnhancementLayer(const uint8_t *source, const uint8_t *base, int width, int height,
+                                          int quantStep);
+
+/**
+ * @brief Add the residual of a record written by packEnhancementLayer to a decoded base frame, in place
+ * @return false (frame untouched) if the record is truncated or was coded for other dimensions
+ */
+bool applyEnhancementLayer(const std::vector<uint8_t> &data, uint8_t *frame, int width, int height);
+
+} // namespace utils
+} // namespace vcompress
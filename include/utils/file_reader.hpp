@@ -1,6 +1,7 @@
 #pragma once
 
 #include "algorithms/base_algorithm.hpp"
+#include <fstream>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <thread>
@@ -13,6 +14,10 @@ namespace utils {
  *
  * This class encapsulates video file reading operations using OpenCV.
  * It provides a consistent interface for accessing video frames.
+ *
+ * With a frame cache directory, the first complete read of a source also stores its decoded frames in an
+ * uncompressed cache file keyed by the source path, size and modification time. Later opens of the same
+ * source map that file and return frames straight from the mapping, without running the video decoder.
  */
 class FileReader {
   public:
@@ -26,6 +31,12 @@ class FileReader {
      */
     ~FileReader();
 
+    /**
+     * @brief Serve and fill decoded frames from a cache directory (empty = off)
+     *  Must be set before openFile. Cache files hold raw BGR frames and are as large as the decoded video.
+     */
+    void setFrameCacheDir(const std::string &cacheDir) { m_frameCacheDir = cacheDir; }
+
     /**
      * @brief Open a video file for reading
      *
@@ -58,6 +69,14 @@ class FileReader {
      */
     bool readNextFrame(algorithm::Frame &frame, int frameNumber);
 
+    /**
+     * @brief Position the reader so the next frame read is `frameNumber`
+     *  Uses the container index when the backend seeks exactly, otherwise decodes forward from the start.
+     *
+     * @return false if the video has fewer frames
+     */
+    bool seekToFrame(int frameNumber);
+
     /**
      * @brief Get the width of the video
      *
@@ -105,6 +124,19 @@ class FileReader {
 
   private:
     cv::VideoCapture m_videoCapture;
+    std::string m_frameCacheDir;
+
+    /// Serving from a cache file: the mapping and the next frame index
+    uint8_t *m_cacheMapping;
+    size_t m_cacheMappingSize;
+    int m_cacheFrameIndex;
+
+    /// Filling a cache file while decoding; published under the final name once the source is exhausted
+    std::ofstream m_cacheWriter;
+    std::string m_cachePath;
+    std::string m_cachePartialPath;
+    int m_cacheFramesWritten;
+
     bool m_isOpen;
     int m_width;
     int m_height;
@@ -118,6 +150,14 @@ class FileReader {
      * Called after a file is opened to cache video metadata
      */
     void updateVideoProperties();
+
+    std::string cachePathFor(const std::string &filename) const;
+    bool openCachedFrames(const std::string &cachePath);
+    void beginCacheFill(const std::string &cachePath);
+    void appendCachedFrame(const cv::Mat &frame);
+    void finishCacheFill();
+    void abandonCacheFill();
+    void closeCachedFrames();
 };
 
 } // namespace utils
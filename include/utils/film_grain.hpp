@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Parametric description of film grain, estimated per GOP and sent as a side record
+ *  The grain is modeled as luma noise whose strength depends on the brightness of the pixel, with a
+ *  single correlation coefficient describing its spectrum (0 = fine white grain, 1 = coarse grain).
+ */
+struct FilmGrainParams {
+    static constexpr int LUMA_BANDS = 8; // Bands of 32 luma levels each
+    uint8_t sigma[LUMA_BANDS] = {};      // Grain standard deviation per band, in quarter sample units
+    uint8_t correlation = 0;             // Grain smoothing, 0 (white) to 255 (coarse)
+    uint16_t seed = 0;                   // Seed of the synthesized noise
+
+    /// @brief Mean grain standard deviation over the bands, in sample units
+    double meanSigma() const;
+};
+
+/**
+ * @brief Estimate the grain of a BGR frame
+ *  The luma high-pass (pixel minus its 3x3 mean) is measured in 16x16 blocks. Per luma band the quietest
+ *  quarter of the blocks is taken as grain only (textured blocks are louder), and the lag-1 correlation of
+ *  the high-pass in those blocks gives the grain spectrum. Bands without flat blocks borrow from the
+ *  nearest band that has some.
+ */
+FilmGrainParams estimateFilmGrain(const uint8_t *bgr, int width, int height, uint16_t seed);
+
+/**
+ * @brief Serialize grain parameters: | bands (1) | sigma per band | correlation (1) | seed (2) |
+ */
+std::vector<uint8_t> packFilmGrain(const FilmGrainParams &params);
+
+/**
+ * @brief Parse a record written by packFilmGrain
+ * @return false if the record is truncated or has another band count
+ */
+bool unpackFilmGrain(const std::vector<uint8_t> &data, FilmGrainParams &params);
+
+/**
+ * @brief Procedural grain generator for decoded frames
+ *
+ * White noise comes from a counter-based hash of (seed, frame, sample index), so every sample is computed
+ * independently and the loops vectorize; it is shaped by blending in a [1 2 1] x [1 2 1] smoothed copy
+ * according to the correlation, normalized to unit variance, and scaled by the sigma of the band of each
+ * pixel. The same grain is added to the three channels. Scratch buffers are kept between frames.
+ */
+class FilmGrainSynthesizer {
+  public:
+    /**
+     * @brief Add grain to a frame in place
+     *
+     * @param params Grain of the frame's GOP
+     * @param frameIndex Display index of the frame; it varies the pattern from frame to frame
+     * @param bgr Interleaved BGR pixels (width * height * 3)
+     */
+    void apply(const FilmGrainParams &params, int frameIndex, uint8_t *bgr, int width, int height);
+
+  private:
+    std::vector<int16_t> m_white;
+    std::vector<int16_t> m_rows;
+    std::vector<int16_t> m_grain;
+};
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Block motion field at full frame resolution
+ *  One (dx, dy) vector per block in raster order; the block at (bx, by) of the target frame is best
+ *  matched by the reference block displaced by the vector.
+ */
+struct MotionField {
+    int blockSize = 16;
+    int blocksX = 0;
+    int blocksY = 0;
+    std::vector<int8_t> vectors; // dx, dy interleaved, in full-resolution pixels
+};
+
+/**
+ * @brief Estimate a block motion field with a three-step search on the half-resolution luma planes
+ *
+ * @param target The frame to predict (BGR)
+ * @param reference The frame to predict from (BGR)
+ * @param width,height Frame dimensions in pixels
+ * @param blockSize Block size in full-resolution pixels (even)
+ * @return The motion field; vectors are limited to about +-14 pixels
+ */
+MotionField estimateMotion(const uint8_t *target, const uint8_t *reference, int width, int height,
+                           int blockSize = 16);
+
+/**
+ * @brief Motion-compensated interpolation of a frame between two anchors
+ *  The block vectors are bilinearly interpolated into a smooth per-pixel field, both anchors are warped
+ *  with bilinear sampling and the warps are blended by the temporal position of the frame.
+ *
+ * @param previous,next The anchor frames before and after the interpolated frame (BGR)
+ * @param forward Field of the frame relative to `previous`
+ * @param backward Field of the frame relative to `next`
+ * @param position Temporal position between the anchors (0 = previous, 1 = next)
+ * @param dst Output frame buffer (width * height * 3)
+ */
+void interpolateFrame(const uint8_t *previous, const uint8_t *next, const MotionField &forward,
+                      const MotionField &backward, float position, uint8_t *dst, int width, int height);
+
+/**
+ * @brief Serialize an interpolated frame record:
+ *  | width (4) | height (4) | block size (1) | position (1) | span (1) | forward vectors | backward vectors |
+ *  The frame sits `position` frames after the previous anchor, with `span` frames between the anchors.
+ */
+std::vector<uint8_t> packInterpolatedFrame(int width, int height, int position, int span,
+                                           const MotionField &forward, const MotionField &backward);
+
+/**
+ * @brief Parse a record written by packInterpolatedFrame
+ * @return false if the record is truncated
+ */
+bool unpackInterpolatedFrame(const std::vector<uint8_t> &data, int &width, int &height, int &position,
+                             int &span, MotionField &forward, MotionField &backward);
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Sliding window of the most recent reconstructed anchor payloads, the short-term references
+ *
+ * The window holds at most `capacity` payloads in slots that are allocated once and then recycled: a
+ * new reference overwrites the slot of the oldest one, reusing its storage, so the memory stays bounded
+ * at capacity payloads and no allocation happens once every slot has been filled. Encoder and decoder
+ * push the same anchors and clear the window at the same key frames, so index k names the same payload
+ * on both sides.
+ */
+class ReferenceBuffer {
+  public:
+    /// Largest window; per-block reference indices of multi-reference records stay within a few bits
+    static constexpr int MAX_FRAMES = 4;
+
+    explicit ReferenceBuffer(int capacity = MAX_FRAMES);
+
+    /// @brief Resize the window to 1..MAX_FRAMES slots; drops the references held
+    void setCapacity(int capacity);
+    int capacity() const { return static_cast<int>(m_slots.size()); }
+
+    /// @brief Number of references held, at most capacity()
+    int size() const { return m_count; }
+
+    /// @brief Drop every reference (key frames); the slots keep their storage
+    void clear() { m_count = 0; }
+
+    /// @brief Copy an anchor's reconstruction in as the newest reference, replacing the oldest when full
+    void push(const std::vector<uint8_t> &reconstruction);
+
+    /// @brief Reference `index` back from the newest (0 = the last anchor); index < size()
+    const std::vector<uint8_t> &at(int index) const;
+
+    /// @brief The newest min(count, size()) references, newest first
+    std::vector<const std::vector<uint8_t> *> window(int count) const;
+
+  private:
+    std::vector<std::vector<uint8_t>> m_slots;
+    int m_newest;
+    int m_count;
+};
+
+} // namespace utils
+} // namespace vcompress
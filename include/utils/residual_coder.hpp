@@ -0,0 +1,37 @@
+#pragma once
+
+#include "utils/bitstream.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Quantizer step for inter-frame residuals at a quality setting (1-100); step 1 is lossless
+ */
+int residualQuantStep(int quality);
+
+/**
+ * @brief Quantize and entropy code the residual between two sample buffers
+ *  Residuals are quantized with rounding, then written as (zero run, level) pairs with Exp-Golomb codes;
+ *  a final zero run closes the buffer. The decoder's output (prediction + dequantized residual, clamped to
+ *  8 bits) is written to `reconstruction` so the encoder can predict from exactly the same samples.
+ *
+ * @param writer Bit writer receiving the coded residual
+ * @param target,prediction Sample buffers of `count` bytes
+ * @param quantStep Quantizer step (>= 1)
+ * @param reconstruction Output buffer of `count` bytes (may alias neither input)
+ */
+void encodeResidual(BitWriter &writer, const uint8_t *target, const uint8_t *prediction, size_t count,
+                    int quantStep, uint8_t *reconstruction);
+
+/**
+ * @brief Decode a residual written by encodeResidual and add it to the prediction
+ * @return false if the stream is truncated or inconsistent with `count`
+ */
+bool decodeResidual(BitReader &reader, const uint8_t *prediction, size_t count, int quantStep,
+                    uint8_t *reconstruction);
+
+} // namespace utils
+} // namespace vcompress
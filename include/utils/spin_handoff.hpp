@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Single-slot, single-producer/single-consumer handoff that busy-waits instead of blocking
+ *
+ * Meant for pinned threads in the live pipeline: a handoff costs a cache line transfer instead of a
+ * futex wake-up. Waiters spin briefly, then yield so an oversubscribed machine still makes progress.
+ */
+template <typename T> class SpinHandoff {
+  public:
+    SpinHandoff() : m_full(false), m_closed(false) {}
+
+    /**
+     * @brief Hand an item to the consumer, waiting until the slot is free
+     * @return false if the handoff was closed
+     */
+    bool put(T &&item) {
+        for (int spins = 0; m_full.load(std::memory_order_acquire); spins++) {
+            if (m_closed.load(std::memory_order_acquire)) return false;
+            backoff(spins);
+        }
+        m_item = std::move(item);
+        m_full.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the next item, waiting until one is available
+     * @return false once the handoff is closed and drained
+     */
+    bool take(T &item) {
+        for (int spins = 0; !m_full.load(std::memory_order_acquire); spins++) {
+            // close() follows the last put(), so the slot is final once the close is visible
+            if (m_closed.load(std::memory_order_acquire) && !m_full.load(std::memory_order_acquire)) {
+                return false;
+            }
+            backoff(spins);
+        }
+        item = std::move(m_item);
+        m_full.store(false, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief No more items will be put; wakes up both sides
+    void close() { m_closed.store(true, std::memory_order_release); }
+
+  private:
+    static void backoff(int spins) {
+        if (spins > 256) std::this_thread::yield();
+    }
+
+    T m_item;
+    std::atomic<bool> m_full;
+    std::atomic<bool> m_closed;
+};
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Recursive motion-adaptive temporal denoiser for BGR frames
+ *
+ * Every sample keeps a filtered value with 4 fractional bits. Each new frame pulls the state towards the
+ * input by a weight that grows with the difference: samples that barely changed (sensor noise) move by a
+ * small fraction, so noise is averaged over several frames, while differences above the motion threshold
+ * take the input as is, so moving edges do not smear. The kernel is branch-free integer arithmetic over
+ * contiguous samples, so the compiler vectorizes it.
+ */
+class TemporalDenoiser {
+  public:
+    /**
+     * @param strength Filter strength (1-10): higher averages over more frames and treats larger
+     *                 differences as noise
+     */
+    explicit TemporalDenoiser(int strength);
+
+    /**
+     * @brief Filter one frame
+     *
+     * @param src,dst Interleaved BGR pixels, `pixels * 3` bytes each (may alias)
+     * @param restart Drop the history (first frame, key frames, size changes) and output the input
+     */
+    void process(const uint8_t *src, uint8_t *dst, size_t pixels, bool restart);
+
+    int getStrength() const { return m_strength; }
+
+  private:
+    static constexpr int FRACTION_BITS = 4;
+    static constexpr int WEIGHT_ONE = 256;
+
+    int m_strength;
+    int m_minWeight;   // Weight of a static pixel, out of WEIGHT_ONE
+    int m_weightSlope; // Weight increase per state unit of difference, with 8 fractional bits
+    std::vector<uint16_t> m_state;
+};
+
+} // namespace utils
+} // namespace vcompress
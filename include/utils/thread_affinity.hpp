@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Pin the calling thread to one CPU
+ *
+ * @param cpu CPU number, one of allowedCpus()
+ * @return false if pinning is not supported on this platform or was refused
+ */
+bool pinCurrentThread(int cpu);
+
+/**
+ * @brief CPUs the process may run on, in ascending order
+ *  This is the process affinity mask (as set by taskset or a container's cpuset), so processes started on
+ *  disjoint CPU sets pin their threads to disjoint CPUs. Empty if the mask is not available.
+ */
+std::vector<int> allowedCpus();
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Work-stealing pool of worker threads
+ *
+ * Every worker owns a task deque. Tasks submitted from a worker go to its own deque and are taken back
+ * LIFO (cache warm), tasks submitted from outside are spread round-robin, and idle workers steal the
+ * oldest task of another worker. The pool can be shared by independent users (e.g. the jobs of a batch):
+ * each user waits on its own TaskGroup, and a waiting thread runs the queued tasks of that group instead of
+ * blocking, so nested fork/join from inside a task cannot starve the pool. It never runs other tasks, so
+ * waiting for a frame's stripes cannot turn into running a whole queued encode job.
+ */
+class ThreadPool {
+  public:
+    /// @brief Completion counter of a set of tasks
+    class TaskGroup {
+      public:
+        TaskGroup() : m_pending(0), m_queued(0) {}
+        bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+      private:
+        friend class ThreadPool;
+        std::atomic<size_t> m_pending;
+        std::atomic<size_t> m_queued; // Pending tasks not taken by a thread yet
+    };
+
+    /**
+     * @brief Start the workers
+     * @param threads Number of worker threads (0 = one per hardware thread)
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * @brief Finish the queued tasks and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// @brief Queue a task, optionally counted in a group
+    void submit(std::function<void()> task, TaskGroup *group = nullptr);
+
+    /// @brief Block until every submitted task has finished
+    void wait();
+
+    /// @brief Run queued tasks of the group until every task of the group has finished
+    void wait(TaskGroup &group);
+
+    /// @brief Number of worker threads
+    size_t size() const { return m_workers.size(); }
+
+  private:
+    struct Task {
+        std::function<void()> function;
+        TaskGroup *group = nullptr;
+    };
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::atomic<size_t> m_queued;
+    std::atomic<size_t> m_unfinished;
+    std::atomic<size_t> m_nextQueue;
+
+    /// Sleeping workers and waiters; only used when there is nothing to run
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::condition_variable m_progress;
+    bool m_stopping;
+
+    void workerLoop(size_t index);
+    bool tryRunTask(size_t home, const TaskGroup *only = nullptr);
+    static bool takeTask(std::deque<Task> &tasks, bool newest, const TaskGroup *only, Task &task);
+    size_t currentWorker() const;
+};
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace vcompress {
+namespace utils {
+
+/**
+ * @brief Samples per block of the vectorized kernel loops
+ *  A kernel loop stages one block of each of its buffers in local arrays and runs over those, so the loop
+ *  has a fixed trip count and no aliasing between the buffers, which lets the compiler vectorize it at -O2.
+ *  Sixteen 8-bit samples fill one SSE2 or NEON register; samples after the last whole block run through the
+ *  same kernel one at a time.
+ */
+static constexpr int LANE_SAMPLES = 16;
+
+} // namespace utils
+} // namespace vcompress
@@ -1,5 +1,10 @@
 #include "algorithms/bilinear_downsample_algorithm.hpp"
+#include "utils/bit_depth.hpp"
+#include "utils/complexity_analyzer.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -10,9 +15,11 @@ BilinearDownsampleAlgorithm::BilinearDownsampleAlgorithm() {
     m_stats.frames_compressed = 0;
     m_stats.frames_decompressed = 0;
     m_stats.average_compression_ratio = 0.0;
+    m_stats.average_factor = 0.0;
     m_stats.total_compression_time_ms = 0.0;
     m_stats.total_decompression_time_ms = 0.0;
     m_downsample_factor = 2;
+    m_gop_factor = 2;
 }
 
 /// Reset the algorithm state to initial conditions
@@ -20,8 +27,10 @@ void BilinearDownsampleAlgorithm::reset() {
     m_stats.frames_compressed = 0;
     m_stats.frames_decompressed = 0;
     m_stats.average_compression_ratio = 0.0;
+    m_stats.average_factor = 0.0;
     m_stats.total_compression_time_ms = 0.0;
     m_stats.total_decompression_time_ms = 0.0;
+    m_gop_factor = m_downsample_factor;
 }
 
 BilinearDownsampleAlgorithm::~BilinearDownsampleAlgorithm() = default;
@@ -34,11 +43,100 @@ BilinearDownsampleAlgorithm::~BilinearDownsampleAlgorithm() = default;
 bool BilinearDownsampleAlgorithm::initialize(const CompressionConfig &config) {
     m_config = config;
     m_downsample_factor = 4 - (m_config.quality / 50);
-    m_downsample_factor = std::max(2, std::min(4, m_downsample_factor));
-    std::cout << "Initialized downsample algorithm with factor: " << m_downsample_factor << std::endl;
+    m_downsample_factor = std::max(2, std::min(4, m_downsample_factor)) + m_config.degradation_level;
+    m_gop_factor = m_downsample_factor;
+    std::cout << "Initialized downsample algorithm with factor: " << m_downsample_factor
+              << (m_config.adaptive_factor ? " (adaptive per GOP)" : "") << std::endl;
     return true;
 }
 
+/**
+ * @brief Select the downsample factor of a frame
+ *  With adaptive factors, the gradient energy of every key frame picks the factor for its whole GOP, so
+ *  delta frames always share the factor (and payload layout) of their key frame.
+ */
+int BilinearDownsampleAlgorithm::selectFrameFactor(const Frame &frame) {
+    if (!m_config.adaptive_factor) return m_downsample_factor;
+    if (frame.type == KEY_FRAME) {
+        double energy = utils::gradientEnergy(frame.data.data(), frame.width, frame.height);
+        int level = m_config.degradation_level;
+        m_gop_factor = utils::selectDownsampleFactor(energy, m_downsample_factor, 2 + level, 4 + level);
+    }
+    return m_gop_factor;
+}
+
+/// @brief Write the payload metadata: | width (4) | height (4) | factor (1) |
+void BilinearDownsampleAlgorithm::writeMetadata(uint8_t *buffer, int width, int height, int factor) const {
+    uint8_t factor_byte = static_cast<uint8_t>(factor);
+    std::memcpy(buffer, &width, WIDTH_BYTES);
+    std::memcpy(buffer + WIDTH_BYTES, &height, HEIGHT_BYTES);
+    std::memcpy(buffer + WIDTH_BYTES + HEIGHT_BYTES, &factor_byte, FACTOR_BYTES);
+}
+
+/// @brief Read the payload metadata written by writeMetadata
+void BilinearDownsampleAlgorithm::readMetadata(const uint8_t *buffer, int &width, int &height,
+                                               int &factor) const {
+    std::memcpy(&width, buffer, WIDTH_BYTES);
+    std::memcpy(&height, buffer + WIDTH_BYTES, HEIGHT_BYTES);
+    factor = buffer[WIDTH_BYTES + HEIGHT_BYTES] & ~PACKED_FLAG;
+}
+
+/**
+ * @brief Read the metadata of a payload and check that the plane it describes is all there
+ *  A zero factor or a plane of zero width or height is corrupt; a payload shorter than its metadata or its
+ *  (possibly bit-packed) plane is truncated.
+ */
+bool BilinearDownsampleAlgorithm::checkPayload(const std::vector<uint8_t> &compressed_data, int &width,
+                                               int &height, int &factor) {
+    m_last_error = CompressionError();
+    if (compressed_data.size() < METADATA_BYTES) {
+        m_last_error = CompressionError("Downsample payload is truncated");
+        return false;
+    }
+    readMetadata(compressed_data.data(), width, height, factor);
+    int bits = payloadBitDepth(compressed_data);
+    if (factor == 0 || width / factor <= 0 || height / factor <= 0 || bits < utils::MIN_BIT_DEPTH ||
+        bits > utils::MAX_BIT_DEPTH) {
+        m_last_error = CompressionError("Downsample payload is corrupt");
+        return false;
+    }
+    size_t plane_bytes = static_cast<size_t>(width / factor) * (height / factor) * 3;
+    size_t stored_bytes = bits < 8 ? DEPTH_BYTES + utils::packedSize(plane_bytes, bits) : plane_bytes;
+    if (compressed_data.size() < METADATA_BYTES + stored_bytes) {
+        m_last_error = CompressionError("Downsample payload is truncated");
+        return false;
+    }
+    return true;
+}
+
+int BilinearDownsampleAlgorithm::payloadBitDepth(const std::vector<uint8_t> &compressed_data) const {
+    if (compressed_data.size() < METADATA_BYTES + DEPTH_BYTES) return 8;
+    return (compressed_data[WIDTH_BYTES + HEIGHT_BYTES] & PACKED_FLAG) ? compressed_data[METADATA_BYTES] : 8;
+}
+
+/**
+ * @brief Bit-pack the plane of a payload: | width | height | factor + PACKED_FLAG | depth | packed plane |
+ */
+void BilinearDownsampleAlgorithm::packPayload(std::vector<uint8_t> &compressed_data, int plane_width,
+                                              int plane_height, int bits) const {
+    utils::packPayloadPlane(compressed_data, METADATA_BYTES, plane_width, plane_height, 3, bits);
+    compressed_data[WIDTH_BYTES + HEIGHT_BYTES] |= PACKED_FLAG;
+}
+
+const uint8_t *BilinearDownsampleAlgorithm::payloadPlane(const std::vector<uint8_t> &compressed_data,
+                                                         size_t plane_bytes,
+                                                         std::vector<uint8_t> &buffer) const {
+    int bits = payloadBitDepth(compressed_data);
+    if (bits >= 8) return compressed_data.data() + METADATA_BYTES;
+    buffer.assign(plane_bytes, 0);
+    if (bits >= utils::MIN_BIT_DEPTH &&
+        compressed_data.size() >= METADATA_BYTES + DEPTH_BYTES + utils::packedSize(plane_bytes, bits)) {
+        utils::unpackBitDepth(compressed_data.data() + METADATA_BYTES + DEPTH_BYTES, plane_bytes, bits,
+                              buffer.data());
+    }
+    return buffer.data();
+}
+
 /**
  * @brief Compress a video frame. Downsample the image by a factor of 2 or 4; with the help of OpenCV.
  * @param frame The input video frame to compress
@@ -49,27 +147,28 @@ std::vector<uint8_t> BilinearDownsampleAlgorithm::compressFrame(const Frame &fra
 
     int original_width = frame.width;
     int original_height = frame.height;
-    int target_width = original_width / m_downsample_factor;
-    int target_height = original_height / m_downsample_factor;
-    std::vector<uint8_t> downsampledBuffer(target_width * target_height * 3);
-
-    downsampleBilinear(frame.data.data(), downsampledBuffer.data(), original_width, original_height,
-                       target_width, target_height);
+    int factor = selectFrameFactor(frame);
+    int target_width = original_width / factor;
+    int target_height = original_height / factor;
+
+    // Create compressed data format: | width (4) | height (4) | factor (1) | raw pixel data |
+    std::vector<uint8_t> compressed_data(METADATA_BYTES + target_width * target_height * 3);
+    writeMetadata(compressed_data.data(), original_width, original_height, factor);
+    downsampleBilinear(frame.data.data(), compressed_data.data() + METADATA_BYTES, original_width,
+                       original_height, target_width, target_height);
+    bool packed = m_config.bit_depth >= utils::MIN_BIT_DEPTH && m_config.bit_depth < utils::MAX_BIT_DEPTH;
+    if (packed) packPayload(compressed_data, target_width, target_height, m_config.bit_depth);
 
     double original_size = original_width * original_height * 3;
-    double compressed_size = target_width * target_height * 3;
+    double compressed_size = target_width * target_height * 3 * (packed ? m_config.bit_depth / 8.0 : 1.0);
     double ratio = original_size / compressed_size;
 
     m_stats.frames_compressed++;
     m_stats.average_compression_ratio =
         ((m_stats.average_compression_ratio * (m_stats.frames_compressed - 1)) + ratio) /
         m_stats.frames_compressed;
-
-    // Create compressed data format: | width (4) | height (4) | raw pixel data |
-    std::vector<uint8_t> compressed_data(METADATA_BYTES + downsampledBuffer.size());
-    std::memcpy(compressed_data.data(), &original_width, WIDTH_BYTES);
-    std::memcpy(compressed_data.data() + WIDTH_BYTES, &original_height, HEIGHT_BYTES);
-    std::memcpy(compressed_data.data() + METADATA_BYTES, downsampledBuffer.data(), downsampledBuffer.size());
+    m_stats.average_factor =
+        ((m_stats.average_factor * (m_stats.frames_compressed - 1)) + factor) / m_stats.frames_compressed;
 
     auto end_time = std::chrono::high_resolution_clock::now();
     double elapsed_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
@@ -81,22 +180,29 @@ std::vector<uint8_t> BilinearDownsampleAlgorithm::compressFrame(const Frame &fra
 /**
  * @brief Decompress a video frame. Upsample the image back to the original resolution.
  *  Extract metadata and pixel data from the compressed data buffer, then upsample the image back to the
- * original.
+ * original. The factor is read from the payload, so it does not have to match the decoder's quality.
  */
 Frame BilinearDownsampleAlgorithm::decompressFrame(const std::vector<uint8_t> &compressed_data) {
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    int original_width, original_height;
-    std::memcpy(&original_width, compressed_data.data(), WIDTH_BYTES);
-    std::memcpy(&original_height, compressed_data.data() + WIDTH_BYTES, HEIGHT_BYTES);
+    int original_width, original_height, factor;
+    if (!checkPayload(compressed_data, original_width, original_height, factor)) return Frame();
 
-    int downsampled_width = original_width / m_downsample_factor;
-    int downsampled_height = original_height / m_downsample_factor;
+    int downsampled_width = original_width / factor;
+    int downsampled_height = original_height / factor;
     std::vector<uint8_t> upsampledBuffer(original_width * original_height * 3);
+    std::vector<uint8_t> unpacked;
+    size_t plane_bytes = static_cast<size_t>(downsampled_width) * downsampled_height * 3;
+    const uint8_t *plane = payloadPlane(compressed_data, plane_bytes, unpacked);
 
     // Upsample back to original resolution and convert back to Frame
-    upsampleBilinear(compressed_data.data() + METADATA_BYTES, upsampledBuffer.data(), downsampled_width,
-                     downsampled_height, original_width, original_height);
+    if (hasPostProcessing()) {
+        upsamplePostProcessed(plane, upsampledBuffer.data(), downsampled_width, downsampled_height,
+                              original_width, original_height);
+    } else {
+        upsampleBilinear(plane, upsampledBuffer.data(), downsampled_width, downsampled_height, original_width,
+                         original_height);
+    }
 
     Frame decompressed_frame(original_width, original_height);
     decompressed_frame.data = std::move(upsampledBuffer);
@@ -111,6 +217,59 @@ Frame BilinearDownsampleAlgorithm::decompressFrame(const std::vector<uint8_t> &c
     return decompressed_frame;
 }
 
+/**
+ * @brief The payload is | metadata | downsampled BGR plane |, so it can be predicted sample by sample
+ *  A bit-packed plane has no per-sample bytes to predict, so it is not described.
+ */
+bool BilinearDownsampleAlgorithm::describePayload(const std::vector<uint8_t> &compressed_data,
+                                                  PayloadLayout &layout) const {
+    if (compressed_data.size() < METADATA_BYTES || payloadBitDepth(compressed_data) < 8) return false;
+    int original_width, original_height, factor;
+    readMetadata(compressed_data.data(), original_width, original_height, factor);
+    if (factor <= 0) return false;
+
+    layout.header_bytes = METADATA_BYTES;
+    layout.width = original_width / factor;
+    layout.height = original_height / factor;
+    layout.channels = 3;
+    layout.sample_bytes = static_cast<size_t>(layout.width) * layout.height * layout.channels;
+    return compressed_data.size() >= layout.header_bytes + layout.sample_bytes;
+}
+
+/**
+ * @brief Downsample the stored plane again; a payload already at or beyond `factor` is kept as is
+ *  A bit-packed plane is expanded first and packed again at its own depth.
+ */
+bool BilinearDownsampleAlgorithm::resamplePayload(const std::vector<uint8_t> &compressed_data, int factor,
+                                                  std::vector<uint8_t> &resampled) const {
+    if (factor <= 0 || factor >= PACKED_FLAG || compressed_data.size() < METADATA_BYTES) return false;
+    int original_width, original_height, current_factor;
+    readMetadata(compressed_data.data(), original_width, original_height, current_factor);
+    if (current_factor <= 0) return false;
+    if (current_factor >= factor) {
+        resampled = compressed_data;
+        return true;
+    }
+
+    int bits = payloadBitDepth(compressed_data);
+    int plane_width = original_width / current_factor;
+    int plane_height = original_height / current_factor;
+    size_t plane_bytes = static_cast<size_t>(plane_width) * plane_height * 3;
+    size_t stored_bytes = bits < 8 ? DEPTH_BYTES + utils::packedSize(plane_bytes, bits) : plane_bytes;
+    if (compressed_data.size() < METADATA_BYTES + stored_bytes) return false;
+    std::vector<uint8_t> unpacked;
+    const uint8_t *plane = payloadPlane(compressed_data, plane_bytes, unpacked);
+
+    int target_width = original_width / factor;
+    int target_height = original_height / factor;
+    resampled.resize(METADATA_BYTES + target_width * target_height * 3);
+    writeMetadata(resampled.data(), original_width, original_height, factor);
+    downsampleBilinear(plane, resampled.data() + METADATA_BYTES, plane_width, plane_height, target_width,
+                       target_height);
+    if (bits < 8) packPayload(resampled, target_width, target_height, bits);
+    return true;
+}
+
 /**
  * @brief Print the m_stats and related information about the downsample algorithm
  */
@@ -122,6 +281,8 @@ std::string BilinearDownsampleAlgorithm::getStats() const {
        << "  Frames decompressed: " << m_stats.frames_decompressed << std::endl
        << "  Average compression ratio: " << m_stats.average_compression_ratio << ":1" << std::endl;
 
+    if (m_config.adaptive_factor)
+        ss << "  Average adaptive factor: " << m_stats.average_factor << std::endl;
     if (m_stats.frames_compressed > 0)
         ss << "  Average compression time: "
            << (m_stats.total_compression_time_ms / m_stats.frames_compressed) << " ms" << std::endl;
@@ -174,7 +335,7 @@ uint8_t getPixelValue(const uint8_t *src, int src_width, int y, int x, int c) {
  * @param dst_height Destination image height
  */
 void BilinearDownsampleAlgorithm::downsampleBilinear(const uint8_t *src, uint8_t *dst, int src_width,
-                                                     int src_height, int dst_width, int dst_height) {
+                                                     int src_height, int dst_width, int dst_height) const {
     // To properly access the full range of source pixels
     float x_ratio = static_cast<float>(src_width - 1) / dst_width;
     float y_ratio = static_cast<float>(src_height - 1) / dst_height;
@@ -237,5 +398,141 @@ void BilinearDownsampleAlgorithm::upsampleBilinear(const uint8_t *src, uint8_t *
     }
 }
 
+using utils::LANE_SAMPLES;
+
+/// @brief Sum, minimum and maximum of a sample and the samples above and below it
+static inline void columnSample(float above, float row, float below, float &sum, float &low, float &high) {
+    sum = above + row + below;
+    low = std::min(std::min(above, row), below);
+    high = std::max(std::max(above, row), below);
+}
+
+/// @brief Deband or sharpen a sample against the column results of its pixel and its two neighbours
+///  (one pixel = 3 samples away), then round it against the threshold
+static inline uint8_t finishSample(const float *sum, const float *low, const float *high, float sample,
+                                   float threshold, float amount, float deband_range) {
+    float mean = (sum[-3] + sum[0] + sum[3]) * (1.0f / 9.0f);
+    float range =
+        std::max(std::max(high[-3], high[0]), high[3]) - std::min(std::min(low[-3], low[0]), low[3]);
+    float sharpened = sample + amount * (sample - mean);
+    // Blend instead of branching on the flatness, so the lane loop has no control flow
+    float flat = range < deband_range;
+    float value = sharpened + flat * (mean - sharpened);
+    return static_cast<uint8_t>(std::min(std::max(value + threshold, 0.0f), 255.0f));
+}
+
+bool BilinearDownsampleAlgorithm::hasPostProcessing() const {
+    return m_config.sharpen_strength > 0 || m_config.deband || m_config.dither;
+}
+
+/**
+ * @brief Bilinear upsampling with sharpening, debanding and dithering fused into the row loop
+ *  Interpolated rows are kept at full precision in a ring of three rows. Once the row below is ready, the
+ *  middle row is finished against its 3x3 neighbourhood while all three rows are still in cache:
+ *  - deband: where the neighbourhood spans less than DEBAND_RANGE levels (a flat gradient whose steps are
+ *    the banding) the sample takes the neighbourhood mean, which spreads the steps out;
+ *  - sharpen: elsewhere the sample is pushed away from the mean (unsharp mask, sharpen_strength / 10);
+ *  - dither: the result is rounded against a 4x4 Bayer threshold instead of 0.5, so the fractional
+ *    precision of the interpolation survives as a fine pattern instead of new bands.
+ *  The neighbourhood sums and ranges are separable (columns first, then rows of padded column results),
+ *  so every loop runs over contiguous samples and vectorizes, and each output sample is written once.
+ */
+void BilinearDownsampleAlgorithm::upsamplePostProcessed(const uint8_t *src, uint8_t *dst, int src_width,
+                                                        int src_height, int dst_width, int dst_height) const {
+    static const float DEBAND_RANGE = 3.0f;
+    static const int BAYER[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    float x_ratio = static_cast<float>(src_width - 1) / (dst_width - 1);
+    float y_ratio = static_cast<float>(src_height - 1) / (dst_height - 1);
+    float amount = m_config.sharpen_strength / 10.0f;
+    float deband_range = m_config.deband ? DEBAND_RANGE : 0.0f;
+    size_t row_samples = static_cast<size_t>(dst_width) * 3;
+
+    // Horizontal interpolation parameters and rounding thresholds are the same for every row
+    std::vector<int> left_sample(row_samples), right_sample(row_samples);
+    std::vector<float> x_fraction(row_samples), thresholds(row_samples * 4);
+    for (int x = 0; x < dst_width; x++) {
+        auto [x_floor, x_ceil, fraction] = calculateInterpolationParams(x, x_ratio, src_width);
+        for (int c = 0; c < 3; c++) {
+            left_sample[x * 3 + c] = x_floor * 3 + c;
+            right_sample[x * 3 + c] = x_ceil * 3 + c;
+            x_fraction[x * 3 + c] = fraction;
+            for (int phase = 0; phase < 4; phase++) {
+                thresholds[phase * row_samples + x * 3 + c] =
+                    m_config.dither ? (BAYER[phase][x & 3] + 0.5f) / 16.0f : 0.5f;
+            }
+        }
+    }
+
+    std::vector<float> ring(row_samples * 3);
+    auto interpolateRow = [&](int y) {
+        auto [y_floor, y_ceil, y_fraction] = calculateInterpolationParams(y, y_ratio, src_height);
+        const uint8_t *top = src + static_cast<size_t>(y_floor) * src_width * 3;
+        const uint8_t *bottom = src + static_cast<size_t>(y_ceil) * src_width * 3;
+        float *row = ring.data() + (y % 3) * row_samples;
+        for (size_t i = 0; i < row_samples; i++) {
+            float upper = top[left_sample[i]] + (top[right_sample[i]] - top[left_sample[i]]) * x_fraction[i];
+            float lower =
+                bottom[left_sample[i]] + (bottom[right_sample[i]] - bottom[left_sample[i]]) * x_fraction[i];
+            row[i] = upper + (lower - upper) * y_fraction;
+        }
+    };
+
+    // Column results are padded by one pixel on each side, repeating the edge pixel
+    std::vector<float> column_sum(row_samples + 6), column_min(row_samples + 6), column_max(row_samples + 6);
+    interpolateRow(0);
+    if (dst_height > 1) interpolateRow(1);
+    for (int y = 0; y < dst_height; y++) {
+        // Rows outside the frame repeat the edge row
+        const float *above = ring.data() + (std::max(y - 1, 0) % 3) * row_samples;
+        const float *row = ring.data() + (y % 3) * row_samples;
+        const float *below = ring.data() + (std::min(y + 1, dst_height - 1) % 3) * row_samples;
+        float *sum = column_sum.data() + 3, *low = column_min.data() + 3, *high = column_max.data() + 3;
+        size_t i = 0;
+        for (; i + LANE_SAMPLES <= row_samples; i += LANE_SAMPLES) {
+            float a[LANE_SAMPLES], r[LANE_SAMPLES], b[LANE_SAMPLES];
+            float lane_sum[LANE_SAMPLES], lane_low[LANE_SAMPLES], lane_high[LANE_SAMPLES];
+            std::memcpy(a, above + i, sizeof(a));
+            std::memcpy(r, row + i, sizeof(r));
+            std::memcpy(b, below + i, sizeof(b));
+            for (int k = 0; k < LANE_SAMPLES; k++) {
+                columnSample(a[k], r[k], b[k], lane_sum[k], lane_low[k], lane_high[k]);
+            }
+            std::memcpy(sum + i, lane_sum, sizeof(lane_sum));
+            std::memcpy(low + i, lane_low, sizeof(lane_low));
+            std::memcpy(high + i, lane_high, sizeof(lane_high));
+        }
+        for (; i < row_samples; i++) columnSample(above[i], row[i], below[i], sum[i], low[i], high[i]);
+        for (int c = 0; c < 3; c++) {
+            sum[c - 3] = sum[c], low[c - 3] = low[c], high[c - 3] = high[c];
+            size_t last = row_samples - 3 + c;
+            sum[last + 3] = sum[last], low[last + 3] = low[last], high[last + 3] = high[last];
+        }
+
+        const float *threshold = thresholds.data() + (y & 3) * row_samples;
+        uint8_t *out = dst + static_cast<size_t>(y) * row_samples;
+        for (i = 0; i + LANE_SAMPLES <= row_samples; i += LANE_SAMPLES) {
+            // Lane plus one pixel of column results on each side
+            float lane_sum[LANE_SAMPLES + 6], lane_low[LANE_SAMPLES + 6], lane_high[LANE_SAMPLES + 6];
+            float r[LANE_SAMPLES], t[LANE_SAMPLES];
+            uint8_t output[LANE_SAMPLES];
+            std::memcpy(lane_sum, sum + i - 3, sizeof(lane_sum));
+            std::memcpy(lane_low, low + i - 3, sizeof(lane_low));
+            std::memcpy(lane_high, high + i - 3, sizeof(lane_high));
+            std::memcpy(r, row + i, sizeof(r));
+            std::memcpy(t, threshold + i, sizeof(t));
+            for (int k = 0; k < LANE_SAMPLES; k++) {
+                output[k] = finishSample(lane_sum + 3 + k, lane_low + 3 + k, lane_high + 3 + k, r[k], t[k],
+                                         amount, deband_range);
+            }
+            std::memcpy(out + i, output, sizeof(output));
+        }
+        for (; i < row_samples; i++) {
+            out[i] = finishSample(sum + i, low + i, high + i, row[i], threshold[i], amount, deband_range);
+        }
+        // The slot of row y - 1 is free now
+        if (y + 2 < dst_height) interpolateRow(y + 2);
+    }
+}
+
 } // namespace algorithm
-} // namespace vcompress
\ No newline at end of file
+} // namespace vcompress
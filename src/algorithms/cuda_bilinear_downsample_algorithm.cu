@@ -1,4 +1,5 @@
 #include "algorithms/bilinear_downsample_algorithm.hpp"
+#include "utils/bit_depth.hpp"
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
 
@@ -114,26 +115,30 @@ std::vector<uint8_t> CudaBilinearDownsampleAlgorithm::compressFrame(const Frame
 
     int original_width = frame.width;
     int original_height = frame.height;
-    int target_width = original_width / m_downsample_factor;
-    int target_height = original_height / m_downsample_factor;
+    int factor = selectFrameFactor(frame);
+    int target_width = original_width / factor;
+    int target_height = original_height / factor;
     std::vector<uint8_t> downsampled(target_width * target_height * 3);
     cudaDownsampleBilinear(frame.data.data(), downsampled.data(), original_width, original_height,
                            target_width, target_height);
 
+    bool packed = m_config.bit_depth >= utils::MIN_BIT_DEPTH && m_config.bit_depth < utils::MAX_BIT_DEPTH;
     double original_size = original_width * original_height * 3;
-    double compressed_size = target_width * target_height * 3;
+    double compressed_size = target_width * target_height * 3 * (packed ? m_config.bit_depth / 8.0 : 1.0);
     double ratio = original_size / compressed_size;
 
     m_stats.frames_compressed++;
     m_stats.average_compression_ratio =
         ((m_stats.average_compression_ratio * (m_stats.frames_compressed - 1)) + ratio) /
         m_stats.frames_compressed;
+    m_stats.average_factor =
+        ((m_stats.average_factor * (m_stats.frames_compressed - 1)) + factor) / m_stats.frames_compressed;
 
-    // Create compressed data format: | width (4) | height (4) | raw pixel data |
+    // Create compressed data format: | width (4) | height (4) | factor (1) | raw pixel data |
     std::vector<uint8_t> compressed_data(METADATA_BYTES + downsampled.size());
-    std::memcpy(compressed_data.data(), &original_width, WIDTH_BYTES);
-    std::memcpy(compressed_data.data() + WIDTH_BYTES, &original_height, HEIGHT_BYTES);
+    writeMetadata(compressed_data.data(), original_width, original_height, factor);
     std::memcpy(compressed_data.data() + METADATA_BYTES, downsampled.data(), downsampled.size());
+    if (packed) packPayload(compressed_data, target_width, target_height, m_config.bit_depth);
 
     auto end_time = std::chrono::high_resolution_clock::now();
     double elapsed_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
@@ -144,22 +149,26 @@ std::vector<uint8_t> CudaBilinearDownsampleAlgorithm::compressFrame(const Frame
 
 /**
  * @brief Decompresses a frame using CUDA bilinear upsampling when available.
- * If CUDA is not available, it falls back to the CPU implementation.
+ * If CUDA is not available, or the config asks for post-processing (which is fused into the CPU upsampling
+ * loop), it falls back to the CPU implementation, so both paths decode a payload alike.
  * @param compressed_data The compressed data to decompress.
  * @return The decompressed frame.
  */
 Frame CudaBilinearDownsampleAlgorithm::decompressFrame(const std::vector<uint8_t> &compressed_data) {
-    if (!m_cuda_available) return BilinearDownsampleAlgorithm::decompressFrame(compressed_data);
+    if (!m_cuda_available || hasPostProcessing()) {
+        return BilinearDownsampleAlgorithm::decompressFrame(compressed_data);
+    }
 
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    int original_width, original_height;
-    std::memcpy(&original_width, compressed_data.data(), WIDTH_BYTES);
-    std::memcpy(&original_height, compressed_data.data() + WIDTH_BYTES, HEIGHT_BYTES);
+    int original_width, original_height, factor;
+    if (!checkPayload(compressed_data, original_width, original_height, factor)) return Frame();
 
-    int downsampled_width = original_width / m_downsample_factor;
-    int downsampled_height = original_height / m_downsample_factor;
-    const uint8_t *downsampled_data = compressed_data.data() + METADATA_BYTES;
+    int downsampled_width = original_width / factor;
+    int downsampled_height = original_height / factor;
+    std::vector<uint8_t> unpacked;
+    const uint8_t *downsampled_data =
+        payloadPlane(compressed_data, downsampled_width * downsampled_height * 3, unpacked);
     std::vector<uint8_t> upsampled(original_width * original_height * 3);
 
     cudaUpsampleBilinear(downsampled_data, upsampled.data(), downsampled_width, downsampled_height,
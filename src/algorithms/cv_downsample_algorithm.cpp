@@ -1,4 +1,6 @@
 #include "algorithms/cv_downsample_algorithm.hpp"
+#include "utils/bit_depth.hpp"
+#include "utils/complexity_analyzer.hpp"
 #include <chrono>
 #include <iostream>
 #include <sstream>
@@ -10,9 +12,11 @@ CVDownsampleAlgorithm::CVDownsampleAlgorithm() {
     m_stats.frames_compressed = 0;
     m_stats.frames_decompressed = 0;
     m_stats.average_compression_ratio = 0.0;
+    m_stats.average_factor = 0.0;
     m_stats.total_compression_time_ms = 0.0;
     m_stats.total_decompression_time_ms = 0.0;
     m_downsample_factor = 2;
+    m_gop_factor = 2;
 }
 
 /// Reset the algorithm state to initial conditions
@@ -20,8 +24,10 @@ void CVDownsampleAlgorithm::reset() {
     m_stats.frames_compressed = 0;
     m_stats.frames_decompressed = 0;
     m_stats.average_compression_ratio = 0.0;
+    m_stats.average_factor = 0.0;
     m_stats.total_compression_time_ms = 0.0;
     m_stats.total_decompression_time_ms = 0.0;
+    m_gop_factor = m_downsample_factor;
 }
 
 CVDownsampleAlgorithm::~CVDownsampleAlgorithm() = default;
@@ -34,11 +40,40 @@ CVDownsampleAlgorithm::~CVDownsampleAlgorithm() = default;
 bool CVDownsampleAlgorithm::initialize(const CompressionConfig &config) {
     m_config = config;
     m_downsample_factor = 4 - (m_config.quality / 50);
-    m_downsample_factor = std::max(2, std::min(4, m_downsample_factor));
-    std::cout << "Initialized downsample algorithm with factor: " << m_downsample_factor << std::endl;
+    m_downsample_factor = std::max(2, std::min(4, m_downsample_factor)) + m_config.degradation_level;
+    m_gop_factor = m_downsample_factor;
+    std::cout << "Initialized downsample algorithm with factor: " << m_downsample_factor
+              << (m_config.adaptive_factor ? " (adaptive per GOP)" : "") << std::endl;
     return true;
 }
 
+/**
+ * @brief Select the downsample factor of a frame
+ *  With adaptive factors, the gradient energy of every key frame picks the factor for its whole GOP.
+ */
+int CVDownsampleAlgorithm::selectFrameFactor(const Frame &frame) {
+    if (!m_config.adaptive_factor) return m_downsample_factor;
+    if (frame.type == KEY_FRAME) {
+        double energy = utils::gradientEnergy(frame.data.data(), frame.width, frame.height);
+        int level = m_config.degradation_level;
+        m_gop_factor = utils::selectDownsampleFactor(energy, m_downsample_factor, 2 + level, 4 + level);
+    }
+    return m_gop_factor;
+}
+
+bool CVDownsampleAlgorithm::packsPlane() const {
+    return m_config.bit_depth >= utils::MIN_BIT_DEPTH && m_config.bit_depth < utils::MAX_BIT_DEPTH;
+}
+
+/**
+ * @brief Bit-pack the plane of a payload: | width | height | factor + PACKED_FLAG | depth | packed plane |
+ */
+void CVDownsampleAlgorithm::packPayload(std::vector<uint8_t> &compressed_data, int plane_width,
+                                        int plane_height, int bits) const {
+    utils::packPayloadPlane(compressed_data, METADATA_BYTES, plane_width, plane_height, 3, bits);
+    compressed_data[WIDTH_BYTES + HEIGHT_BYTES] |= PACKED_FLAG;
+}
+
 /**
  * @brief Compress a video frame. Downsample the image by a factor of 2 or 4; with the help of OpenCV.
  * @param frame The input video frame to compress
@@ -50,19 +85,24 @@ std::vector<uint8_t> CVDownsampleAlgorithm::compressFrame(const Frame &frame) {
     cv::Mat original_mat = frameToMat(frame);
     int original_width = original_mat.cols;
     int original_height = original_mat.rows;
+    int factor = selectFrameFactor(frame);
 
     // Downsample the image
     cv::Mat downsampled_mat;
-    cv::resize(original_mat, downsampled_mat,
-               cv::Size(original_width / m_downsample_factor, original_height / m_downsample_factor), 0, 0,
-               cv::INTER_AREA);
+    cv::resize(original_mat, downsampled_mat, cv::Size(original_width / factor, original_height / factor), 0,
+               0, cv::INTER_AREA);
 
     updateCompressionStats(original_mat, downsampled_mat);
+    m_stats.average_factor =
+        ((m_stats.average_factor * (m_stats.frames_compressed - 1)) + factor) / m_stats.frames_compressed;
 
-    // Create compressed data: | width (4) | height (4) | raw pixel data |
+    // Create compressed data: | width (4) | height (4) | factor (1) | raw pixel data |
     std::vector<uint8_t> compressed_data(METADATA_BYTES +
                                          downsampled_mat.total() * downsampled_mat.elemSize());
-    copyMatToBuffer(downsampled_mat, original_width, original_height, compressed_data.data());
+    copyMatToBuffer(downsampled_mat, original_width, original_height, factor, compressed_data.data());
+    if (packsPlane()) {
+        packPayload(compressed_data, downsampled_mat.cols, downsampled_mat.rows, m_config.bit_depth);
+    }
 
     auto end_time = std::chrono::high_resolution_clock::now();
     double elapsed_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
@@ -78,10 +118,15 @@ std::vector<uint8_t> CVDownsampleAlgorithm::compressFrame(const Frame &frame) {
  */
 Frame CVDownsampleAlgorithm::decompressFrame(const std::vector<uint8_t> &compressed_data) {
     auto start_time = std::chrono::high_resolution_clock::now();
+    m_last_error = CompressionError();
 
     int original_width, original_height;
     cv::Mat downsampled_mat =
         copyBufferToMat(compressed_data.data(), original_width, original_height, compressed_data.size());
+    if (downsampled_mat.empty()) {
+        m_last_error = CompressionError("Downsample payload is truncated or corrupt");
+        return Frame();
+    }
 
     // Upsample back to original resolution and convert back to Frame
     cv::Mat upsampled_mat;
@@ -97,6 +142,61 @@ Frame CVDownsampleAlgorithm::decompressFrame(const std::vector<uint8_t> &compres
     return decompressed_frame;
 }
 
+/**
+ * @brief The payload is | metadata | downsampled BGR plane |, so it can be predicted sample by sample
+ *  A bit-packed plane has no per-sample bytes to predict, so it is not described.
+ */
+bool CVDownsampleAlgorithm::describePayload(const std::vector<uint8_t> &compressed_data,
+                                            PayloadLayout &layout) const {
+    if (compressed_data.size() < METADATA_BYTES) return false;
+    int w, h;
+    std::memcpy(&w, compressed_data.data(), WIDTH_BYTES);
+    std::memcpy(&h, compressed_data.data() + WIDTH_BYTES, HEIGHT_BYTES);
+    int factor = compressed_data[WIDTH_BYTES + HEIGHT_BYTES];
+    if (factor <= 0 || (factor & PACKED_FLAG)) return false;
+
+    layout.header_bytes = METADATA_BYTES;
+    layout.width = w / factor;
+    layout.height = h / factor;
+    layout.channels = 3;
+    layout.sample_bytes = static_cast<size_t>(layout.width) * layout.height * layout.channels;
+    return compressed_data.size() >= layout.header_bytes + layout.sample_bytes;
+}
+
+/**
+ * @brief Area-resample the stored plane; averaging 2x2 blocks of a factor 2 plane matches (up to rounding)
+ *  a factor 4 encode of the original. A payload already at or beyond `factor` is kept as is, and a
+ *  bit-packed plane is expanded first and packed again at its own depth.
+ */
+bool CVDownsampleAlgorithm::resamplePayload(const std::vector<uint8_t> &compressed_data, int factor,
+                                            std::vector<uint8_t> &resampled) const {
+    if (factor <= 0 || factor >= PACKED_FLAG || compressed_data.size() < METADATA_BYTES + DEPTH_BYTES) {
+        return false;
+    }
+    uint8_t factor_flags = compressed_data[WIDTH_BYTES + HEIGHT_BYTES];
+    int bits = (factor_flags & PACKED_FLAG) ? compressed_data[METADATA_BYTES] : 8;
+    if ((factor_flags & ~PACKED_FLAG) == 0) return false;
+    if ((factor_flags & ~PACKED_FLAG) >= factor) {
+        resampled = compressed_data;
+        return true;
+    }
+
+    int w, h;
+    cv::Mat stored = copyBufferToMat(compressed_data.data(), w, h, compressed_data.size());
+    if (stored.empty()) return false;
+    cv::Mat downsampled_mat;
+    cv::resize(stored, downsampled_mat, cv::Size(w / factor, h / factor), 0, 0, cv::INTER_AREA);
+
+    resampled.resize(METADATA_BYTES + downsampled_mat.total() * downsampled_mat.elemSize());
+    uint8_t factor_byte = static_cast<uint8_t>(factor);
+    std::memcpy(resampled.data(), &w, WIDTH_BYTES);
+    std::memcpy(resampled.data() + WIDTH_BYTES, &h, HEIGHT_BYTES);
+    std::memcpy(resampled.data() + WIDTH_BYTES + HEIGHT_BYTES, &factor_byte, FACTOR_BYTES);
+    std::memcpy(resampled.data() + METADATA_BYTES, downsampled_mat.data, resampled.size() - METADATA_BYTES);
+    if (bits < 8) packPayload(resampled, downsampled_mat.cols, downsampled_mat.rows, bits);
+    return true;
+}
+
 /**
  * @brief Print the m_stats and related information about the downsample algorithm
  */
@@ -108,6 +208,9 @@ std::string CVDownsampleAlgorithm::getStats() const {
        << "  Frames decompressed: " << m_stats.frames_decompressed << std::endl
        << "  Average compression ratio: " << m_stats.average_compression_ratio << ":1" << std::endl;
 
+    if (m_config.adaptive_factor) {
+        ss << "  Average adaptive factor: " << m_stats.average_factor << std::endl;
+    }
     if (m_stats.frames_compressed > 0) {
         ss << "  Average compression time: "
            << (m_stats.total_compression_time_ms / m_stats.frames_compressed) << " ms" << std::endl;
@@ -137,6 +240,7 @@ cv::Mat CVDownsampleAlgorithm::frameToMat(const Frame &frame) {
 void CVDownsampleAlgorithm::updateCompressionStats(const cv::Mat &original, const cv::Mat &compressed) {
     double original_size = original.total() * original.elemSize();
     double compressed_size = compressed.total() * compressed.elemSize();
+    if (packsPlane()) compressed_size *= m_config.bit_depth / 8.0;
     double ratio = original_size / compressed_size;
 
     m_stats.frames_compressed++;
@@ -150,10 +254,12 @@ void CVDownsampleAlgorithm::updateCompressionStats(const cv::Mat &original, cons
  *  This function is used to copy pixel data from an OpenCV Mat to a buffer in the format required by the
  * compression algorithm. It handles both continuous and non-continuous matrices.
  */
-void CVDownsampleAlgorithm::copyMatToBuffer(const cv::Mat &mat, int w, int h, uint8_t *buffer) {
-    // Store width and height
+void CVDownsampleAlgorithm::copyMatToBuffer(const cv::Mat &mat, int w, int h, int factor, uint8_t *buffer) {
+    // Store width, height and the downsample factor
+    uint8_t factor_byte = static_cast<uint8_t>(factor);
     std::memcpy(buffer, &w, WIDTH_BYTES);
     std::memcpy(buffer + WIDTH_BYTES, &h, HEIGHT_BYTES);
+    std::memcpy(buffer + WIDTH_BYTES + HEIGHT_BYTES, &factor_byte, FACTOR_BYTES);
     // Store pixel data
     if (mat.isContinuous()) {
         std::memcpy(buffer + METADATA_BYTES, mat.data, mat.total() * mat.elemSize());
@@ -178,15 +284,37 @@ Frame CVDownsampleAlgorithm::matToFrame(const cv::Mat &mat) {
     return frame;
 }
 
-/// @brief Copy pixel data from the compressed data buffer to an OpenCV Mat
-cv::Mat CVDownsampleAlgorithm::copyBufferToMat(const uint8_t *buffer, int &w, int &h, size_t bufferSize) {
+/**
+ * @brief Copy pixel data from the compressed data buffer to an OpenCV Mat; the factor comes from the buffer
+ *  A bit-packed plane is expanded back to 8 bits on the way. A buffer shorter than its metadata or its
+ *  plane, with a zero factor or an empty plane, gives an empty Mat.
+ */
+cv::Mat CVDownsampleAlgorithm::copyBufferToMat(const uint8_t *buffer, int &w, int &h,
+                                               size_t bufferSize) const {
+    if (bufferSize < METADATA_BYTES) return cv::Mat();
     std::memcpy(&w, buffer, WIDTH_BYTES);
     std::memcpy(&h, buffer + WIDTH_BYTES, HEIGHT_BYTES);
+    int factor = buffer[WIDTH_BYTES + HEIGHT_BYTES] & ~PACKED_FLAG;
+    bool packed = buffer[WIDTH_BYTES + HEIGHT_BYTES] & PACKED_FLAG;
+    if (factor == 0 || w / factor <= 0 || h / factor <= 0) return cv::Mat();
 
-    int downsampled_w = w / m_downsample_factor;
-    int downsampled_h = h / m_downsample_factor;
+    int downsampled_w = w / factor;
+    int downsampled_h = h / factor;
+    size_t samples = static_cast<size_t>(downsampled_w) * downsampled_h * 3;
+    if (!packed) {
+        if (bufferSize < METADATA_BYTES + samples) return cv::Mat();
+        cv::Mat downsampled_mat(downsampled_h, downsampled_w, CV_8UC3);
+        std::memcpy(downsampled_mat.data, buffer + METADATA_BYTES, samples);
+        return downsampled_mat;
+    }
+    if (bufferSize < METADATA_BYTES + DEPTH_BYTES) return cv::Mat();
+    int bits = buffer[METADATA_BYTES];
+    if (bits < utils::MIN_BIT_DEPTH || bits >= utils::MAX_BIT_DEPTH ||
+        bufferSize < METADATA_BYTES + DEPTH_BYTES + utils::packedSize(samples, bits)) {
+        return cv::Mat();
+    }
     cv::Mat downsampled_mat(downsampled_h, downsampled_w, CV_8UC3);
-    std::memcpy(downsampled_mat.data, buffer + METADATA_BYTES, bufferSize - METADATA_BYTES);
+    utils::unpackBitDepth(buffer + METADATA_BYTES + DEPTH_BYTES, samples, bits, downsampled_mat.data);
     return downsampled_mat;
 }
 
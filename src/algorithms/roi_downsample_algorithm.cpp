@@ -0,0 +1,311 @@
+#include "algorithms/roi_downsample_algorithm.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace vcompress {
+namespace algorithm {
+
+ROIDownsampleAlgorithm::ROIDownsampleAlgorithm()
+    : BilinearDownsampleAlgorithm(), m_roi_factor(1), m_background_factor(4), m_roi_tile_ratio(0.0) {}
+
+ROIDownsampleAlgorithm::~ROIDownsampleAlgorithm() = default;
+
+/// Reset the algorithm state to initial conditions
+void ROIDownsampleAlgorithm::reset() {
+    BilinearDownsampleAlgorithm::reset();
+    m_roi_tile_ratio = 0.0;
+}
+
+/**
+ * @brief Initialize the ROI algorithm with configuration
+ *  The quality derived factor (2-4) of the base class selects the pair of tile factors: ROIs are kept at
+ *  full or half resolution, the background is reduced by 4 or 8.
+ * @param config The configuration settings, including static ROIs and the optional sidecar file
+ */
+bool ROIDownsampleAlgorithm::initialize(const CompressionConfig &config) {
+    if (!BilinearDownsampleAlgorithm::initialize(config)) return false;
+
+    m_roi_factor = m_downsample_factor >= 4 ? 2 : 1;
+    m_background_factor = m_downsample_factor >= 4 ? 8 : 4;
+
+    m_frame_rois.clear();
+    if (!m_config.roi_sidecar_path.empty() && !loadSidecar(m_config.roi_sidecar_path)) {
+        std::cerr << "Error: Could not read ROI sidecar: " << m_config.roi_sidecar_path << std::endl;
+        return false;
+    }
+    std::cout << "Initialized ROI algorithm with ROI factor " << m_roi_factor << ", background factor "
+              << m_background_factor << ", " << m_config.roi_regions.size() << " static ROIs and "
+              << m_frame_rois.size() << " frames with sidecar ROIs" << std::endl;
+    return true;
+}
+
+/**
+ * @brief Load per-frame ROIs from a sidecar text file
+ *  One ROI per line: `<frame> <x> <y> <width> <height>`; empty lines and lines starting with '#' are skipped.
+ *  Frames listed in the sidecar use only their own ROIs; all other frames use the static ROIs.
+ */
+bool ROIDownsampleAlgorithm::loadSidecar(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        int frame_number;
+        RegionOfInterest roi;
+        if (!(iss >> frame_number >> roi.x >> roi.y >> roi.width >> roi.height)) {
+            std::cerr << "Warning: Skipping malformed ROI sidecar line: " << line << std::endl;
+            continue;
+        }
+        m_frame_rois[frame_number].push_back(roi);
+    }
+    return true;
+}
+
+/// @brief The ROIs of a frame: sidecar entries take precedence over the static configuration
+const std::vector<RegionOfInterest> &ROIDownsampleAlgorithm::regionsForFrame(int frame_number) const {
+    auto it = m_frame_rois.find(frame_number);
+    return it != m_frame_rois.end() ? it->second : m_config.roi_regions;
+}
+
+/**
+ * @brief Reduce a tile factor until the tile keeps at least 2x2 samples
+ *  Bilinear upsampling needs two samples per axis; narrow edge tiles therefore fall back to lower factors.
+ */
+int ROIDownsampleAlgorithm::clampTileFactor(int factor, int tile_width, int tile_height) {
+    while (factor > 1 && (tile_width / factor < 2 || tile_height / factor < 2)) factor /= 2;
+    return factor;
+}
+
+/// @brief Pick the factor of every tile (raster order) depending on whether it intersects any ROI
+std::vector<uint8_t> ROIDownsampleAlgorithm::selectTileFactors(const std::vector<RegionOfInterest> &regions,
+                                                               int width, int height, int tiles_x,
+                                                               int tiles_y) const {
+    std::vector<uint8_t> factors(tiles_x * tiles_y);
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE;
+            int tile_width = std::min(TILE_SIZE, width - x0);
+            int tile_height = std::min(TILE_SIZE, height - y0);
+
+            bool in_roi = false;
+            for (const auto &roi : regions) {
+                if (roi.x < x0 + tile_width && x0 < roi.x + roi.width && roi.y < y0 + tile_height &&
+                    y0 < roi.y + roi.height) {
+                    in_roi = true;
+                    break;
+                }
+            }
+            int factor = in_roi ? m_roi_factor : m_background_factor;
+            factors[ty * tiles_x + tx] =
+                static_cast<uint8_t>(clampTileFactor(factor, tile_width, tile_height));
+        }
+    }
+    return factors;
+}
+
+/**
+ * @brief Compress a video frame tile by tile with the factor chosen for each tile.
+ * @param frame The input video frame to compress
+ * @return std::vector<uint8_t> The compressed data:
+ *  | width (4) | height (4) | background factor (1) | tile size (2) | factor per tile (1 each) |
+ *  | tile samples in raster order |
+ */
+std::vector<uint8_t> ROIDownsampleAlgorithm::compressFrame(const Frame &frame) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    int original_width = frame.width;
+    int original_height = frame.height;
+    int tiles_x = (original_width + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_y = (original_height + TILE_SIZE - 1) / TILE_SIZE;
+    std::vector<uint8_t> factors = selectTileFactors(regionsForFrame(frame.timestamp), original_width,
+                                                     original_height, tiles_x, tiles_y);
+
+    size_t samples_size = 0;
+    int roi_tiles = 0;
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int factor = factors[ty * tiles_x + tx];
+            int tile_width = std::min(TILE_SIZE, original_width - tx * TILE_SIZE);
+            int tile_height = std::min(TILE_SIZE, original_height - ty * TILE_SIZE);
+            samples_size += static_cast<size_t>(tile_width / factor) * (tile_height / factor) * 3;
+            if (factor <= m_roi_factor) roi_tiles++;
+        }
+    }
+
+    uint16_t tile_size = TILE_SIZE;
+    std::vector<uint8_t> compressed_data(ROI_METADATA_BYTES + factors.size() + samples_size);
+    writeMetadata(compressed_data.data(), original_width, original_height, m_background_factor);
+    std::memcpy(compressed_data.data() + METADATA_BYTES, &tile_size, TILE_SIZE_BYTES);
+    std::memcpy(compressed_data.data() + ROI_METADATA_BYTES, factors.data(), factors.size());
+
+    uint8_t *dst = compressed_data.data() + ROI_METADATA_BYTES + factors.size();
+    std::vector<uint8_t> tileBuffer(TILE_SIZE * TILE_SIZE * 3);
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int factor = factors[ty * tiles_x + tx];
+            int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE;
+            int tile_width = std::min(TILE_SIZE, original_width - x0);
+            int tile_height = std::min(TILE_SIZE, original_height - y0);
+            int target_width = tile_width / factor;
+            int target_height = tile_height / factor;
+
+            // Gather the tile rows into a contiguous buffer (or straight into the payload at factor 1)
+            uint8_t *tile = factor == 1 ? dst : tileBuffer.data();
+            size_t row_bytes = tile_width * 3;
+            for (int y = 0; y < tile_height; y++) {
+                std::memcpy(tile + y * row_bytes, frame.data.data() + ((y0 + y) * original_width + x0) * 3,
+                            row_bytes);
+            }
+            if (factor > 1)
+                downsampleBilinear(tile, dst, tile_width, tile_height, target_width, target_height);
+            dst += target_width * target_height * 3;
+        }
+    }
+
+    double ratio = static_cast<double>(frame.data.size()) / compressed_data.size();
+    m_stats.frames_compressed++;
+    m_stats.average_compression_ratio =
+        ((m_stats.average_compression_ratio * (m_stats.frames_compressed - 1)) + ratio) /
+        m_stats.frames_compressed;
+    m_roi_tile_ratio = ((m_roi_tile_ratio * (m_stats.frames_compressed - 1)) +
+                        static_cast<double>(roi_tiles) / factors.size()) /
+                       m_stats.frames_compressed;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    m_stats.total_compression_time_ms += elapsed_ms;
+
+    return compressed_data;
+}
+
+/**
+ * @brief Decompress a video frame. Every tile is upsampled with its own recorded factor and placed back
+ *  into the full resolution frame. The size the header and the tile factors imply is checked before any
+ *  sample is read; a truncated or corrupt payload returns an empty frame and sets the last error.
+ */
+Frame ROIDownsampleAlgorithm::decompressFrame(const std::vector<uint8_t> &compressed_data) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    m_last_error = CompressionError();
+    if (compressed_data.size() < ROI_METADATA_BYTES) {
+        m_last_error = CompressionError("ROI payload is truncated");
+        return Frame();
+    }
+
+    int original_width, original_height, background_factor;
+    uint16_t tile_size;
+    readMetadata(compressed_data.data(), original_width, original_height, background_factor);
+    std::memcpy(&tile_size, compressed_data.data() + METADATA_BYTES, TILE_SIZE_BYTES);
+    if (original_width <= 0 || original_height <= 0 || tile_size == 0) {
+        m_last_error = CompressionError("ROI payload is corrupt");
+        return Frame();
+    }
+
+    int tiles_x = (original_width + tile_size - 1) / tile_size;
+    int tiles_y = (original_height + tile_size - 1) / tile_size;
+    size_t tiles = static_cast<size_t>(tiles_x) * tiles_y;
+    if (compressed_data.size() < ROI_METADATA_BYTES + tiles) {
+        m_last_error = CompressionError("ROI payload is truncated");
+        return Frame();
+    }
+    const uint8_t *factors = compressed_data.data() + ROI_METADATA_BYTES;
+    size_t samples_size = 0;
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int factor = factors[ty * tiles_x + tx];
+            if (factor == 0) {
+                m_last_error = CompressionError("ROI payload is corrupt");
+                return Frame();
+            }
+            int tile_width = std::min<int>(tile_size, original_width - tx * tile_size);
+            int tile_height = std::min<int>(tile_size, original_height - ty * tile_size);
+            samples_size += static_cast<size_t>(tile_width / factor) * (tile_height / factor) * 3;
+        }
+    }
+    if (compressed_data.size() < ROI_METADATA_BYTES + tiles + samples_size) {
+        m_last_error = CompressionError("ROI payload is truncated");
+        return Frame();
+    }
+    const uint8_t *src = factors + tiles;
+
+    Frame decompressed_frame(original_width, original_height);
+    decompressed_frame.data.resize(original_width * original_height * 3);
+    decompressed_frame.type = KEY_FRAME;
+
+    std::vector<uint8_t> tileBuffer(tile_size * tile_size * 3);
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int factor = factors[ty * tiles_x + tx];
+            int x0 = tx * tile_size, y0 = ty * tile_size;
+            int tile_width = std::min<int>(tile_size, original_width - x0);
+            int tile_height = std::min<int>(tile_size, original_height - y0);
+            int downsampled_width = tile_width / factor;
+            int downsampled_height = tile_height / factor;
+
+            // An edge tile narrower than its factor has no samples; it stays black
+            if (downsampled_width == 0 || downsampled_height == 0) continue;
+            const uint8_t *tile = src;
+            if (factor > 1) {
+                upsampleBilinear(src, tileBuffer.data(), downsampled_width, downsampled_height, tile_width,
+                                 tile_height);
+                tile = tileBuffer.data();
+            }
+            size_t row_bytes = tile_width * 3;
+            for (int y = 0; y < tile_height; y++) {
+                std::memcpy(decompressed_frame.data.data() + ((y0 + y) * original_width + x0) * 3,
+                            tile + y * row_bytes, row_bytes);
+            }
+            src += downsampled_width * downsampled_height * 3;
+        }
+    }
+
+    m_stats.frames_decompressed++;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    m_stats.total_decompression_time_ms += elapsed_ms;
+
+    return decompressed_frame;
+}
+
+/**
+ * @brief The tile factors are header; the tile samples follow them back to back. Payloads only predict
+ *  each other when their factor maps match, which is checked by comparing the headers.
+ */
+bool ROIDownsampleAlgorithm::describePayload(const std::vector<uint8_t> &compressed_data,
+                                             PayloadLayout &layout) const {
+    if (compressed_data.size() < ROI_METADATA_BYTES) return false;
+    int original_width, original_height, background_factor;
+    uint16_t tile_size;
+    readMetadata(compressed_data.data(), original_width, original_height, background_factor);
+    std::memcpy(&tile_size, compressed_data.data() + METADATA_BYTES, TILE_SIZE_BYTES);
+    if (tile_size == 0) return false;
+
+    size_t tiles = static_cast<size_t>((original_width + tile_size - 1) / tile_size) *
+                   ((original_height + tile_size - 1) / tile_size);
+    if (compressed_data.size() < ROI_METADATA_BYTES + tiles) return false;
+
+    layout.header_bytes = ROI_METADATA_BYTES + tiles;
+    layout.sample_bytes = compressed_data.size() - layout.header_bytes;
+    layout.width = 0; // Tiles have different sizes, there is no single sample plane
+    layout.height = 0;
+    layout.channels = 3;
+    return true;
+}
+
+/**
+ * @brief Print the m_stats and the tile factor configuration
+ */
+std::string ROIDownsampleAlgorithm::getStats() const {
+    std::stringstream ss;
+    ss << BilinearDownsampleAlgorithm::getStats() << "  ROI tile factor: " << m_roi_factor << std::endl
+       << "  Background tile factor: " << m_background_factor << std::endl
+       << "  Average share of ROI tiles: " << (m_roi_tile_ratio * 100.0) << " %" << std::endl;
+    return ss.str();
+}
+
+} // namespace algorithm
+} // namespace vcompress
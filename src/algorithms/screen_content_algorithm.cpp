@@ -0,0 +1,421 @@
+#include "algorithms/screen_content_algorithm.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace vcompress {
+namespace algorithm {
+
+static const uint32_t NO_COLOR = 0xFFFFFFFFu; // Packed colors only use the low 24 bits
+
+static inline uint32_t packColor(const uint8_t *pixel) {
+    return static_cast<uint32_t>(pixel[0]) | static_cast<uint32_t>(pixel[1]) << 8 |
+           static_cast<uint32_t>(pixel[2]) << 16;
+}
+
+/// @brief Palette slot of a color (-1 if absent); a fixed trip count over all slots vectorizes
+template <int Slots> static inline int findColor(const uint32_t *palette, uint32_t color) {
+    int found = -1;
+    for (int i = Slots - 1; i >= 0; i--) {
+        if (palette[i] == color) found = i;
+    }
+    return found;
+}
+
+/// @brief Bits per palette index
+static inline int indexBits(int colors) {
+    int bits = 0;
+    while ((1 << bits) < colors) bits++;
+    return bits;
+}
+
+/// @brief 64-bit hash of a tile's pixels and size, word at a time
+static uint64_t tileHash(const uint8_t *frame, int width, int x0, int y0, int tile_width, int tile_height) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(tile_width) << 32 | tile_height);
+    size_t row_bytes = static_cast<size_t>(tile_width) * 3;
+    for (int y = 0; y < tile_height; y++) {
+        const uint8_t *row = frame + (static_cast<size_t>(y0 + y) * width + x0) * 3;
+        size_t i = 0;
+        for (; i + 8 <= row_bytes; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, row + i, 8);
+            hash = (hash ^ word) * 0x100000001B3ull;
+            hash ^= hash >> 29;
+        }
+        for (; i < row_bytes; i++) hash = (hash ^ row[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static bool tilesEqual(const uint8_t *frame, int width, int ax, int ay, int bx, int by, int tile_width,
+                       int tile_height) {
+    for (int y = 0; y < tile_height; y++) {
+        if (std::memcmp(frame + (static_cast<size_t>(ay + y) * width + ax) * 3,
+                        frame + (static_cast<size_t>(by + y) * width + bx) * 3,
+                        static_cast<size_t>(tile_width) * 3) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ScreenContentAlgorithm::ScreenContentAlgorithm() : m_downsample_factor(2) { reset(); }
+
+ScreenContentAlgorithm::~ScreenContentAlgorithm() = default;
+
+/// Reset the algorithm state to initial conditions
+void ScreenContentAlgorithm::reset() {
+    m_stats.frames_compressed = 0;
+    m_stats.frames_decompressed = 0;
+    m_stats.palette_tile_ratio = 0.0;
+    m_stats.copy_tile_ratio = 0.0;
+    m_stats.average_compression_ratio = 0.0;
+    m_stats.total_compression_time_ms = 0.0;
+    m_stats.total_decompression_time_ms = 0.0;
+}
+
+/**
+ * @brief Initialize the screen-content algorithm with configuration
+ *  Natural tiles use the quality derived factor of the downsample algorithms (2-4), raised to the next
+ *  divisor of the tile size so every cell of the downsampled plane lies inside a single tile.
+ */
+bool ScreenContentAlgorithm::initialize(const CompressionConfig &config) {
+    m_config = config;
+    m_downsample_factor = 4 - (m_config.quality / 50);
+    m_downsample_factor = std::max(2, std::min(4, m_downsample_factor)) + m_config.degradation_level;
+    while (TILE_SIZE % m_downsample_factor != 0) m_downsample_factor++;
+    std::cout << "Initialized screen-content algorithm with natural-tile factor: " << m_downsample_factor
+              << std::endl;
+    return true;
+}
+
+/**
+ * @brief Distinct colors of a tile, collected into `palette` (MAX_PALETTE slots, unused ones NO_COLOR)
+ * @return The color count, or MAX_PALETTE + 1 as soon as the tile has too many colors
+ */
+int ScreenContentAlgorithm::countColors(const uint8_t *frame, int width, int x0, int y0, int tile_width,
+                                        int tile_height, uint32_t *palette) {
+    std::fill(palette, palette + MAX_PALETTE, NO_COLOR);
+    int colors = 0;
+    uint32_t last = NO_COLOR;
+    for (int y = 0; y < tile_height; y++) {
+        const uint8_t *row = frame + (static_cast<size_t>(y0 + y) * width + x0) * 3;
+        for (int x = 0; x < tile_width; x++) {
+            uint32_t color = packColor(row + x * 3);
+            if (color == last) continue; // Screen content is mostly runs of one color
+            last = color;
+            if (findColor<MAX_PALETTE>(palette, color) >= 0) continue;
+            if (colors == MAX_PALETTE) return MAX_PALETTE + 1;
+            palette[colors++] = color;
+        }
+    }
+    return colors;
+}
+
+/**
+ * @brief Palette tile: | colors - 1 (3 bits) | colors (24 bits each) | runs |
+ *  Runs cover the tile in raster order. Each is either | 0 | index | ue(length - 1) | (repeat one index) or
+ *  | 1 | ue(length - 1) | (copy the indices of the row above); the longer of the two is taken.
+ */
+void ScreenContentAlgorithm::encodePaletteTile(utils::BitWriter &writer, const uint8_t *frame, int width,
+                                               int x0, int y0, int tile_width, int tile_height,
+                                               const uint32_t *palette, int colors) {
+    writer.putBits(colors - 1, 3);
+    for (int i = 0; i < colors; i++) writer.putBits(palette[i], 24);
+
+    int pixels = tile_width * tile_height;
+    std::vector<uint8_t> indices(pixels);
+    for (int y = 0; y < tile_height; y++) {
+        const uint8_t *row = frame + (static_cast<size_t>(y0 + y) * width + x0) * 3;
+        for (int x = 0; x < tile_width; x++) {
+            int slot = findColor<MAX_PALETTE>(palette, packColor(row + x * 3));
+            indices[y * tile_width + x] = static_cast<uint8_t>(slot);
+        }
+    }
+
+    int bits = indexBits(colors);
+    for (int p = 0; p < pixels;) {
+        int above = 0;
+        if (p >= tile_width) {
+            while (p + above < pixels && indices[p + above] == indices[p + above - tile_width]) above++;
+        }
+        int run = 1;
+        while (p + run < pixels && indices[p + run] == indices[p]) run++;
+
+        if (above >= run) {
+            writer.putBits(1, 1);
+            writer.putUE(above - 1);
+            p += above;
+        } else {
+            writer.putBits(0, 1);
+            if (bits > 0) writer.putBits(indices[p], bits);
+            writer.putUE(run - 1);
+            p += run;
+        }
+    }
+}
+
+/// @brief Decode a palette tile straight into the frame; false if the stream is corrupt
+bool ScreenContentAlgorithm::decodePaletteTile(utils::BitReader &reader, uint8_t *frame, int width, int x0,
+                                               int y0, int tile_width, int tile_height) {
+    uint32_t colors, palette[MAX_PALETTE];
+    if (!reader.getBits(3, colors)) return false;
+    colors++;
+    for (uint32_t i = 0; i < colors; i++) {
+        if (!reader.getBits(24, palette[i])) return false;
+    }
+
+    int pixels = tile_width * tile_height;
+    int bits = indexBits(colors);
+    std::vector<uint8_t> indices(pixels);
+    for (int p = 0; p < pixels;) {
+        uint32_t copy_above, index = 0, length;
+        if (!reader.getBits(1, copy_above)) return false;
+        if (!copy_above && bits > 0 && !reader.getBits(bits, index)) return false;
+        if (!reader.getUE(length)) return false;
+        length++;
+        if (index >= colors || length > static_cast<uint32_t>(pixels - p)) return false;
+        if (copy_above && p < tile_width) return false;
+        for (uint32_t i = 0; i < length; i++, p++) {
+            indices[p] = copy_above ? indices[p - tile_width] : static_cast<uint8_t>(index);
+        }
+    }
+
+    for (int y = 0; y < tile_height; y++) {
+        uint8_t *row = frame + (static_cast<size_t>(y0 + y) * width + x0) * 3;
+        for (int x = 0; x < tile_width; x++) {
+            uint32_t color = palette[indices[y * tile_width + x]];
+            row[x * 3] = static_cast<uint8_t>(color);
+            row[x * 3 + 1] = static_cast<uint8_t>(color >> 8);
+            row[x * 3 + 2] = static_cast<uint8_t>(color >> 16);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compress a video frame: classify the tiles, code palette and copy tiles, keep natural cells
+ */
+std::vector<uint8_t> ScreenContentAlgorithm::compressFrame(const Frame &frame) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    int width = frame.width, height = frame.height, factor = m_downsample_factor;
+    const uint8_t *pixels = frame.data.data();
+
+    int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    std::vector<uint8_t> modes(tiles_x * tiles_y, NATURAL);
+    std::vector<uint8_t> stream;
+    int palette_tiles = 0, copy_tiles = 0;
+    {
+        utils::BitWriter writer(stream);
+        std::unordered_map<uint64_t, int> seen; // Hash of a palette tile -> its index
+        uint32_t palette[MAX_PALETTE];
+        for (int ty = 0; ty < tiles_y; ty++) {
+            for (int tx = 0; tx < tiles_x; tx++) {
+                int index = ty * tiles_x + tx;
+                int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE;
+                int tile_width = std::min(TILE_SIZE, width - x0);
+                int tile_height = std::min(TILE_SIZE, height - y0);
+                int colors = countColors(pixels, width, x0, y0, tile_width, tile_height, palette);
+                if (colors > MAX_PALETTE) {
+                    writer.putUE(NATURAL);
+                    continue;
+                }
+
+                uint64_t hash = tileHash(pixels, width, x0, y0, tile_width, tile_height);
+                auto source = seen.find(hash);
+                if (source != seen.end() &&
+                    tilesEqual(pixels, width, x0, y0, (source->second % tiles_x) * TILE_SIZE,
+                               (source->second / tiles_x) * TILE_SIZE, tile_width, tile_height)) {
+                    writer.putUE(COPY);
+                    writer.putUE(index - source->second - 1);
+                    modes[index] = COPY;
+                    copy_tiles++;
+                    continue;
+                }
+                seen.emplace(hash, index);
+                writer.putUE(PALETTE);
+                encodePaletteTile(writer, pixels, width, x0, y0, tile_width, tile_height, palette, colors);
+                modes[index] = PALETTE;
+                palette_tiles++;
+            }
+        }
+    }
+
+    // Natural tiles: their cells of the area-downsampled plane, in raster order of the plane
+    const cv::Mat original_mat(height, width, CV_8UC3, const_cast<uint8_t *>(pixels));
+    cv::Mat downsampled_mat;
+    cv::resize(original_mat, downsampled_mat, cv::Size(width / factor, height / factor), 0, 0,
+               cv::INTER_AREA);
+    std::vector<uint8_t> compressed_data(METADATA_BYTES);
+    uint32_t stream_bytes = static_cast<uint32_t>(stream.size());
+    std::memcpy(compressed_data.data(), &width, 4);
+    std::memcpy(compressed_data.data() + 4, &height, 4);
+    compressed_data[8] = static_cast<uint8_t>(factor);
+    compressed_data[9] = static_cast<uint8_t>(TILE_SIZE);
+    std::memcpy(compressed_data.data() + 10, &stream_bytes, 4);
+    compressed_data.insert(compressed_data.end(), stream.begin(), stream.end());
+    for (int cy = 0; cy < downsampled_mat.rows; cy++) {
+        const uint8_t *row = downsampled_mat.ptr(cy);
+        for (int cx = 0; cx < downsampled_mat.cols; cx++) {
+            if (modes[(cy * factor / TILE_SIZE) * tiles_x + cx * factor / TILE_SIZE] != NATURAL) continue;
+            compressed_data.insert(compressed_data.end(), row + cx * 3, row + cx * 3 + 3);
+        }
+    }
+
+    m_stats.frames_compressed++;
+    double tiles = static_cast<double>(tiles_x) * tiles_y;
+    double ratio = static_cast<double>(frame.data.size()) / compressed_data.size();
+    int frames = m_stats.frames_compressed;
+    m_stats.average_compression_ratio += (ratio - m_stats.average_compression_ratio) / frames;
+    m_stats.palette_tile_ratio += (palette_tiles / tiles - m_stats.palette_tile_ratio) / frames;
+    m_stats.copy_tile_ratio += (copy_tiles / tiles - m_stats.copy_tile_ratio) / frames;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    m_stats.total_compression_time_ms +=
+        std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    return compressed_data;
+}
+
+/**
+ * @brief Decompress a video frame
+ *  Palette and copy tiles are decoded at full resolution first. Their cells of the downsampled plane are
+ *  then rebuilt by area averaging, so the bilinear upsample of the plane sees the same neighbors across
+ *  tile borders as it did on the encoder side, and the natural tiles are taken from the upsampled plane.
+ */
+Frame ScreenContentAlgorithm::decompressFrame(const std::vector<uint8_t> &compressed_data) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    m_last_error = CompressionError();
+    if (compressed_data.size() < METADATA_BYTES) {
+        m_last_error = CompressionError("Screen-content payload is truncated");
+        return Frame();
+    }
+
+    int width, height;
+    uint32_t stream_bytes;
+    std::memcpy(&width, compressed_data.data(), 4);
+    std::memcpy(&height, compressed_data.data() + 4, 4);
+    int factor = compressed_data[8], tile_size = compressed_data[9];
+    std::memcpy(&stream_bytes, compressed_data.data() + 10, 4);
+
+    Frame decompressed_frame(width, height);
+    decompressed_frame.data.assign(static_cast<size_t>(width) * height * 3, 128);
+    if (factor == 0 || tile_size == 0 || tile_size % factor != 0 ||
+        compressed_data.size() < METADATA_BYTES + stream_bytes) {
+        m_last_error = CompressionError("Screen-content payload is corrupt");
+        return decompressed_frame;
+    }
+
+    uint8_t *pixels = decompressed_frame.data.data();
+    int tiles_x = (width + tile_size - 1) / tile_size;
+    int tiles_y = (height + tile_size - 1) / tile_size;
+    std::vector<uint8_t> modes(tiles_x * tiles_y, NATURAL);
+    utils::BitReader reader(compressed_data.data() + METADATA_BYTES, stream_bytes);
+    for (int index = 0; index < tiles_x * tiles_y; index++) {
+        int x0 = (index % tiles_x) * tile_size, y0 = (index / tiles_x) * tile_size;
+        int tile_width = std::min(tile_size, width - x0);
+        int tile_height = std::min(tile_size, height - y0);
+        uint32_t mode, distance;
+        bool valid = reader.getUE(mode);
+        if (valid && mode == PALETTE) {
+            valid = decodePaletteTile(reader, pixels, width, x0, y0, tile_width, tile_height);
+        } else if (valid && mode == COPY) {
+            valid = reader.getUE(distance) && distance < static_cast<uint32_t>(index);
+            int source = valid ? index - static_cast<int>(distance) - 1 : 0;
+            int sx = (source % tiles_x) * tile_size, sy = (source / tiles_x) * tile_size;
+            valid = valid && modes[source] != NATURAL && std::min(tile_size, width - sx) == tile_width &&
+                    std::min(tile_size, height - sy) == tile_height;
+            for (int y = 0; valid && y < tile_height; y++) {
+                std::memcpy(pixels + (static_cast<size_t>(y0 + y) * width + x0) * 3,
+                            pixels + (static_cast<size_t>(sy + y) * width + sx) * 3,
+                            static_cast<size_t>(tile_width) * 3);
+            }
+        } else if (valid && mode != NATURAL) {
+            valid = false;
+        }
+        if (!valid) {
+            m_last_error = CompressionError("Screen-content tile stream is corrupt");
+            return decompressed_frame;
+        }
+        modes[index] = static_cast<uint8_t>(mode);
+    }
+
+    // Rebuild the downsampled plane: stored cells for natural tiles, area averages of decoded tiles otherwise
+    int plane_width = width / factor, plane_height = height / factor;
+    std::vector<uint8_t> plane(static_cast<size_t>(plane_width) * plane_height * 3);
+    const uint8_t *natural = compressed_data.data() + METADATA_BYTES + stream_bytes;
+    const uint8_t *natural_end = compressed_data.data() + compressed_data.size();
+    for (int cy = 0; cy < plane_height; cy++) {
+        for (int cx = 0; cx < plane_width; cx++) {
+            uint8_t *cell = plane.data() + (static_cast<size_t>(cy) * plane_width + cx) * 3;
+            if (modes[(cy * factor / tile_size) * tiles_x + cx * factor / tile_size] == NATURAL) {
+                if (natural_end - natural < 3) {
+                    m_last_error = CompressionError("Screen-content payload is truncated");
+                    return decompressed_frame;
+                }
+                std::memcpy(cell, natural, 3);
+                natural += 3;
+                continue;
+            }
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int y = 0; y < factor; y++) {
+                    const uint8_t *row =
+                        pixels + (static_cast<size_t>(cy * factor + y) * width + cx * factor) * 3;
+                    for (int x = 0; x < factor; x++) sum += row[x * 3 + c];
+                }
+                cell[c] = static_cast<uint8_t>((sum + factor * factor / 2) / (factor * factor));
+            }
+        }
+    }
+
+    if (plane_width > 0 && plane_height > 0) {
+        const cv::Mat downsampled_mat(plane_height, plane_width, CV_8UC3, plane.data());
+        cv::Mat upsampled_mat;
+        cv::resize(downsampled_mat, upsampled_mat, cv::Size(width, height), 0, 0, cv::INTER_LINEAR);
+        for (int index = 0; index < tiles_x * tiles_y; index++) {
+            if (modes[index] != NATURAL) continue;
+            int x0 = (index % tiles_x) * tile_size, y0 = (index / tiles_x) * tile_size;
+            size_t row_bytes = static_cast<size_t>(std::min(tile_size, width - x0)) * 3;
+            for (int y = y0; y < std::min(height, y0 + tile_size); y++) {
+                std::memcpy(pixels + (static_cast<size_t>(y) * width + x0) * 3, upsampled_mat.ptr(y) + x0 * 3,
+                            row_bytes);
+            }
+        }
+    }
+    m_stats.frames_decompressed++;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    m_stats.total_decompression_time_ms +=
+        std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    return decompressed_frame;
+}
+
+/**
+ * @brief Print the m_stats and related information about the screen-content algorithm
+ */
+std::string ScreenContentAlgorithm::getStats() const {
+    std::stringstream ss;
+    ss << "ScreenContent Algorithm Statistics:" << std::endl
+       << "  Natural tile factor: " << m_downsample_factor << std::endl
+       << "  Frames compressed: " << m_stats.frames_compressed << std::endl
+       << "  Frames decompressed: " << m_stats.frames_decompressed << std::endl
+       << "  Palette tiles: " << m_stats.palette_tile_ratio * 100.0 << "%" << std::endl
+       << "  Copied tiles: " << m_stats.copy_tile_ratio * 100.0 << "%" << std::endl
+       << "  Average compression ratio: " << m_stats.average_compression_ratio << ":1" << std::endl;
+    if (m_stats.frames_compressed > 0) {
+        ss << "  Average compression time: "
+           << (m_stats.total_compression_time_ms / m_stats.frames_compressed) << " ms" << std::endl;
+    }
+    if (m_stats.frames_decompressed > 0) {
+        ss << "  Average decompression time: "
+           << (m_stats.total_decompression_time_ms / m_stats.frames_decompressed) << " ms" << std::endl;
+    }
+    return ss.str();
+}
+
+} // namespace algorithm
+} // namespace vcompress
@@ -0,0 +1,389 @@
+#include "algorithms/vq_algorithm.hpp"
+#include "algorithms/bilinear_downsample_algorithm.hpp"
+#include "utils/complexity_analyzer.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+namespace vcompress {
+namespace algorithm {
+
+// Mini-batch k-means: a fixed number of passes over pseudo-randomly drawn blocks
+static const int TRAINING_ITERATIONS = 12;
+static const int TRAINING_BATCH = 4096;
+static const int PARALLEL_CHUNK = 1024;
+
+/// @brief Squared distance of two padded vectors; fixed-width lanes let the compiler vectorize the loop
+static inline int squaredDistance(const uint8_t *a, const uint8_t *b, int padded_dim) {
+    int distance = 0;
+    for (int lane = 0; lane < padded_dim; lane += 16) {
+        for (int i = 0; i < 16; i++) {
+            int d = static_cast<int>(a[lane + i]) - static_cast<int>(b[lane + i]);
+            distance += d * d;
+        }
+    }
+    return distance;
+}
+
+/// @brief Index of the nearest codeword and its distance
+static int nearestCodeword(const uint8_t *codebook, int codewords, int padded_dim, const uint8_t *block,
+                           int &distance) {
+    int best = 0;
+    distance = squaredDistance(codebook, block, padded_dim);
+    for (int k = 1; k < codewords && distance > 0; k++) {
+        int d = squaredDistance(codebook + k * padded_dim, block, padded_dim);
+        if (d < distance) {
+            distance = d;
+            best = k;
+        }
+    }
+    return best;
+}
+
+/// @brief Run body(begin, end) over [0, count) in chunks on the pool, or in turn without one
+static void parallelFor(utils::ThreadPool *pool, int count, const std::function<void(int, int)> &body) {
+    utils::ThreadPool::TaskGroup group;
+    for (int begin = 0; begin < count; begin += PARALLEL_CHUNK) {
+        int end = std::min(count, begin + PARALLEL_CHUNK);
+        if (!pool) {
+            body(begin, end);
+            continue;
+        }
+        pool->submit([&body, begin, end]() { body(begin, end); }, &group);
+    }
+    if (pool) pool->wait(group);
+}
+
+/// @brief FNV-1a over the codebook; delta frames name the codebook they were quantized with
+static uint32_t codebookId(const uint8_t *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+VQAlgorithm::VQAlgorithm()
+    : m_downsample_factor(2), m_block_size(2), m_pool(nullptr), m_gop_factor(2), m_codewords(0),
+      m_padded_dim(0), m_codebook_id(0), m_decoder_codebook_id(0), m_tile_size(0) {
+    reset();
+}
+
+VQAlgorithm::~VQAlgorithm() = default;
+
+/// Reset the algorithm state to initial conditions
+void VQAlgorithm::reset() {
+    m_stats.frames_compressed = 0;
+    m_stats.frames_decompressed = 0;
+    m_stats.codebooks_trained = 0;
+    m_stats.average_compression_ratio = 0.0;
+    m_stats.average_distortion = 0.0;
+    m_stats.total_compression_time_ms = 0.0;
+    m_stats.total_decompression_time_ms = 0.0;
+    m_gop_factor = m_downsample_factor;
+    m_codebook.clear();
+    m_codewords = 0;
+    m_codebook_id = 0;
+    m_tiles.clear();
+    m_decoder_codebook_id = 0;
+}
+
+/**
+ * @brief Initialize the VQ algorithm with configuration
+ *  The downsample factor (2-4) follows the quality like the other downsample algorithms; below quality 50
+ *  the blocks grow from 2x2 to 4x4, which quarters the index count.
+ */
+bool VQAlgorithm::initialize(const CompressionConfig &config) {
+    m_config = config;
+    m_downsample_factor = 4 - (m_config.quality / 50);
+    m_downsample_factor = std::max(2, std::min(4, m_downsample_factor)) + m_config.degradation_level;
+    m_block_size = m_config.quality >= 50 ? 2 : 4;
+    m_gop_factor = m_downsample_factor;
+    std::cout << "Initialized VQ algorithm with factor " << m_downsample_factor << " and " << m_block_size
+              << "x" << m_block_size << " blocks" << (m_config.adaptive_factor ? " (adaptive per GOP)" : "")
+              << std::endl;
+    return true;
+}
+
+/// @brief Blocks of the downsampled plane as padded vectors; blocks past the edge repeat its last pixels
+std::vector<uint8_t> VQAlgorithm::extractBlocks(const cv::Mat &plane, int blocks_x, int blocks_y,
+                                                int padded_dim) const {
+    std::vector<uint8_t> blocks(static_cast<size_t>(blocks_x) * blocks_y * padded_dim, 0);
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            uint8_t *block = blocks.data() + (static_cast<size_t>(by) * blocks_x + bx) * padded_dim;
+            for (int y = 0; y < m_block_size; y++) {
+                const uint8_t *row = plane.ptr(std::min(by * m_block_size + y, plane.rows - 1));
+                for (int x = 0; x < m_block_size; x++) {
+                    int px = std::min(bx * m_block_size + x, plane.cols - 1);
+                    std::memcpy(block + (y * m_block_size + x) * 3, row + px * 3, 3);
+                }
+            }
+        }
+    }
+    return blocks;
+}
+
+/**
+ * @brief Mini-batch k-means (Sculley 2010)
+ *  Codewords start as evenly spaced blocks of the frame. Each iteration assigns a batch of blocks to their
+ *  nearest codeword in parallel, then moves every codeword towards its blocks with a per-codeword learning
+ *  rate of 1 / (blocks assigned so far). The batch is drawn with a fixed-seed generator, so identical
+ *  frames train identical codebooks.
+ */
+void VQAlgorithm::trainCodebook(const std::vector<uint8_t> &blocks, int block_count, int padded_dim) {
+    m_codewords = std::min(MAX_CODEWORDS, block_count);
+    m_padded_dim = padded_dim;
+    std::vector<float> centers(static_cast<size_t>(m_codewords) * padded_dim);
+    for (int k = 0; k < m_codewords; k++) {
+        size_t first = static_cast<size_t>(k) * block_count / m_codewords;
+        std::copy(blocks.begin() + first * padded_dim, blocks.begin() + (first + 1) * padded_dim,
+                  centers.begin() + static_cast<size_t>(k) * padded_dim);
+    }
+    m_codebook.resize(centers.size());
+    auto roundCenters = [&]() {
+        for (size_t i = 0; i < centers.size(); i++) {
+            m_codebook[i] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, centers[i] + 0.5f)));
+        }
+    };
+    roundCenters();
+
+    int batch = std::min(block_count, TRAINING_BATCH);
+    std::vector<int> sample(batch), nearest(batch), counts(m_codewords, 0);
+    uint32_t seed = 0x9E3779B9u;
+    for (int iteration = 0; iteration < TRAINING_ITERATIONS; iteration++) {
+        for (int b = 0; b < batch; b++) {
+            seed = seed * 1664525u + 1013904223u;
+            sample[b] = static_cast<int>((seed >> 8) % static_cast<uint32_t>(block_count));
+        }
+        parallelFor(m_pool, batch, [&](int begin, int end) {
+            int distance;
+            for (int b = begin; b < end; b++) {
+                const uint8_t *block = blocks.data() + static_cast<size_t>(sample[b]) * padded_dim;
+                nearest[b] = nearestCodeword(m_codebook.data(), m_codewords, padded_dim, block, distance);
+            }
+        });
+        for (int b = 0; b < batch; b++) {
+            int k = nearest[b];
+            float rate = 1.0f / ++counts[k];
+            float *center = centers.data() + static_cast<size_t>(k) * padded_dim;
+            const uint8_t *block = blocks.data() + static_cast<size_t>(sample[b]) * padded_dim;
+            for (int i = 0; i < padded_dim; i++) center[i] += rate * (block[i] - center[i]);
+        }
+        roundCenters();
+    }
+}
+
+/// @brief Quantize every block in parallel
+/// @return Mean squared error per sample
+double VQAlgorithm::assignBlocks(const std::vector<uint8_t> &blocks, int block_count, uint8_t *indices) {
+    std::vector<int64_t> chunk_errors((block_count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK, 0);
+    parallelFor(m_pool, block_count, [&](int begin, int end) {
+        int64_t error = 0;
+        int distance;
+        for (int b = begin; b < end; b++) {
+            const uint8_t *block = blocks.data() + static_cast<size_t>(b) * m_padded_dim;
+            indices[b] = static_cast<uint8_t>(
+                nearestCodeword(m_codebook.data(), m_codewords, m_padded_dim, block, distance));
+            error += distance;
+        }
+        chunk_errors[begin / PARALLEL_CHUNK] = error;
+    });
+    int64_t total = 0;
+    for (int64_t error : chunk_errors) total += error;
+    return static_cast<double>(total) / (static_cast<double>(block_count) * m_block_size * m_block_size * 3);
+}
+
+/**
+ * @brief Compress a video frame: downsample, train the GOP codebook on key frames, store one index per block
+ */
+std::vector<uint8_t> VQAlgorithm::compressFrame(const Frame &frame) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    int dim = m_block_size * m_block_size * 3;
+    // Codewords are padded to whole lanes, so the distance loops have fixed trip counts and vectorize
+    int padded_dim = (dim + utils::LANE_SAMPLES - 1) / utils::LANE_SAMPLES * utils::LANE_SAMPLES;
+    bool train = frame.type == KEY_FRAME || m_codebook.empty() || padded_dim != m_padded_dim;
+    if (train && m_config.adaptive_factor) {
+        double energy = utils::gradientEnergy(frame.data.data(), frame.width, frame.height);
+        int level = m_config.degradation_level;
+        m_gop_factor = utils::selectDownsampleFactor(energy, m_downsample_factor, 2 + level, 4 + level);
+    }
+    int factor = m_gop_factor;
+
+    const cv::Mat original_mat(frame.height, frame.width, CV_8UC3, const_cast<uint8_t *>(frame.data.data()));
+    cv::Mat downsampled_mat;
+    cv::resize(original_mat, downsampled_mat, cv::Size(frame.width / factor, frame.height / factor), 0, 0,
+               cv::INTER_AREA);
+
+    // The block grid covers the full-resolution frame, so the decoder's tiles reach every output pixel
+    int tile = m_block_size * factor;
+    int blocks_x = (frame.width + tile - 1) / tile;
+    int blocks_y = (frame.height + tile - 1) / tile;
+    int block_count = blocks_x * blocks_y;
+    std::vector<uint8_t> blocks = extractBlocks(downsampled_mat, blocks_x, blocks_y, padded_dim);
+
+    std::vector<uint8_t> codebook;
+    if (train) {
+        trainCodebook(blocks, block_count, padded_dim);
+        codebook.resize(static_cast<size_t>(m_codewords) * dim);
+        for (int k = 0; k < m_codewords; k++) {
+            std::memcpy(codebook.data() + k * dim, m_codebook.data() + k * padded_dim, dim);
+        }
+        m_codebook_id = codebookId(codebook.data(), codebook.size());
+        m_stats.codebooks_trained++;
+    }
+
+    std::vector<uint8_t> compressed_data(METADATA_BYTES + codebook.size() + block_count);
+    uint8_t *header = compressed_data.data();
+    uint16_t codewords = static_cast<uint16_t>(m_codewords);
+    std::memcpy(header, &frame.width, 4);
+    std::memcpy(header + 4, &frame.height, 4);
+    header[8] = static_cast<uint8_t>(factor);
+    header[9] = static_cast<uint8_t>(m_block_size);
+    std::memcpy(header + 10, &codewords, 2);
+    std::memcpy(header + 12, &m_codebook_id, 4);
+    header[16] = train ? 1 : 0;
+    std::copy(codebook.begin(), codebook.end(), compressed_data.begin() + METADATA_BYTES);
+    double distortion = assignBlocks(blocks, block_count, header + METADATA_BYTES + codebook.size());
+
+    m_stats.frames_compressed++;
+    double ratio = static_cast<double>(frame.data.size()) / compressed_data.size();
+    m_stats.average_compression_ratio +=
+        (ratio - m_stats.average_compression_ratio) / m_stats.frames_compressed;
+    m_stats.average_distortion += (distortion - m_stats.average_distortion) / m_stats.frames_compressed;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    m_stats.total_compression_time_ms +=
+        std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    return compressed_data;
+}
+
+/**
+ * @brief Upsample every codeword to a full-resolution tile (bilinear within the block, edges clamped)
+ */
+void VQAlgorithm::expandCodebook(const uint8_t *codebook, int codewords, int block_size, int factor) {
+    m_tile_size = block_size * factor;
+    size_t tile_bytes = static_cast<size_t>(m_tile_size) * m_tile_size * 3;
+    m_tiles.resize(codewords * tile_bytes);
+    for (int k = 0; k < codewords; k++) {
+        const uint8_t *codeword = codebook + k * block_size * block_size * 3;
+        uint8_t *tile = m_tiles.data() + k * tile_bytes;
+        for (int y = 0; y < m_tile_size; y++) {
+            float sy = std::max(0.0f, (y + 0.5f) / factor - 0.5f);
+            auto [y_floor, y_ceil, y_fraction] = calculateInterpolationParams(sy, 1.0f, block_size);
+            if (y_floor >= block_size - 1) y_fraction = 0.0f;
+            for (int x = 0; x < m_tile_size; x++) {
+                float sx = std::max(0.0f, (x + 0.5f) / factor - 0.5f);
+                auto [x_floor, x_ceil, x_fraction] = calculateInterpolationParams(sx, 1.0f, block_size);
+                if (x_floor >= block_size - 1) x_fraction = 0.0f;
+                for (int c = 0; c < 3; c++) {
+                    float top = getPixelValue(codeword, block_size, y_floor, x_floor, c) * (1 - x_fraction) +
+                                getPixelValue(codeword, block_size, y_floor, x_ceil, c) * x_fraction;
+                    float bottom =
+                        getPixelValue(codeword, block_size, y_ceil, x_floor, c) * (1 - x_fraction) +
+                        getPixelValue(codeword, block_size, y_ceil, x_ceil, c) * x_fraction;
+                    tile[(y * m_tile_size + x) * 3 + c] =
+                        static_cast<uint8_t>(top * (1 - y_fraction) + bottom * y_fraction + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Decompress a video frame by copying one pre-upsampled tile per block index
+ *  A delta frame whose codebook was never received (decoding started mid-GOP) decodes to mid-gray and sets
+ *  the last error.
+ */
+Frame VQAlgorithm::decompressFrame(const std::vector<uint8_t> &compressed_data) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    m_last_error = CompressionError();
+    if (compressed_data.size() < METADATA_BYTES) {
+        m_last_error = CompressionError("VQ payload is truncated");
+        return Frame();
+    }
+
+    const uint8_t *header = compressed_data.data();
+    int width, height;
+    uint16_t codewords;
+    uint32_t codebook_id;
+    std::memcpy(&width, header, 4);
+    std::memcpy(&height, header + 4, 4);
+    int factor = header[8], block_size = header[9];
+    std::memcpy(&codewords, header + 10, 2);
+    std::memcpy(&codebook_id, header + 12, 4);
+    bool has_codebook = header[16] != 0;
+
+    Frame decompressed_frame(width, height);
+    decompressed_frame.data.assign(static_cast<size_t>(width) * height * 3, 128);
+    int tile = block_size * factor;
+    size_t codebook_bytes = has_codebook ? static_cast<size_t>(codewords) * block_size * block_size * 3 : 0;
+    int blocks_x = tile > 0 ? (width + tile - 1) / tile : 0;
+    int blocks_y = tile > 0 ? (height + tile - 1) / tile : 0;
+    if (tile == 0 || codewords == 0 ||
+        compressed_data.size() < METADATA_BYTES + codebook_bytes + static_cast<size_t>(blocks_x) * blocks_y) {
+        m_last_error = CompressionError("VQ payload is truncated");
+        return decompressed_frame;
+    }
+
+    if (has_codebook) {
+        expandCodebook(header + METADATA_BYTES, codewords, block_size, factor);
+        m_decoder_codebook_id = codebook_id;
+    } else if (codebook_id != m_decoder_codebook_id || m_tile_size != tile) {
+        m_last_error = CompressionError("VQ codebook of the GOP was not received");
+        return decompressed_frame;
+    }
+
+    const uint8_t *indices = header + METADATA_BYTES + codebook_bytes;
+    size_t tile_bytes = static_cast<size_t>(tile) * tile * 3;
+    size_t max_index = m_tiles.size() / tile_bytes - 1;
+    for (int by = 0; by < blocks_y; by++) {
+        int rows = std::min(tile, height - by * tile);
+        for (int bx = 0; bx < blocks_x; bx++) {
+            size_t index = std::min<size_t>(indices[by * blocks_x + bx], max_index);
+            const uint8_t *source = m_tiles.data() + index * tile_bytes;
+            size_t row_bytes = static_cast<size_t>(std::min(tile, width - bx * tile)) * 3;
+            uint8_t *target =
+                decompressed_frame.data.data() + (static_cast<size_t>(by) * tile * width + bx * tile) * 3;
+            for (int y = 0; y < rows; y++) {
+                std::memcpy(target + static_cast<size_t>(y) * width * 3, source + y * tile * 3, row_bytes);
+            }
+        }
+    }
+    m_stats.frames_decompressed++;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    m_stats.total_decompression_time_ms +=
+        std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    return decompressed_frame;
+}
+
+/**
+ * @brief Print the m_stats and related information about the VQ algorithm
+ */
+std::string VQAlgorithm::getStats() const {
+    std::stringstream ss;
+    ss << "VQ Algorithm Statistics:" << std::endl
+       << "  Downsample factor: " << m_downsample_factor << std::endl
+       << "  Block size: " << m_block_size << "x" << m_block_size << std::endl
+       << "  Frames compressed: " << m_stats.frames_compressed << std::endl
+       << "  Frames decompressed: " << m_stats.frames_decompressed << std::endl
+       << "  Codebooks trained: " << m_stats.codebooks_trained << std::endl
+       << "  Average compression ratio: " << m_stats.average_compression_ratio << ":1" << std::endl
+       << "  Average quantization MSE: " << m_stats.average_distortion << std::endl;
+    if (m_stats.frames_compressed > 0) {
+        ss << "  Average compression time: "
+           << (m_stats.total_compression_time_ms / m_stats.frames_compressed) << " ms" << std::endl;
+    }
+    if (m_stats.frames_decompressed > 0) {
+        ss << "  Average decompression time: "
+           << (m_stats.total_decompression_time_ms / m_stats.frames_decompressed) << " ms" << std::endl;
+    }
+    return ss.str();
+}
+
+} // namespace algorithm
+} // namespace vcompress
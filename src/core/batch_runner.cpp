@@ -0,0 +1,343 @@
+#include "core/batch_runner.hpp"
+#include "core/ladder_encoder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace vcompress {
+namespace core {
+
+// Frames an encoder holds at once besides the held back ones: input, previous anchor, reconstruction
+static const int ENCODER_RESIDENT_FRAMES = 3;
+// Frames a decoder holds at once: output, references and a few reordered frames
+static const int DECODER_RESIDENT_FRAMES = 6;
+
+BatchRunner::BatchRunner() : m_runningJobs(0), m_reservedMemory(0) {
+    m_stats.jobsSucceeded = 0;
+    m_stats.jobsFailed = 0;
+    m_stats.peakReservedMemory = 0;
+    m_stats.totalProcessingTime = 0.0;
+}
+
+BatchRunner::~BatchRunner() = default;
+
+/// @brief Optional manifest fields keep their defaults when missing
+static void readField(const cv::FileNode &node, const char *key, std::string &value) {
+    cv::read(node[key], value, value);
+}
+
+static void readField(const cv::FileNode &node, const char *key, int &value) {
+    cv::read(node[key], value, value);
+}
+
+static void readField(const cv::FileNode &node, const char *key, bool &value) {
+    int flag = value ? 1 : 0;
+    cv::read(node[key], flag, flag);
+    value = flag != 0;
+}
+
+bool BatchRunner::parseJob(const cv::FileNode &node, BatchJob &job, std::string &error) {
+    readField(node, "id", job.id);
+    readField(node, "mode", job.mode);
+    readField(node, "input", job.input);
+    readField(node, "output", job.output);
+    readField(node, "algorithm", job.algorithmName);
+    readField(node, "quality", job.quality);
+    readField(node, "key_frame_interval", job.keyFrameInterval);
+    readField(node, "temporal", job.temporalFactor);
+    readField(node, "bframes", job.bFrames);
+    readField(node, "intra_refresh", job.intraRefreshPeriod);
+    readField(node, "inter", job.interPrediction);
+    readField(node, "block_coding", job.blockCoding);
+    readField(node, "background", job.backgroundReference);
+    readField(node, "references", job.referenceFrames);
+    readField(node, "adaptive_factor", job.adaptiveFactor);
+    readField(node, "enhance", job.enhancementQuantStep);
+    readField(node, "denoise", job.denoiseStrength);
+    readField(node, "bit_depth", job.bitDepth);
+    readField(node, "film_grain", job.filmGrain);
+    readField(node, "grain", job.synthesizeGrain);
+    readField(node, "base_only", job.baseLayerOnly);
+    readField(node, "sharpen", job.sharpenStrength);
+    readField(node, "deband", job.deband);
+    readField(node, "dither", job.dither);
+    readField(node, "audio", job.audioPath);
+    readField(node, "ladder", job.ladder);
+    readField(node, "gop_cache", job.gopCacheDir);
+    readField(node, "frame_cache", job.frameCacheDir);
+
+    if ((job.mode != "encode" && job.mode != "decode") || job.input.empty() || job.output.empty()) {
+        error = "job " + job.id + " needs a mode (encode/decode), input and output";
+        return false;
+    }
+    job.quality = std::clamp(job.quality, 1, 100);
+    job.temporalFactor = std::clamp(job.temporalFactor, 1, 8);
+    job.bFrames = std::clamp(job.bFrames, 0, 7);
+    job.referenceFrames = std::clamp(job.referenceFrames, 1, 4);
+    job.enhancementQuantStep = std::clamp(job.enhancementQuantStep, 0, 255);
+    job.denoiseStrength = std::clamp(job.denoiseStrength, 0, 10);
+    job.bitDepth = std::clamp(job.bitDepth, 5, 8);
+    job.sharpenStrength = std::clamp(job.sharpenStrength, 0, 10);
+    return true;
+}
+
+bool BatchRunner::loadManifest(const std::string &path) {
+    try {
+        cv::FileStorage manifest(path, cv::FileStorage::READ | cv::FileStorage::FORMAT_JSON);
+        if (!manifest.isOpened()) {
+            std::cerr << "Error: Could not open batch manifest: " << path << std::endl;
+            return false;
+        }
+        cv::FileNode root = manifest.root();
+        int maxMemoryMb = 0;
+        readField(root, "threads", m_config.threads);
+        readField(root, "max_concurrent_jobs", m_config.maxConcurrentJobs);
+        readField(root, "max_memory_mb", maxMemoryMb);
+        readField(root, "results_dir", m_config.resultsDir);
+        m_config.maxMemoryBytes = static_cast<int64_t>(std::max(0, maxMemoryMb)) << 20;
+
+        cv::FileNode jobs = root["jobs"];
+        for (size_t i = 0; i < jobs.size(); i++) {
+            BatchJob job;
+            job.id = "job" + std::to_string(i);
+            std::string error;
+            if (!parseJob(jobs[static_cast<int>(i)], job, error)) {
+                std::cerr << "Error: Invalid batch manifest " << path << ": " << error << std::endl;
+                return false;
+            }
+            m_jobs.push_back(job);
+        }
+    } catch (const cv::Exception &e) {
+        std::cerr << "Error: Invalid batch manifest " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief Frame memory a job keeps resident, from the source (encode) or stream header (decode) size
+int64_t BatchRunner::estimateMemory(const BatchJob &job) const {
+    int64_t frameBytes = 0;
+    int frames = 0;
+    if (job.mode == "encode") {
+        utils::FileReader reader;
+        if (!reader.openFile(job.input)) return 0;
+        frameBytes = static_cast<int64_t>(reader.getWidth()) * reader.getHeight() * 3;
+        frames = ENCODER_RESIDENT_FRAMES + job.bFrames + job.temporalFactor;
+        if (!job.gopCacheDir.empty()) frames += job.keyFrameInterval; // A whole GOP is hashed before coding
+        if (!job.ladder.empty()) frames *= 1 + std::count(job.ladder.begin(), job.ladder.end(), ',');
+    } else {
+        utils::CompressedFormat format;
+        if (!format.openForReading(job.input)) return 0;
+        frameBytes = static_cast<int64_t>(format.getOriginalWidth()) * format.getOriginalHeight() * 3;
+        frames = DECODER_RESIDENT_FRAMES;
+    }
+    return frameBytes * frames;
+}
+
+/// @brief Wait for a job slot and room in the memory budget; a job over the whole budget runs alone
+void BatchRunner::admit(int64_t memory) {
+    std::unique_lock<std::mutex> lock(m_admissionMutex);
+    m_admissionChanged.wait(lock, [&]() {
+        if (m_runningJobs == 0) return true;
+        bool slotFree = m_runningJobs < m_config.maxConcurrentJobs;
+        bool memoryFits =
+            m_config.maxMemoryBytes == 0 || m_reservedMemory + memory <= m_config.maxMemoryBytes;
+        return slotFree && memoryFits;
+    });
+    m_runningJobs++;
+    m_reservedMemory += memory;
+    m_stats.peakReservedMemory = std::max(m_stats.peakReservedMemory, m_reservedMemory);
+}
+
+void BatchRunner::retire(int64_t memory, bool success) {
+    {
+        std::lock_guard<std::mutex> lock(m_admissionMutex);
+        m_runningJobs--;
+        m_reservedMemory -= memory;
+        (success ? m_stats.jobsSucceeded : m_stats.jobsFailed)++;
+    }
+    m_admissionChanged.notify_all();
+}
+
+/// @brief Create the shared pool on first use, once the limits are final
+void BatchRunner::startPool() {
+    if (m_pool) return;
+    m_pool = std::make_unique<utils::ThreadPool>(std::max(0, m_config.threads));
+    if (m_config.maxConcurrentJobs <= 0) m_config.maxConcurrentJobs = static_cast<int>(m_pool->size());
+}
+
+/**
+ * @brief Admission happens on the calling thread, so pool workers never block on it; an admitted job
+ *  becomes one pool task and its own parallel work is stolen by whichever workers are idle.
+ */
+void BatchRunner::submit(const BatchJob &job, ProgressCallback onProgress, CompletionCallback onComplete) {
+    startPool();
+    int64_t memory = estimateMemory(job);
+    admit(memory);
+    m_pool->submit(
+        [this, job, memory, onProgress = std::move(onProgress), onComplete = std::move(onComplete)]() {
+            BatchResult result;
+            runJob(job, onProgress, result);
+            writeResult(job, result);
+            retire(memory, result.success);
+            if (onComplete) onComplete(result);
+        },
+        &m_running);
+}
+
+void BatchRunner::wait() {
+    if (m_pool) m_pool->wait(m_running);
+}
+
+/// @brief Dispatch the manifest's jobs in order
+bool BatchRunner::run() {
+    if (m_jobs.empty()) {
+        std::cerr << "Error: The batch manifest lists no jobs" << std::endl;
+        return false;
+    }
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    startPool();
+    std::cout << "Running " << m_jobs.size() << " jobs, up to " << m_config.maxConcurrentJobs
+              << " at once on " << m_pool->size() << " threads" << std::endl;
+    for (const auto &job : m_jobs) submit(job);
+    wait();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    m_stats.totalProcessingTime = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << getStats() << std::endl;
+    return m_stats.jobsFailed == 0;
+}
+
+void BatchRunner::runJob(const BatchJob &job, const ProgressCallback &onProgress, BatchResult &result) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::cout << "[" << job.id << "] " << job.mode << " " << job.input << " -> " << job.output << std::endl;
+
+    if (!algorithm::AlgorithmFactory::isAlgorithmAvailable(job.algorithmName)) {
+        result.error = "algorithm '" + job.algorithmName + "' is not available";
+    } else {
+        result.success = job.mode == "encode" ? runEncode(job, onProgress, result)
+                                              : runDecode(job, onProgress, result);
+        if (!result.success && result.error.empty()) result.error = job.mode + " failed";
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    result.seconds = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << "[" << job.id << "] " << (result.success ? "done" : "failed: " + result.error) << " in "
+              << result.seconds << "s" << std::endl;
+}
+
+bool BatchRunner::runEncode(const BatchJob &job, const ProgressCallback &onProgress, BatchResult &result) {
+    EncoderConfig config(job.input, job.output, job.algorithmName, job.quality, 0, job.keyFrameInterval,
+                         false, !job.audioPath.empty(), false);
+    config.compressedDataPath = job.output;
+    config.tempAudioPath = job.audioPath;
+    config.temporalFactor = job.temporalFactor;
+    config.bFrames = job.bFrames;
+    config.intraRefreshPeriod = job.intraRefreshPeriod;
+    config.interPrediction = job.interPrediction;
+    config.blockCoding = job.blockCoding;
+    config.backgroundReference = job.backgroundReference;
+    config.referenceFrames = job.referenceFrames;
+    config.adaptiveFactor = job.adaptiveFactor;
+    config.gopCacheDir = job.gopCacheDir;
+    config.frameCacheDir = job.frameCacheDir;
+    config.enhancementQuantStep = job.enhancementQuantStep;
+    config.denoiseStrength = job.denoiseStrength;
+    config.bitDepth = job.bitDepth;
+    config.filmGrain = job.filmGrain;
+
+    if (!job.ladder.empty()) {
+        LadderConfig ladderConfig;
+        ladderConfig.base = config;
+        if (!LadderEncoder::parseRungs(job.ladder, job.quality, ladderConfig.rungs)) {
+            result.error = "invalid ladder '" + job.ladder + "'";
+            return false;
+        }
+        LadderEncoder ladder;
+        ladder.setThreadPool(m_pool.get());
+        if (!ladder.configure(ladderConfig) || !ladder.encode()) return false;
+        result.frames = ladder.getFramesDecoded();
+        return true;
+    }
+
+    VideoEncoder encoder;
+    encoder.setBufferPool(&m_bufferPool);
+    encoder.setThreadPool(m_pool.get());
+    if (onProgress) encoder.setProgressCallback(onProgress);
+    if (!encoder.configure(config) || !encoder.encode()) return false;
+    result.frames = encoder.getFramesProcessed();
+    result.inputBytes = encoder.getTotalInputSize();
+    result.outputBytes = encoder.getTotalOutputSize();
+    return true;
+}
+
+bool BatchRunner::runDecode(const BatchJob &job, const ProgressCallback &onProgress, BatchResult &result) {
+    // The input stream belongs to the manifest, so it is kept like the caller's audio track
+    DecoderConfig config(job.input, job.output, job.algorithmName, job.quality, !job.audioPath.empty(), true);
+    config.compressedDataPath = job.input;
+    config.tempVideoPath = job.output + ".tmp.mp4";
+    config.tempAudioPath = job.audioPath;
+    config.baseLayerOnly = job.baseLayerOnly;
+    config.synthesizeGrain = job.synthesizeGrain;
+    config.sharpenStrength = job.sharpenStrength;
+    config.deband = job.deband;
+    config.dither = job.dither;
+
+    VideoDecoder decoder;
+    decoder.setThreadPool(m_pool.get());
+    if (onProgress) decoder.setProgressCallback(onProgress);
+    if (!decoder.configure(config) || !decoder.decode()) return false;
+    result.frames = decoder.getFramesProcessed();
+    result.inputBytes = decoder.getTotalInputSize();
+    result.outputBytes = decoder.getTotalOutputSize();
+    return true;
+}
+
+std::string BatchRunner::formatResult(const BatchJob &job, const BatchResult &result) {
+    int flags = cv::FileStorage::WRITE | cv::FileStorage::MEMORY | cv::FileStorage::FORMAT_JSON;
+    cv::FileStorage report(".json", flags);
+    report.write("id", job.id);
+    report.write("mode", job.mode);
+    report.write("input", job.input);
+    report.write("output", job.output);
+    report.write("status", std::string(result.success ? "ok" : "failed"));
+    report.write("error", result.error);
+    report.write("frames", result.frames);
+    report.write("input_bytes", static_cast<double>(result.inputBytes));
+    report.write("output_bytes", static_cast<double>(result.outputBytes));
+    report.write("compression_ratio",
+                 result.outputBytes > 0 ? static_cast<double>(result.inputBytes) / result.outputBytes : 0.0);
+    report.write("seconds", result.seconds);
+    return report.releaseAndGetString();
+}
+
+/// @brief <results dir>/<job id>.json
+void BatchRunner::writeResult(const BatchJob &job, const BatchResult &result) const {
+    if (m_config.resultsDir.empty()) return;
+    std::string path = m_config.resultsDir + "/" + job.id + ".json";
+    try {
+        std::ofstream file(path);
+        if (!(file << formatResult(job, result))) {
+            std::cerr << "Error: Could not write job result: " << path << std::endl;
+        }
+    } catch (const cv::Exception &e) {
+        std::cerr << "Error: Could not write job result " << path << ": " << e.what() << std::endl;
+    }
+}
+
+std::string BatchRunner::getStats() const {
+    std::stringstream ss;
+    ss << "Batch Statistics:" << std::endl
+       << "  Jobs: " << m_jobs.size() << " (" << m_stats.jobsSucceeded << " succeeded, " << m_stats.jobsFailed
+       << " failed)" << std::endl
+       << "  Peak reserved frame memory: " << (m_stats.peakReservedMemory >> 20) << " MB" << std::endl
+       << "  Cached buffers: " << (m_bufferPool.cachedBytes() >> 20) << " MB" << std::endl
+       << "  Total processing time: " << m_stats.totalProcessingTime << " seconds";
+    return ss.str();
+}
+
+} // namespace core
+} // namespace vcompress
@@ -1,4 +1,7 @@
 #include "core/decoder.hpp"
+#include "utils/enhancement_layer.hpp"
+#include "utils/motion.hpp"
+#include "utils/reference_buffer.hpp"
 #include <chrono>
 #include <cstdlib>
 #include <iostream>
@@ -10,13 +13,19 @@ namespace core {
 /// @brief Constructor
 VideoDecoder::VideoDecoder()
     : m_fileWriter(std::make_unique<vcompress::utils::FileWriter>()),
-      m_compressedFormat(std::make_unique<vcompress::utils::CompressedFormat>()) {
+      m_compressedFormat(std::make_unique<vcompress::utils::CompressedFormat>()), m_threadPool(nullptr) {
 
     m_stats.framesProcessed = 0;
+    m_stats.enhancementLayersApplied = 0;
     m_stats.totalInputSize = 0;
     m_stats.totalOutputSize = 0;
     m_stats.averageTimePerFrame = 0.0;
     m_stats.totalProcessingTime = 0.0;
+    m_nextTimestamp = 0;
+    m_recovered = false;
+    m_refreshCount = 0;
+    m_enhancementTimestamp = -1;
+    m_grainActive = false;
 }
 
 /// @brief Destructor
@@ -25,7 +34,15 @@ VideoDecoder::~VideoDecoder() = default;
 /// @brief Configure the decoder
 bool VideoDecoder::configure(const DecoderConfig &config) {
     m_config = config;
-    return createAlgorithm();
+    // Enhancement layers are residuals against the plain base, so they cannot follow post-processing
+    if ((m_config.sharpenStrength > 0 || m_config.deband || m_config.dither) && !m_config.baseLayerOnly) {
+        std::cout << "Post-processing enabled: decoding the base layer only" << std::endl;
+        m_config.baseLayerOnly = true;
+    }
+    if (!createAlgorithm()) return false;
+    m_interCoder = std::make_unique<InterFrameCoder>(m_algorithm.get());
+    m_interCoder->setThreadPool(m_threadPool);
+    return true;
 }
 
 /// @brief Create the decompression algorithm
@@ -38,6 +55,9 @@ bool VideoDecoder::createAlgorithm() {
 
     algorithm::CompressionConfig algoConfig;
     algoConfig.quality = m_config.quality;
+    algoConfig.sharpen_strength = m_config.sharpenStrength;
+    algoConfig.deband = m_config.deband;
+    algoConfig.dither = m_config.dither;
     if (!m_algorithm->initialize(algoConfig)) {
         std::cerr << "Error: Failed to initialize algorithm: " << m_config.algorithmName << std::endl;
         return false;
@@ -94,6 +114,14 @@ bool VideoDecoder::decode() {
     return true;
 }
 
+/// @brief Decode without an output video; see the header
+bool VideoDecoder::decodeFrames(std::function<void(const algorithm::Frame &)> onFrame) {
+    m_frameCallback = std::move(onFrame);
+    bool decoded = processVideo();
+    m_frameCallback = nullptr;
+    return decoded;
+}
+
 bool VideoDecoder::combineVideoWithAudio(const std::string &videoFile, const std::string &audioFile,
                                          const std::string &outputFile) {
     return vcompress::utils::combineVideoAudio(videoFile, audioFile, outputFile);
@@ -114,38 +142,129 @@ bool VideoDecoder::processVideo() {
     std::cout << "Original video dimensions: " << width << "x" << height << std::endl;
     std::cout << "Original video FPS: " << fps << std::endl;
 
-    if (!m_fileWriter->openFile(m_config.tempVideoPath, width, height, fps, fourcc)) {
+    if (!m_frameCallback && !m_fileWriter->openFile(m_config.tempVideoPath, width, height, fps, fourcc)) {
         std::cerr << "Error: Could not create output video: " << m_config.tempVideoPath << std::endl;
         return false;
     }
 
     std::vector<uint8_t> compressedData;
-    bool isKeyFrame;
-    cv::Mat outputFrame;
+    std::vector<uint8_t> payload;
+    uint8_t frameType;
+    int32_t timestamp;
+    algorithm::Frame previousAnchor;
+    std::vector<std::pair<int, std::vector<uint8_t>>> pendingInterpolated;
+    // Reconstructed payloads of the last two anchors, the references of predicted and B-frames, and the
+    // long-term background reference of the current GOP (empty until one is received)
+    std::vector<uint8_t> pastReference, futureReference, background;
+    // The last anchors of the current GOP, which multi-reference records index; the window is as deep as
+    // any encoder's, and each record names how many of them it uses
+    utils::ReferenceBuffer references;
+    double totalFrameTime = 0.0;
+    m_reorderBuffer.clear();
+    m_recovered = false;
+    m_refreshCount = 0;
+    m_enhancementTimestamp = -1;
+    m_grainActive = false;
     auto totalStartTime = std::chrono::high_resolution_clock::now();
 
-    while (m_compressedFormat->readFrame(compressedData, isKeyFrame)) {
-        auto frameStartTime = std::chrono::high_resolution_clock::now();
+    while (m_compressedFormat->readFrame(compressedData, frameType, timestamp)) {
+        // Grain parameters hold until the next set, so they are read even while seeking
+        if (frameType == algorithm::FILM_GRAIN) {
+            m_grainActive = m_config.synthesizeGrain && utils::unpackFilmGrain(compressedData, m_grain);
+            if (m_config.synthesizeGrain && !m_grainActive) {
+                std::cerr << "Warning: Invalid film grain record at " << timestamp << ", no grain"
+                          << std::endl;
+            }
+            continue;
+        }
 
+        // Seeking: records before the target are not decoded at all
+        if (timestamp < m_config.seekFrame) continue;
+
+        auto frameStartTime = std::chrono::high_resolution_clock::now();
         m_stats.totalInputSize += compressedData.size();
-        algorithm::Frame decompressedFrame = m_algorithm->decompressFrame(compressedData);
-        m_stats.totalOutputSize += decompressedFrame.data.size();
 
-        outputFrame = cv::Mat(decompressedFrame.height, decompressedFrame.width, CV_8UC3);
-        std::memcpy(outputFrame.data, decompressedFrame.data.data(), decompressedFrame.data.size());
+        // Enhancement layers wait for the base record that follows them
+        if (frameType == algorithm::ENHANCEMENT_LAYER) {
+            if (!m_config.baseLayerOnly) {
+                m_enhancementTimestamp = timestamp;
+                m_enhancementLayer = compressedData;
+            }
+            continue;
+        }
 
-        m_fileWriter->writeFrame(outputFrame);
+        // A background is coded against the previous one, or against the last anchor when there is none
+        if (frameType == algorithm::BACKGROUND_FRAME) {
+            if (!m_interCoder->decode(compressedData, background.empty() ? &futureReference : &background,
+                                      payload)) {
+                if (m_recovered) {
+                    std::cerr << "Warning: Invalid background at " << timestamp << ", dropped" << std::endl;
+                }
+                background.clear();
+                continue;
+            }
+            background = payload;
+            continue;
+        }
+
+        // Interpolated frames wait for the anchor that follows them
+        if (frameType == algorithm::INTERPOLATED_FRAME) {
+            pendingInterpolated.emplace_back(timestamp, compressedData);
+            continue;
+        }
+
+        if (frameType == algorithm::BIDIRECTIONAL_FRAME) {
+            std::vector<uint8_t> prediction =
+                InterFrameCoder::averagePrediction(pastReference, futureReference);
+            if (!m_interCoder->decode(compressedData, prediction.empty() ? nullptr : &prediction, payload)) {
+                if (m_recovered) {
+                    std::cerr << "Warning: Invalid B-frame at " << timestamp << ", skipped" << std::endl;
+                }
+                continue;
+            }
+            algorithm::Frame decompressedFrame = m_algorithm->decompressFrame(payload);
+            applyEnhancementLayer(decompressedFrame, timestamp);
+            queueOutputFrame(std::move(decompressedFrame), timestamp);
+        } else {
+            if (!m_recovered && reachesRecoveryPoint(frameType, compressedData)) {
+                m_recovered = true;
+                m_nextTimestamp = timestamp;
+                if (timestamp > 0) std::cout << "Output starts at recovery point " << timestamp << std::endl;
+            }
+            if (frameType == algorithm::PREDICTED_FRAME) {
+                InterFrameCoder::ReferenceList window = references.window(references.size());
+                if (!m_interCoder->decode(compressedData, &futureReference, payload,
+                                          background.empty() ? nullptr : &background, &window)) {
+                    if (m_recovered) {
+                        std::cerr << "Warning: Invalid predicted frame at " << timestamp << ", skipped"
+                                  << std::endl;
+                    }
+                    continue;
+                }
+            } else {
+                payload = compressedData;
+                background.clear();
+                references.clear();
+            }
+            references.push(payload);
+
+            algorithm::Frame decompressedFrame = m_algorithm->decompressFrame(payload);
+            applyEnhancementLayer(decompressedFrame, timestamp);
+            if (!pendingInterpolated.empty()) {
+                writeInterpolatedFrames(pendingInterpolated, previousAnchor, decompressedFrame);
+                pendingInterpolated.clear();
+            }
+            queueOutputFrame(decompressedFrame, timestamp);
+            previousAnchor = std::move(decompressedFrame);
+            pastReference = std::move(futureReference);
+            futureReference = payload;
+        }
 
         auto frameEndTime = std::chrono::high_resolution_clock::now();
-        double frameTime = std::chrono::duration<double, std::milli>(frameEndTime - frameStartTime).count();
-
-        m_stats.framesProcessed++;
-        m_stats.averageTimePerFrame =
-            ((m_stats.averageTimePerFrame * (m_stats.framesProcessed - 1)) + frameTime) /
-            m_stats.framesProcessed;
-        if (m_stats.framesProcessed % 500 == 0)
-            std::cout << "Decompressed " << m_stats.framesProcessed << " frames..." << std::endl;
+        totalFrameTime += std::chrono::duration<double, std::milli>(frameEndTime - frameStartTime).count();
     }
+    drainReorderBuffer(true);
+    if (m_stats.framesProcessed > 0) m_stats.averageTimePerFrame = totalFrameTime / m_stats.framesProcessed;
 
     auto totalEndTime = std::chrono::high_resolution_clock::now();
     m_stats.totalProcessingTime = std::chrono::duration<double>(totalEndTime - totalStartTime).count();
@@ -157,6 +276,103 @@ bool VideoDecoder::processVideo() {
     return true;
 }
 
+/// @brief Rebuild the frames dropped by temporal downsampling from the two anchors around them
+void VideoDecoder::writeInterpolatedFrames(const std::vector<std::pair<int, std::vector<uint8_t>>> &records,
+                                           const algorithm::Frame &previousAnchor,
+                                           const algorithm::Frame &nextAnchor) {
+    algorithm::Frame frame(nextAnchor.width, nextAnchor.height);
+    frame.data.resize(nextAnchor.data.size());
+    frame.type = algorithm::INTERPOLATED_FRAME;
+
+    for (const auto &[timestamp, record] : records) {
+        int width, height, position, span;
+        utils::MotionField forward, backward;
+        if (previousAnchor.data.size() != nextAnchor.data.size() ||
+            !utils::unpackInterpolatedFrame(record, width, height, position, span, forward, backward) ||
+            width != nextAnchor.width || height != nextAnchor.height) {
+            std::cerr << "Warning: Invalid interpolated frame, repeating the next anchor" << std::endl;
+            queueOutputFrame(nextAnchor, timestamp);
+            continue;
+        }
+        utils::interpolateFrame(previousAnchor.data.data(), nextAnchor.data.data(), forward, backward,
+                                static_cast<float>(position) / span, frame.data.data(), width, height);
+        queueOutputFrame(frame, timestamp);
+    }
+}
+
+/**
+ * @brief Refine a decoded base frame with the enhancement layer written before its record, if any
+ *  The layer is consumed either way; a layer of a skipped base record never applies to a later frame.
+ */
+void VideoDecoder::applyEnhancementLayer(algorithm::Frame &frame, int timestamp) {
+    if (m_enhancementTimestamp != timestamp) return;
+    m_enhancementTimestamp = -1;
+    if (frame.data.size() == static_cast<size_t>(frame.width) * frame.height * 3 &&
+        utils::applyEnhancementLayer(m_enhancementLayer, frame.data.data(), frame.width, frame.height)) {
+        m_stats.enhancementLayersApplied++;
+    } else {
+        std::cerr << "Warning: Invalid enhancement layer at " << timestamp << ", base layer only"
+                  << std::endl;
+    }
+}
+
+/**
+ * @brief Whether decoding an anchor record makes the output clean
+ *  A key frame always does. With intra refresh, every refresh record rewrites one band without reference
+ *  to the others, so the picture is clean after a full cycle of refresh records.
+ */
+bool VideoDecoder::reachesRecoveryPoint(uint8_t frameType, const std::vector<uint8_t> &record) {
+    if (frameType == algorithm::KEY_FRAME) return true;
+    int band, bands;
+    if (frameType != algorithm::PREDICTED_FRAME || !InterFrameCoder::refreshBand(record, band, bands)) {
+        return false;
+    }
+    return ++m_refreshCount >= bands;
+}
+
+/// @brief Hand a decoded frame to the reorder buffer; frames leave it in display order
+void VideoDecoder::queueOutputFrame(algorithm::Frame frame, int timestamp) {
+    // Nothing is shown before the recovery point, nor after its display turn has passed
+    if (!m_recovered || timestamp < m_nextTimestamp) return;
+    if (m_grainActive && frame.data.size() == static_cast<size_t>(frame.width) * frame.height * 3) {
+        m_grainSynthesizer.apply(m_grain, timestamp, frame.data.data(), frame.width, frame.height);
+    }
+    frame.timestamp = timestamp;
+    m_reorderBuffer[timestamp] = std::move(frame);
+    drainReorderBuffer(false);
+}
+
+/**
+ * @brief Write every frame whose display turn has come
+ *  A frame is written once all earlier timestamps are out. The buffer is bounded: if a timestamp never
+ *  arrives (corrupt or dropped record), the gap is skipped once MAX_REORDER_FRAMES frames are waiting.
+ */
+void VideoDecoder::drainReorderBuffer(bool flush) {
+    while (!m_reorderBuffer.empty()) {
+        auto next = m_reorderBuffer.begin();
+        if (!flush && next->first > m_nextTimestamp && m_reorderBuffer.size() <= MAX_REORDER_FRAMES) break;
+        writeOutputFrame(next->second);
+        m_nextTimestamp = next->first + 1;
+        m_reorderBuffer.erase(next);
+    }
+}
+
+/// @brief Write one reconstructed frame to the output video
+void VideoDecoder::writeOutputFrame(const algorithm::Frame &frame) {
+    if (m_frameCallback) {
+        m_frameCallback(frame);
+    } else {
+        cv::Mat outputFrame(frame.height, frame.width, CV_8UC3, const_cast<uint8_t *>(frame.data.data()));
+        m_fileWriter->writeFrame(outputFrame);
+    }
+    m_stats.totalOutputSize += frame.data.size();
+
+    m_stats.framesProcessed++;
+    if (m_progressCallback) m_progressCallback(m_stats.framesProcessed);
+    if (m_stats.framesProcessed % 500 == 0)
+        std::cout << "Decompressed " << m_stats.framesProcessed << " frames..." << std::endl;
+}
+
 /// @brief Get decoding statistics
 std::string VideoDecoder::getStats() const {
     std::stringstream ss;
@@ -168,6 +384,9 @@ std::string VideoDecoder::getStats() const {
        << "  Total output size: " << m_stats.totalOutputSize << " bytes" << std::endl
        << "  Average time per frame: " << m_stats.averageTimePerFrame << " ms" << std::endl
        << "  Total processing time: " << m_stats.totalProcessingTime << " seconds" << std::endl;
+    if (m_stats.enhancementLayersApplied > 0) {
+        ss << "  Enhancement layers applied: " << m_stats.enhancementLayersApplied << std::endl;
+    }
     if (m_algorithm) ss << "Algorithm Statistics:" << std::endl << m_algorithm->getStats();
 
     return ss.str();
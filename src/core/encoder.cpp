@@ -1,22 +1,70 @@
 #include "core/encoder.hpp"
+#include "utils/content_hash.hpp"
+#include "utils/enhancement_layer.hpp"
+#include "utils/film_grain.hpp"
+#include "utils/motion.hpp"
+#include "utils/residual_coder.hpp"
+#include "utils/spin_handoff.hpp"
+#include "utils/thread_affinity.hpp"
+#include <cerrno>
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 
 namespace vcompress {
 namespace core {
 
+// Live mode: hysteresis of the degradation control
+static const int DEGRADE_AFTER_FRAMES = 3;
+static const int RECOVER_AFTER_FRAMES = 120;
+static const int MAX_DEGRADATION_LEVEL = 4;
+
+/// @brief Whether a path names a regular file, as opposed to a capture device or a stream URL
+static bool isRegularFile(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
 /// @brief Constructor
 VideoEncoder::VideoEncoder()
     : m_fileReader(std::make_unique<vcompress::utils::FileReader>()),
-      m_compressedFormat(std::make_unique<vcompress::utils::CompressedFormat>()) {
+      m_compressedFormat(std::make_unique<vcompress::utils::CompressedFormat>()), m_bufferPool(nullptr),
+      m_threadPool(nullptr) {
 
     m_stats.framesProcessed = 0;
     m_stats.totalInputSize = 0;
     m_stats.totalOutputSize = 0;
     m_stats.compressionRatio = 0.0;
+    m_stats.largestFrameSize = 0;
+
+    m_live.budgetMs = 0.0;
+    m_live.lastMs = 0.0;
+    m_live.averageMs = 0.0;
+    m_live.maxMs = 0.0;
+    m_live.frames = 0;
+    m_live.framesOverBudget = 0;
+    m_live.overBudgetStreak = 0;
+    m_live.underBudgetStreak = 0;
+    m_live.degradationLevel = 0;
+    m_live.targetLevel = 0;
     m_stats.averageTimePerFrame = 0.0;
     m_stats.totalProcessingTime = 0.0;
+    m_stats.gopCacheHits = 0;
+    m_stats.gopCacheMisses = 0;
+    m_stats.enhancementBytes = 0;
+    m_stats.denoiseTimeMs = 0.0;
+    m_stats.filmGrainRecords = 0;
+    m_stats.backgroundRecords = 0;
+    m_anchorsSinceBackground = 0;
+    m_capturingGop = false;
+    m_gopRecordCount = 0;
+    m_gopStartTimestamp = 0;
 }
 
 /// @brief Destructor
@@ -25,7 +73,111 @@ VideoEncoder::~VideoEncoder() = default;
 /// @brief Configure the encoder
 bool VideoEncoder::configure(const EncoderConfig &config) {
     m_config = config;
-    return createAlgorithm();
+    m_config.temporalFactor = std::max(1, m_config.temporalFactor);
+    m_config.bFrames = std::max(0, m_config.bFrames);
+    m_config.intraRefreshPeriod = std::max(0, m_config.intraRefreshPeriod);
+    if (m_config.liveMode) {
+        // No lookahead: every frame is coded as soon as it is captured
+        m_config.bFrames = 0;
+        m_config.temporalFactor = 1;
+    }
+    m_config.referenceFrames = std::clamp(m_config.referenceFrames, 1, utils::ReferenceBuffer::MAX_FRAMES);
+    if (m_config.bFrames > 0 || m_config.intraRefreshPeriod > 0 || m_config.blockCoding ||
+        m_config.backgroundReference || m_config.referenceFrames > 1) {
+        m_config.interPrediction = true;
+    }
+    if (m_config.bFrames > 0 && m_config.temporalFactor > 1) {
+        std::cerr << "Error: Temporal downsampling and B-frames cannot be combined" << std::endl;
+        return false;
+    }
+    if (m_config.intraRefreshPeriod > 0 && (m_config.bFrames > 0 || m_config.temporalFactor > 1)) {
+        std::cerr << "Error: Intra refresh codes every frame in display order; it cannot be combined with "
+                     "B-frames or temporal downsampling"
+                  << std::endl;
+        return false;
+    }
+    if (m_config.backgroundReference && m_config.intraRefreshPeriod > 0) {
+        std::cerr << "Error: The background reference is dropped at key frames; it cannot be combined with "
+                     "intra refresh"
+                  << std::endl;
+        return false;
+    }
+    if (m_config.referenceFrames > 1 && m_config.intraRefreshPeriod > 0) {
+        std::cerr << "Error: A decoder joining at a refresh point has no older anchors; multiple references "
+                     "cannot be combined with intra refresh"
+                  << std::endl;
+        return false;
+    }
+    if (m_config.resume && m_config.intraRefreshPeriod > 0) {
+        // Checkpoints are taken before key frames, and intra refresh has none after the first frame
+        std::cerr << "Error: An intra refresh stream has no checkpoints to resume from; --resume cannot be "
+                     "combined with intra refresh"
+                  << std::endl;
+        return false;
+    }
+    if (m_config.bitDepth < 8 && m_config.interPrediction) {
+        // A bit-packed plane has no payload layout, so every inter record would fall back to raw
+        std::cerr << "Error: Inter prediction (and B-frames, intra refresh, block coding, the background "
+                     "reference and multiple references) needs 8-bit samples; it cannot be combined with a "
+                     "reduced bit depth"
+                  << std::endl;
+        return false;
+    }
+    m_references.setCapacity(m_config.referenceFrames);
+
+    if (!m_config.gopCacheDir.empty()) {
+        if (m_config.liveMode || m_config.intraRefreshPeriod > 0) {
+            // Without key frames after the first one there are no independent GOPs to reuse
+            std::cout << "GOP cache disabled: live mode and intra refresh have no independent GOPs"
+                      << std::endl;
+            m_config.gopCacheDir.clear();
+        } else if (mkdir(m_config.gopCacheDir.c_str(), 0777) != 0 && errno != EEXIST) {
+            std::cerr << "Error: Could not create GOP cache directory " << m_config.gopCacheDir << std::endl;
+            return false;
+        }
+    }
+
+    if (!m_config.frameCacheDir.empty()) {
+        if (mkdir(m_config.frameCacheDir.c_str(), 0777) != 0 && errno != EEXIST) {
+            std::cerr << "Error: Could not create frame cache directory " << m_config.frameCacheDir
+                      << std::endl;
+            return false;
+        }
+        m_fileReader->setFrameCacheDir(m_config.frameCacheDir);
+    }
+
+    m_denoiser.reset();
+    if (m_config.denoiseStrength > 0) {
+        m_denoiser = std::make_unique<utils::TemporalDenoiser>(m_config.denoiseStrength);
+    }
+
+    if (!createAlgorithm()) return false;
+    if (m_config.bitDepth < 8 && !m_algorithm->packsBitDepth()) {
+        std::cerr << "Error: " << m_algorithm->getAlgorithmName() << " stores 8-bit samples; it cannot be "
+                  << "combined with a reduced bit depth" << std::endl;
+        return false;
+    }
+    if (m_config.adaptiveFactor && !m_algorithm->adaptsFactor()) {
+        std::cerr << "Error: " << m_algorithm->getAlgorithmName() << " keeps its downsample factor fixed; it "
+                  << "cannot be combined with adaptive factors" << std::endl;
+        return false;
+    }
+    if (m_config.liveMode && !m_algorithm->degradesFactor()) {
+        std::cout << "Live degradation disabled: " << m_algorithm->getAlgorithmName()
+                  << " has no downsample factor to raise" << std::endl;
+    }
+    if (m_config.intraRefreshPeriod > 0 && !m_algorithm->describesSamplePlane(makeAlgorithmConfig())) {
+        // Refresh bands are coded on the sample plane: payloads without a plain plane (vector quantized,
+        // screen content, bit-packed) would never produce a refresh point, and a seek would find nothing
+        std::cerr << "Error: Intra refresh needs a plain sample plane, which "
+                  << m_algorithm->getAlgorithmName() << " payloads at " << m_config.bitDepth
+                  << " bits do not have" << std::endl;
+        return false;
+    }
+    m_interCoder = std::make_unique<InterFrameCoder>(m_algorithm.get());
+    m_algorithm->setThreadPool(m_threadPool);
+    m_interCoder->setThreadPool(m_threadPool);
+    return true;
 }
 
 /// @brief Create the compression algorithm
@@ -36,8 +188,7 @@ bool VideoEncoder::createAlgorithm() {
         return false;
     }
 
-    algorithm::CompressionConfig algoConfig(m_config.quality, m_config.bitrate, m_config.keyFrameInterval);
-    if (!m_algorithm->initialize(algoConfig)) {
+    if (!m_algorithm->initialize(makeAlgorithmConfig())) {
         std::cerr << "Error: Failed to initialize algorithm: " << m_config.algorithmName << std::endl;
         return false;
     }
@@ -46,6 +197,17 @@ bool VideoEncoder::createAlgorithm() {
     return true;
 }
 
+/// @brief Algorithm settings derived from the encoder configuration and the live degradation level
+algorithm::CompressionConfig VideoEncoder::makeAlgorithmConfig() const {
+    algorithm::CompressionConfig algoConfig(m_config.quality, m_config.bitrate, m_config.keyFrameInterval);
+    algoConfig.roi_regions = m_config.roiRegions;
+    algoConfig.roi_sidecar_path = m_config.roiSidecarPath;
+    algoConfig.adaptive_factor = m_config.adaptiveFactor;
+    algoConfig.degradation_level = m_live.degradationLevel;
+    algoConfig.bit_depth = m_config.bitDepth;
+    return algoConfig;
+}
+
 /// @brief Execute the encoding process; main processing pipeline- processVideo()
 bool VideoEncoder::encode() {
     auto startTime = std::chrono::high_resolution_clock::now();
@@ -93,65 +255,727 @@ bool VideoEncoder::processVideo(const std::string &inputVideo, const std::string
         return false;
     }
 
-    int width = m_fileReader->getWidth();
-    int height = m_fileReader->getHeight();
     double fps = m_fileReader->getFPS();
+    m_checkpointPath = m_config.liveMode ? "" : outputVideo + ".ckpt";
+    Checkpoint checkpoint;
+    bool resumed = false;
+    if (m_config.resume && !m_checkpointPath.empty()) {
+        if (readCheckpoint(checkpoint)) {
+            if (!resumeStream(outputVideo, checkpoint)) return false;
+            resumed = true;
+        } else {
+            std::cout << "No checkpoint found for " << outputVideo << ", encoding from the start"
+                      << std::endl;
+        }
+    }
+    if (!resumed) {
+        if (m_config.startFrame > 0 && !m_fileReader->seekToFrame(m_config.startFrame)) {
+            std::cerr << "Error: Could not seek the input to frame " << m_config.startFrame << std::endl;
+            return false;
+        }
+        if (!beginStream(outputVideo, m_fileReader->getWidth(), m_fileReader->getHeight(), fps)) return false;
+    }
+
+    int firstFrame = resumed ? checkpoint.nextFrame : m_config.startFrame;
+    int frameCount = m_config.liveMode ? encodeLive(fps, isRegularFile(inputVideo))
+                                       : encodeFrames(firstFrame);
+    endStream();
+
+    m_fileReader->close();
+    if (!m_checkpointPath.empty()) std::remove(m_checkpointPath.c_str());
+    std::cout << "Completed processing " << frameCount << " frames." << std::endl;
+
+    return true;
+}
+
+/// @brief Open the compressed output and reset the coding state for a new stream
+bool VideoEncoder::beginStream(const std::string &outputPath, int width, int height, double fps) {
     uint16_t algorithmId = 1; // CVDownsample as 1 for now
 
-    if (!m_compressedFormat->openForWriting(outputVideo, width, height, fps, algorithmId)) {
-        std::cerr << "Error: Could not create output file: " << outputVideo << std::endl;
+    if (!m_compressedFormat->openForWriting(outputPath, width, height, fps, algorithmId)) {
+        std::cerr << "Error: Could not create output file: " << outputPath << std::endl;
         return false;
     }
 
-    cv::Mat frame;
-    algorithm::Frame inputFrame;
-    int frameCount = 0;
-    bool isKeyFrame = true;
-    auto totalStartTime = std::chrono::high_resolution_clock::now();
+    m_pendingFrames.clear();
+    m_pastReference.clear();
+    m_futureReference.clear();
+    m_background.clear();
+    m_backgroundModel.reset();
+    m_references.clear();
+    m_streamStartTime = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+/**
+ * @brief Continue a stream at its last checkpoint
+ *  A checkpoint is taken right before a key frame, when no frame is held back and no later record
+ *  references an earlier one, so the coding state restarts exactly as a fresh GOP.
+ */
+bool VideoEncoder::resumeStream(const std::string &outputPath, const Checkpoint &checkpoint) {
+    if (checkpoint.settings != checkpointSettings()) {
+        std::cerr << "Error: The checkpoint of " << outputPath << " was written with different settings ("
+                  << checkpoint.settings << ")" << std::endl;
+        return false;
+    }
+    if (!m_compressedFormat->openForResuming(outputPath, checkpoint.offset) ||
+        m_compressedFormat->getOriginalWidth() != m_fileReader->getWidth() ||
+        m_compressedFormat->getOriginalHeight() != m_fileReader->getHeight()) {
+        std::cerr << "Error: Could not resume " << outputPath << " at byte " << checkpoint.offset
+                  << std::endl;
+        return false;
+    }
+    if (!m_fileReader->seekToFrame(checkpoint.nextFrame)) {
+        std::cerr << "Error: Could not seek the input to frame " << checkpoint.nextFrame << std::endl;
+        return false;
+    }
+
+    m_stats.framesProcessed = checkpoint.framesProcessed;
+    m_stats.totalInputSize = checkpoint.totalInputSize;
+    m_stats.totalOutputSize = checkpoint.totalOutputSize;
+    m_stats.largestFrameSize = checkpoint.largestFrameSize;
+    m_stats.averageTimePerFrame = checkpoint.averageTimePerFrame;
+    m_pendingFrames.clear();
+    m_pastReference.clear();
+    m_futureReference.clear();
+    m_background.clear();
+    m_backgroundModel.reset();
+    m_references.clear();
+    m_streamStartTime = std::chrono::high_resolution_clock::now();
+    std::cout << "Resuming " << outputPath << " at frame " << checkpoint.nextFrame << std::endl;
+    return true;
+}
+
+/// @brief Settings that must match for a checkpoint to be resumed
+std::string VideoEncoder::checkpointSettings() const {
+    std::stringstream ss;
+    ss << m_config.algorithmName << "/q" << m_config.quality << "/k" << m_config.keyFrameInterval << "/t"
+       << m_config.temporalFactor << "/b" << m_config.bFrames << "/i" << m_config.interPrediction << "/a"
+       << m_config.adaptiveFactor << "/r" << m_config.bitrate;
+    // Optional stages only appear when enabled, so existing checkpoints and cache keys stay valid
+    if (m_config.enhancementQuantStep > 0) ss << "/e" << m_config.enhancementQuantStep;
+    if (m_config.denoiseStrength > 0) ss << "/n" << m_config.denoiseStrength;
+    if (m_config.filmGrain) ss << "/g";
+    if (m_config.blockCoding) ss << "/d";
+    if (m_config.bitDepth < 8) ss << "/p" << m_config.bitDepth;
+    if (m_config.backgroundReference) ss << "/l";
+    if (m_config.referenceFrames > 1) ss << "/f" << m_config.referenceFrames;
+    if (!m_config.roiRegions.empty() || !m_config.roiSidecarPath.empty()) {
+        // Hashed: the checkpoint stores the settings as one token, and a sidecar path may contain spaces
+        utils::ContentHash roiHash;
+        roiHash.update(m_config.roiSidecarPath);
+        for (const auto &roi : m_config.roiRegions) {
+            roiHash.update(static_cast<int64_t>(roi.x) << 32 | roi.y);
+            roiHash.update(static_cast<int64_t>(roi.width) << 32 | roi.height);
+        }
+        ss << "/o" << roiHash.hex();
+    }
+    return ss.str();
+}
+
+/**
+ * @brief Persist the resume point before the key frame `nextFrame`, at most every few seconds
+ *  The records written so far are flushed first, and the checkpoint replaces the previous one by rename,
+ *  so a crash at any time leaves a checkpoint that matches the data on disk.
+ */
+void VideoEncoder::writeCheckpoint(int nextFrame) {
+    auto now = std::chrono::high_resolution_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastCheckpointTime).count();
+    if (elapsed < m_config.checkpointSeconds) return;
+    m_lastCheckpointTime = now;
+
+    m_compressedFormat->flush();
+    int64_t offset = m_compressedFormat->getWritePosition();
+    if (offset < 0) return;
+
+    std::string temporaryPath = m_checkpointPath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        file << "settings " << checkpointSettings() << "\n"
+             << "offset " << offset << "\n"
+             << "next_frame " << nextFrame << "\n"
+             << "frames_processed " << m_stats.framesProcessed << "\n"
+             << "input_bytes " << m_stats.totalInputSize << "\n"
+             << "output_bytes " << m_stats.totalOutputSize << "\n"
+             << "largest_frame " << m_stats.largestFrameSize << "\n"
+             << "average_frame_ms " << m_stats.averageTimePerFrame << "\n";
+        if (!file.flush()) return;
+    }
+    std::rename(temporaryPath.c_str(), m_checkpointPath.c_str());
+}
+
+bool VideoEncoder::readCheckpoint(Checkpoint &checkpoint) const {
+    std::ifstream file(m_checkpointPath);
+    if (!file.is_open()) return false;
+
+    std::string key;
+    bool hasOffset = false;
+    while (file >> key) {
+        if (key == "settings") file >> checkpoint.settings;
+        else if (key == "offset") hasOffset = static_cast<bool>(file >> checkpoint.offset);
+        else if (key == "next_frame") file >> checkpoint.nextFrame;
+        else if (key == "frames_processed") file >> checkpoint.framesProcessed;
+        else if (key == "input_bytes") file >> checkpoint.totalInputSize;
+        else if (key == "output_bytes") file >> checkpoint.totalOutputSize;
+        else if (key == "largest_frame") file >> checkpoint.largestFrameSize;
+        else if (key == "average_frame_ms") file >> checkpoint.averageTimePerFrame;
+    }
+    return hasOffset && checkpoint.nextFrame > 0;
+}
+
+/// @brief Encode the next frame in display order; its timestamp is its frame number
+void VideoEncoder::encodeFrame(const algorithm::Frame &frame) {
+    auto frameStartTime = std::chrono::high_resolution_clock::now();
+
+    m_stats.totalInputSize += frame.data.size();
+    if (m_config.filmGrain && frame.type == algorithm::KEY_FRAME) writeFilmGrain(frame);
+    const algorithm::Frame &input = m_denoiser ? denoiseFrame(frame) : frame;
+    if (isAnchorFrame(input.timestamp, input.type == algorithm::KEY_FRAME)) {
+        encodeAnchor(input);
+    } else {
+        m_pendingFrames.push_back(input);
+    }
+
+    auto frameEndTime = std::chrono::high_resolution_clock::now();
+    recordFrameTime(std::chrono::duration<double, std::milli>(frameEndTime - frameStartTime).count());
+}
+
+/**
+ * @brief Run the temporal denoise prefilter on an input frame
+ *  The filter history restarts at every key frame, so each GOP is filtered from its own frames only: GOPs
+ *  stay independent for the GOP cache, resumed encodes and distributed segments.
+ */
+const algorithm::Frame &VideoEncoder::denoiseFrame(const algorithm::Frame &frame) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    m_denoisedFrame.width = frame.width;
+    m_denoisedFrame.height = frame.height;
+    m_denoisedFrame.timestamp = frame.timestamp;
+    m_denoisedFrame.type = frame.type;
+    m_denoisedFrame.data.resize(frame.data.size());
+    m_denoiser->process(frame.data.data(), m_denoisedFrame.data.data(), frame.data.size() / 3,
+                        frame.type == algorithm::KEY_FRAME);
+    auto endTime = std::chrono::high_resolution_clock::now();
+    m_stats.denoiseTimeMs += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    return m_denoisedFrame;
+}
 
-    while (m_fileReader->readNextFrame(frame)) {
-        auto frameStartTime = std::chrono::high_resolution_clock::now();
-        isKeyFrame = (frameCount % m_config.keyFrameInterval == 0);
+/**
+ * @brief Estimate the grain of a GOP on its key frame and write it ahead of the GOP's records
+ *  Without an explicit denoise strength, the prefilter strength follows the grain level, so the grain the
+ *  decoder synthesizes again is not spent bits on; grain-free content is not filtered.
+ */
+void VideoEncoder::writeFilmGrain(const algorithm::Frame &keyFrame) {
+    utils::FilmGrainParams params = utils::estimateFilmGrain(keyFrame.data.data(), keyFrame.width,
+                                                             keyFrame.height,
+                                                             static_cast<uint16_t>(keyFrame.timestamp));
+    writeRecord(utils::packFilmGrain(params), algorithm::FILM_GRAIN, keyFrame.timestamp);
+    m_stats.filmGrainRecords++;
+    if (m_config.denoiseStrength > 0) return;
 
-        inputFrame.width = frame.cols;
-        inputFrame.height = frame.rows;
-        inputFrame.timestamp = frameCount;
-        inputFrame.type = isKeyFrame ? algorithm::KEY_FRAME : algorithm::DELTA_FRAME;
-        inputFrame.data.resize(frame.total() * frame.elemSize());
-        std::memcpy(inputFrame.data.data(), frame.data, inputFrame.data.size());
+    // The prefilter passes differences above 4 + 3 * strength; grain stays within about 2.5 sigma
+    double sigma = params.meanSigma();
+    if (sigma < 0.5) {
+        m_denoiser.reset();
+    } else {
+        int strength = static_cast<int>(std::lround((2.5 * sigma - 4.0) / 3.0));
+        m_denoiser = std::make_unique<utils::TemporalDenoiser>(std::clamp(strength, 1, 10));
+    }
+}
 
-        m_stats.totalInputSize += inputFrame.data.size();
-        std::vector<uint8_t> compressed_data = m_algorithm->compressFrame(inputFrame);
-        m_compressedFormat->writeFrame(compressed_data, isKeyFrame);
-        m_stats.totalOutputSize += compressed_data.size();
+/// @brief Flush the frames still held back and close the compressed output
+void VideoEncoder::endStream() {
+    flushPendingFrames();
 
-        auto frameEndTime = std::chrono::high_resolution_clock::now();
-        double frameTime = std::chrono::duration<double, std::milli>(frameEndTime - frameStartTime).count();
+    auto streamEndTime = std::chrono::high_resolution_clock::now();
+    m_stats.totalProcessingTime = std::chrono::duration<double>(streamEndTime - m_streamStartTime).count();
+    if (m_stats.totalInputSize > 0) {
+        m_stats.compressionRatio = static_cast<double>(m_stats.totalInputSize) / m_stats.totalOutputSize;
+    }
+    m_compressedFormat->close();
+}
+
+/// @brief Frames held back at the end of the stream still need a following anchor: promote the last one
+void VideoEncoder::flushPendingFrames() {
+    if (!m_pendingFrames.empty()) {
+        algorithm::Frame lastFrame = std::move(m_pendingFrames.back());
+        m_pendingFrames.pop_back();
+        encodeAnchor(lastFrame);
+    }
+}
 
-        m_stats.framesProcessed++;
-        m_stats.averageTimePerFrame =
-            ((m_stats.averageTimePerFrame * (m_stats.framesProcessed - 1)) + frameTime) /
-            m_stats.framesProcessed;
+/**
+ * @brief Batch encoding: read frames as fast as possible, holding frames back as the GOP structure needs
+ *  Starts at `firstFrame` (a resumed or segment encode) and stops at the configured end frame.
+ */
+int VideoEncoder::encodeFrames(int firstFrame) {
+    cv::Mat frame;
+    int frameCount = firstFrame;
+    m_lastCheckpointTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<algorithm::Frame> gop; // Frames of the current GOP, when they go through the cache
+    while ((m_config.endFrame <= 0 || frameCount < m_config.endFrame) && m_fileReader->readNextFrame(frame)) {
+        algorithm::Frame inputFrame = makeInputFrame(frame, frameCount);
+        if (inputFrame.type == algorithm::KEY_FRAME && frameCount > firstFrame) {
+            if (!gop.empty()) encodeGop(gop, false);
+            writeCheckpoint(frameCount);
+        }
+        if (!m_config.gopCacheDir.empty()) {
+            gop.push_back(std::move(inputFrame));
+        } else {
+            encodeFrame(inputFrame);
+            if (m_bufferPool) m_bufferPool->release(std::move(inputFrame.data));
+        }
 
         if (frameCount % 500 == 0) {
             std::cout << "Processed " << frameCount << " frames..." << std::endl;
         }
         frameCount++;
     }
+    if (!gop.empty()) encodeGop(gop, true);
+    return frameCount - firstFrame;
+}
 
-    auto totalEndTime = std::chrono::high_resolution_clock::now();
-    m_stats.totalProcessingTime = std::chrono::duration<double>(totalEndTime - totalStartTime).count();
-    if (m_stats.totalInputSize > 0) {
-        m_stats.compressionRatio = static_cast<double>(m_stats.totalInputSize) / m_stats.totalOutputSize;
+/**
+ * @brief Copy a GOP from the cache, or encode it and add it to the cache
+ *  A GOP starts at a key frame, and the frame before the next key frame is always an anchor, so its
+ *  records depend on nothing but its own frames and the settings. The last GOP of the stream also
+ *  includes the promotion of its held back frames.
+ */
+void VideoEncoder::encodeGop(std::vector<algorithm::Frame> &gop, bool lastGop) {
+    std::string path = m_config.gopCacheDir + "/" + gopCacheKey(gop) + ".gop";
+    if (loadCachedGop(path, gop)) {
+        m_stats.gopCacheHits++;
+    } else {
+        m_stats.gopCacheMisses++;
+        m_gopRecords.clear();
+        m_gopRecordCount = 0;
+        m_gopStartTimestamp = gop.front().timestamp;
+        m_capturingGop = true;
+        for (const auto &frame : gop) encodeFrame(frame);
+        if (lastGop) flushPendingFrames();
+        m_capturingGop = false;
+        storeCachedGop(path, gop);
     }
 
-    m_fileReader->close();
-    m_compressedFormat->close();
-    std::cout << "Completed processing " << frameCount << " frames." << std::endl;
+    if (m_bufferPool) {
+        for (auto &frame : gop) m_bufferPool->release(std::move(frame.data));
+    }
+    gop.clear();
+}
+
+/// @brief Hash of the settings and the source pixels; positions are not part of it unless ROIs are
+std::string VideoEncoder::gopCacheKey(const std::vector<algorithm::Frame> &gop) const {
+    utils::ContentHash hash;
+    hash.update(checkpointSettings());
+    hash.update(static_cast<int64_t>(gop.size()));
+    hash.update(static_cast<int64_t>(gop.front().width));
+    hash.update(static_cast<int64_t>(gop.front().height));
+    if (!m_config.roiRegions.empty() || !m_config.roiSidecarPath.empty()) {
+        // ROIs are given per frame number, so the same pixels elsewhere in the stream code differently
+        hash.update(static_cast<int64_t>(gop.front().timestamp));
+    }
+    for (const auto &frame : gop) hash.update(frame.data.data(), frame.data.size());
+    return hash.hex();
+}
+
+/**
+ * @brief Cache entry: | "VGOP" | frames (4) | records (4) | records as in the compressed file |
+ *  Record timestamps are stored relative to the first frame of the GOP.
+ */
+bool VideoEncoder::loadCachedGop(const std::string &path, const std::vector<algorithm::Frame> &gop) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[4];
+    uint32_t frames = 0, records = 0;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char *>(&frames), 4);
+    file.read(reinterpret_cast<char *>(&records), 4);
+    if (!file || std::memcmp(magic, "VGOP", 4) != 0 || frames != gop.size()) return false;
 
+    // Parse the whole entry before writing anything, so a damaged entry is simply re-encoded
+    struct Record {
+        uint8_t type;
+        int32_t timestamp;
+        std::vector<uint8_t> data;
+    };
+    std::vector<Record> parsed(records);
+    for (auto &record : parsed) {
+        uint32_t size = 0;
+        file.read(reinterpret_cast<char *>(&record.type), 1);
+        file.read(reinterpret_cast<char *>(&record.timestamp), 4);
+        file.read(reinterpret_cast<char *>(&size), 4);
+        if (!file) return false;
+        record.data.resize(size);
+        file.read(reinterpret_cast<char *>(record.data.data()), size);
+        if (!file) return false;
+    }
+
+    for (const auto &record : parsed) {
+        writeRecord(record.data, static_cast<algorithm::FrameType>(record.type),
+                    gop.front().timestamp + record.timestamp);
+    }
+    for (const auto &frame : gop) {
+        m_stats.totalInputSize += frame.data.size();
+        recordFrameTime(0.0);
+    }
     return true;
 }
 
+/// @brief Written under a temporary name and renamed, so concurrent encodes never read half an entry
+void VideoEncoder::storeCachedGop(const std::string &path, const std::vector<algorithm::Frame> &gop) const {
+    std::string temporaryPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        uint32_t frames = static_cast<uint32_t>(gop.size());
+        file.write("VGOP", 4);
+        file.write(reinterpret_cast<const char *>(&frames), 4);
+        file.write(reinterpret_cast<const char *>(&m_gopRecordCount), 4);
+        file.write(reinterpret_cast<const char *>(m_gopRecords.data()), m_gopRecords.size());
+        if (!file.flush()) {
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+    std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+/**
+ * @brief Live encoding without lookahead
+ *  A capture thread hands frames to the encoding thread through a spinning single-slot handoff. Every
+ *  frame is coded and flushed immediately, and its capture-to-packet latency is checked against the budget.
+ *  A capture device or stream delivers frames at its own rate; a regular file would be read as fast as the
+ *  encoder takes frames, so with `paced` the capture thread emulates a live source: frame n is released n
+ *  frame intervals after the start. The two threads are pinned to the first two CPUs of the process
+ *  affinity mask, so concurrent live encodes started under taskset on disjoint CPUs do not share cores;
+ *  with fewer than two CPUs in the mask nothing is pinned.
+ */
+int VideoEncoder::encodeLive(double fps, bool paced) {
+    struct CapturedFrame {
+        algorithm::Frame frame;
+        std::chrono::high_resolution_clock::time_point captureTime;
+    };
+    utils::SpinHandoff<CapturedFrame> handoff;
+    double frameInterval = fps > 0 ? 1000.0 / fps : 1000.0 / 30;
+    m_live.budgetMs = m_config.latencyBudgetMs > 0 ? m_config.latencyBudgetMs : frameInterval;
+    int statusInterval = std::max(1, static_cast<int>(fps + 0.5));
+    int frameCount = 0;
+    std::vector<int> cpus = utils::allowedCpus();
+    bool pinned = cpus.size() >= 2;
+
+    std::thread capture([&]() {
+        if (pinned) utils::pinCurrentThread(cpus[0]);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> interval(frameInterval);
+        cv::Mat frame;
+        for (int n = 0; m_fileReader->readNextFrame(frame); n++) {
+            if (paced) {
+                std::this_thread::sleep_until(
+                    startTime + std::chrono::duration_cast<std::chrono::nanoseconds>(n * interval));
+            }
+            CapturedFrame captured{makeInputFrame(frame, n), std::chrono::high_resolution_clock::now()};
+            if (!handoff.put(std::move(captured))) break;
+        }
+        handoff.close();
+    });
+
+    std::thread encoder([&]() {
+        if (pinned) utils::pinCurrentThread(cpus[1]);
+        CapturedFrame captured;
+        while (handoff.take(captured)) {
+            // A new level changes the downsample factor and with it the payload geometry, which the inter
+            // references and the algorithm's per-GOP state cannot carry over: it starts a GOP of its own
+            if (m_live.targetLevel != m_live.degradationLevel) {
+                m_live.degradationLevel = m_live.targetLevel;
+                m_algorithm->initialize(makeAlgorithmConfig());
+                captured.frame.type = algorithm::KEY_FRAME;
+            }
+            encodeFrame(captured.frame);
+            if (m_bufferPool) m_bufferPool->release(std::move(captured.frame.data));
+
+            std::chrono::duration<double, std::milli> latency =
+                std::chrono::high_resolution_clock::now() - captured.captureTime;
+            updateLatency(latency.count());
+
+            if (frameCount % statusInterval == 0) {
+                std::cout << "Live: frame " << frameCount << ", latency " << m_live.lastMs << " ms (budget "
+                          << m_live.budgetMs << " ms, degradation level " << m_live.degradationLevel << ")"
+                          << std::endl;
+            }
+            frameCount++;
+        }
+    });
+
+    encoder.join();
+    capture.join();
+    return frameCount;
+}
+
+/**
+ * @brief Track the capture-to-packet latency and adapt the degradation level
+ *  A short run of frames over budget raises the downsample factor by one step; a long run well under
+ *  budget lowers it again. The hysteresis keeps the factor (and the inter references) from flapping. The
+ *  new level only becomes the target: encodeLive applies it with a key frame. Algorithms without a
+ *  downsample factor stay at level 0.
+ */
+void VideoEncoder::updateLatency(double latencyMs) {
+    m_live.frames++;
+    m_live.lastMs = latencyMs;
+    m_live.averageMs += (latencyMs - m_live.averageMs) / m_live.frames;
+    m_live.maxMs = std::max(m_live.maxMs, latencyMs);
+
+    if (latencyMs > m_live.budgetMs) {
+        m_live.framesOverBudget++;
+        m_live.overBudgetStreak++;
+        m_live.underBudgetStreak = 0;
+    } else {
+        m_live.overBudgetStreak = 0;
+        m_live.underBudgetStreak = latencyMs < m_live.budgetMs / 2 ? m_live.underBudgetStreak + 1 : 0;
+    }
+
+    // Without a factor to raise, a new level would only cost a key frame
+    if (!m_algorithm->degradesFactor()) return;
+
+    int level = m_live.targetLevel;
+    if (m_live.overBudgetStreak >= DEGRADE_AFTER_FRAMES && level < MAX_DEGRADATION_LEVEL) {
+        level++;
+    } else if (m_live.underBudgetStreak >= RECOVER_AFTER_FRAMES && level > 0) {
+        level--;
+    } else {
+        return;
+    }
+
+    m_live.targetLevel = level;
+    m_live.overBudgetStreak = 0;
+    m_live.underBudgetStreak = 0;
+    std::cout << "Live: latency " << latencyMs << " ms against a budget of " << m_live.budgetMs
+              << " ms, switching to degradation level " << level << " with the next key frame" << std::endl;
+}
+
+/// @brief Wrap a captured image; the key frame rule depends on the refresh mode
+algorithm::Frame VideoEncoder::makeInputFrame(const cv::Mat &frame, int frameNumber) const {
+    // With intra refresh only the first frame is a key frame; the refresh bands provide recovery
+    bool isKeyFrame = m_config.intraRefreshPeriod > 0 ? frameNumber == 0
+                                                      : (frameNumber % m_config.keyFrameInterval == 0);
+
+    algorithm::Frame inputFrame(frame.cols, frame.rows);
+    inputFrame.timestamp = frameNumber;
+    inputFrame.type = isKeyFrame ? algorithm::KEY_FRAME : algorithm::DELTA_FRAME;
+    size_t frameBytes = frame.total() * frame.elemSize();
+    inputFrame.data = m_bufferPool ? m_bufferPool->acquire(frameBytes) : std::vector<uint8_t>(frameBytes);
+    std::memcpy(inputFrame.data.data(), frame.data, inputFrame.data.size());
+    return inputFrame;
+}
+
+/// @brief Fold one frame's processing time into the running average
+void VideoEncoder::recordFrameTime(double frameTime) {
+    m_stats.framesProcessed++;
+    m_stats.averageTimePerFrame =
+        ((m_stats.averageTimePerFrame * (m_stats.framesProcessed - 1)) + frameTime) / m_stats.framesProcessed;
+    if (m_progressCallback) m_progressCallback(m_stats.framesProcessed);
+}
+
+/**
+ * @brief Whether a frame is coded in display order (anchor) or held back until the next anchor
+ *  Held back frames are either dropped by temporal downsampling or coded as B-frames. Key frames and the
+ *  frame right before a key frame are always anchors, so no frame references across a GOP boundary.
+ */
+bool VideoEncoder::isAnchorFrame(int frameNumber, bool isKeyFrame) const {
+    int anchorInterval = m_config.temporalFactor > 1 ? m_config.temporalFactor : m_config.bFrames + 1;
+    if (anchorInterval <= 1 || isKeyFrame) return true;
+    if ((frameNumber + 1) % m_config.keyFrameInterval == 0) return true;
+    return (frameNumber % m_config.keyFrameInterval) % anchorInterval == 0;
+}
+
+/**
+ * @brief Compress and write an anchor frame
+ *  Interpolated frames are written before the anchor (display order), B-frames after it (decode order),
+ *  since they need its reconstruction as their second reference.
+ */
+void VideoEncoder::encodeAnchor(const algorithm::Frame &frame) {
+    if (!m_pendingFrames.empty() && m_config.temporalFactor > 1) writeInterpolatedFrames(frame);
+
+    std::vector<uint8_t> compressed_data = m_algorithm->compressFrame(frame);
+    if (!m_config.interPrediction) {
+        writeEnhancementLayer(frame, compressed_data);
+        writeRecord(compressed_data, frame.type, frame.timestamp);
+    } else {
+        std::vector<uint8_t> record, reconstruction;
+        if (m_config.backgroundReference) updateBackground(compressed_data, frame);
+        if (frame.type == algorithm::KEY_FRAME) {
+            record = compressed_data;
+            reconstruction = std::move(compressed_data);
+        } else if (m_config.intraRefreshPeriod > 0) {
+            // Band k of the cycle is refreshed in frame k + 1; the cycle completes every period frames
+            int quantStep = utils::residualQuantStep(m_config.quality);
+            int band = (frame.timestamp - 1) % m_config.intraRefreshPeriod;
+            record = m_interCoder->encodeRefresh(compressed_data, &m_futureReference, quantStep, band,
+                                                 m_config.intraRefreshPeriod, reconstruction);
+        } else {
+            int quantStep = utils::residualQuantStep(m_config.quality);
+            const std::vector<uint8_t> *background = m_background.empty() ? nullptr : &m_background;
+            if (m_config.referenceFrames > 1) {
+                record = m_interCoder->encodeMulti(compressed_data,
+                                                   m_references.window(m_config.referenceFrames), background,
+                                                   quantStep, m_config.blockCoding, reconstruction);
+            } else {
+                record =
+                    encodeInter(compressed_data, &m_futureReference, background, quantStep, reconstruction);
+            }
+        }
+        writeEnhancementLayer(frame, reconstruction);
+        bool isKeyFrame = frame.type == algorithm::KEY_FRAME;
+        writeRecord(record, isKeyFrame ? algorithm::KEY_FRAME : algorithm::PREDICTED_FRAME, frame.timestamp);
+        if (m_config.referenceFrames > 1) {
+            // The window never reaches across a key frame, so GOPs stay independent
+            if (isKeyFrame) m_references.clear();
+            m_references.push(reconstruction);
+        }
+        m_pastReference = std::move(m_futureReference);
+        m_futureReference = std::move(reconstruction);
+    }
+
+    if (!m_pendingFrames.empty()) writeBidirectionalFrames();
+    if (m_config.temporalFactor > 1) m_previousAnchor = frame;
+}
+
+/**
+ * @brief Code a payload against a prediction, block by block with deblocking when block coding is on
+ *  With a background, every block is predicted from the better of the two references.
+ */
+std::vector<uint8_t> VideoEncoder::encodeInter(const std::vector<uint8_t> &payload,
+                                               const std::vector<uint8_t> *prediction,
+                                               const std::vector<uint8_t> *background, int quantStep,
+                                               std::vector<uint8_t> &reconstruction) const {
+    if (background) {
+        return m_interCoder->encodeMixed(payload, prediction, background, quantStep, m_config.blockCoding,
+                                         reconstruction);
+    }
+    if (m_config.blockCoding) {
+        return m_interCoder->encodeBlocks(payload, prediction, quantStep, reconstruction);
+    }
+    return m_interCoder->encode(payload, prediction, quantStep, reconstruction);
+}
+
+/**
+ * @brief Update the background model with an anchor payload, and send it when the decoder's copy is stale
+ *  The decoder drops its background at every key frame and the model restarts there, so it is sent again
+ *  with the first predicted anchor of each GOP, and after that whenever the model has drifted from the
+ *  version last sent. A background record is coded against the previous background, or against the last
+ *  anchor when there is none yet, and is written right before the anchor that may use it.
+ */
+void VideoEncoder::updateBackground(const std::vector<uint8_t> &payload, const algorithm::Frame &frame) {
+    // Mean level change of the model, and anchors in between, before a sent background is replaced
+    static const double BACKGROUND_DRIFT = 1.0;
+    static const int BACKGROUND_MIN_ANCHORS = 15;
+
+    algorithm::PayloadLayout layout;
+    if (!m_algorithm->describePayload(payload, layout)) return;
+    const uint8_t *samples = payload.data() + layout.header_bytes;
+    if (frame.type == algorithm::KEY_FRAME) {
+        // The model restarts from the key frame too, so a GOP's records depend on its own frames only
+        m_backgroundModel.reset();
+        m_background.clear();
+        m_sentBackground.clear();
+        m_anchorsSinceBackground = 0;
+    }
+    m_backgroundModel.update(samples, layout.sample_bytes);
+    m_anchorsSinceBackground++;
+    if (frame.type == algorithm::KEY_FRAME) return;
+    if (m_background.size() == payload.size() && m_sentBackground.size() == payload.size() &&
+        (m_anchorsSinceBackground < BACKGROUND_MIN_ANCHORS ||
+         m_backgroundModel.distance(m_sentBackground.data() + layout.header_bytes) < BACKGROUND_DRIFT)) {
+        return;
+    }
+
+    // The background payload shares the anchor's header and side information, so it predicts it
+    m_sentBackground = payload;
+    m_backgroundModel.read(m_sentBackground.data() + layout.header_bytes);
+    const std::vector<uint8_t> *prediction = m_background.empty() ? &m_futureReference : &m_background;
+    std::vector<uint8_t> reconstruction;
+    std::vector<uint8_t> record = encodeInter(m_sentBackground, prediction, nullptr,
+                                              utils::residualQuantStep(m_config.quality), reconstruction);
+    writeRecord(record, algorithm::BACKGROUND_FRAME, frame.timestamp);
+    m_background = std::move(reconstruction);
+    m_anchorsSinceBackground = 0;
+    m_stats.backgroundRecords++;
+}
+
+/**
+ * @brief Write the held back frames as B-frames, predicted from the average of the anchors around them
+ *  B-frames are never referenced, so they use a one step coarser quantizer than the anchors.
+ */
+void VideoEncoder::writeBidirectionalFrames() {
+    std::vector<uint8_t> prediction = InterFrameCoder::averagePrediction(m_pastReference, m_futureReference);
+    int quantStep = utils::residualQuantStep(m_config.quality) + 1;
+    std::vector<uint8_t> reconstruction;
+    for (const auto &frame : m_pendingFrames) {
+        std::vector<uint8_t> compressed_data = m_algorithm->compressFrame(frame);
+        std::vector<uint8_t> record = encodeInter(compressed_data, prediction.empty() ? nullptr : &prediction,
+                                                  nullptr, quantStep, reconstruction);
+        writeEnhancementLayer(frame, reconstruction);
+        writeRecord(record, algorithm::BIDIRECTIONAL_FRAME, frame.timestamp);
+    }
+    m_pendingFrames.clear();
+}
+
+/**
+ * @brief Write the dropped frames as motion fields towards the previous and the next anchor
+ *  Records stay in display order; the decoder holds them back until the next anchor is decoded.
+ */
+void VideoEncoder::writeInterpolatedFrames(const algorithm::Frame &nextAnchor) {
+    int span = static_cast<int>(m_pendingFrames.size()) + 1;
+    for (size_t i = 0; i < m_pendingFrames.size(); i++) {
+        const algorithm::Frame &frame = m_pendingFrames[i];
+        utils::MotionField forward = utils::estimateMotion(frame.data.data(), m_previousAnchor.data.data(),
+                                                           frame.width, frame.height);
+        utils::MotionField backward =
+            utils::estimateMotion(frame.data.data(), nextAnchor.data.data(), frame.width, frame.height);
+        writeRecord(utils::packInterpolatedFrame(frame.width, frame.height, static_cast<int>(i) + 1, span,
+                                                 forward, backward),
+                    algorithm::INTERPOLATED_FRAME, frame.timestamp);
+    }
+    m_pendingFrames.clear();
+}
+
+/**
+ * @brief Write the enhancement layer of a frame, right before its base record
+ *  The residual is taken against the base as the decoder reconstructs it from `basePayload` (the payload
+ *  for intra records, the reconstruction for inter records), so it corrects the coding error of the inter
+ *  coder as well as the detail lost by downsampling.
+ */
+void VideoEncoder::writeEnhancementLayer(const algorithm::Frame &frame,
+                                         const std::vector<uint8_t> &basePayload) {
+    if (m_config.enhancementQuantStep <= 0) return;
+    algorithm::Frame base = m_algorithm->decompressFrame(basePayload);
+    if (base.width != frame.width || base.height != frame.height || base.data.size() != frame.data.size()) {
+        return;
+    }
+    std::vector<uint8_t> record = utils::packEnhancementLayer(
+        frame.data.data(), base.data.data(), frame.width, frame.height, m_config.enhancementQuantStep);
+    writeRecord(record, algorithm::ENHANCEMENT_LAYER, frame.timestamp);
+}
+
+/// @brief Append one record to the compressed file
+void VideoEncoder::writeRecord(const std::vector<uint8_t> &data, algorithm::FrameType type, int timestamp) {
+    m_compressedFormat->writeFrame(data, static_cast<uint8_t>(type), timestamp);
+    if (m_capturingGop) {
+        uint8_t header[9];
+        int32_t relativeTimestamp = timestamp - m_gopStartTimestamp;
+        uint32_t size = static_cast<uint32_t>(data.size());
+        header[0] = static_cast<uint8_t>(type);
+        std::memcpy(header + 1, &relativeTimestamp, 4);
+        std::memcpy(header + 5, &size, 4);
+        m_gopRecords.insert(m_gopRecords.end(), header, header + 9);
+        m_gopRecords.insert(m_gopRecords.end(), data.begin(), data.end());
+        m_gopRecordCount++;
+    }
+    if (m_config.liveMode) m_compressedFormat->flush();
+    m_stats.totalOutputSize += data.size();
+    m_stats.largestFrameSize = std::max<int64_t>(m_stats.largestFrameSize, data.size());
+    if (type == algorithm::ENHANCEMENT_LAYER) m_stats.enhancementBytes += data.size();
+}
+
 /// @brief Get encoding statistics
 std::string VideoEncoder::getStats() const {
     std::stringstream ss;
@@ -162,8 +986,34 @@ std::string VideoEncoder::getStats() const {
        << "  Total input size: " << m_stats.totalInputSize << " bytes" << std::endl
        << "  Total output size: " << m_stats.totalOutputSize << " bytes" << std::endl
        << "  Compression ratio: " << m_stats.compressionRatio << ":1" << std::endl
+       << "  Largest frame: " << m_stats.largestFrameSize << " bytes" << std::endl
        << "  Average time per frame: " << m_stats.averageTimePerFrame << " ms" << std::endl
        << "  Total processing time: " << m_stats.totalProcessingTime << " seconds" << std::endl;
+    if (m_config.liveMode) {
+        ss << "Live Latency Statistics:" << std::endl
+           << "  Budget: " << m_live.budgetMs << " ms" << std::endl
+           << "  Average capture-to-packet latency: " << m_live.averageMs << " ms" << std::endl
+           << "  Maximum latency: " << m_live.maxMs << " ms" << std::endl
+           << "  Frames over budget: " << m_live.framesOverBudget << std::endl
+           << "  Final degradation level: " << m_live.degradationLevel << std::endl;
+    }
+    if (m_denoiser && m_stats.framesProcessed > 0) {
+        ss << "  Denoise time per frame: " << m_stats.denoiseTimeMs / m_stats.framesProcessed
+           << " ms (strength " << m_denoiser->getStrength() << ")" << std::endl;
+    }
+    if (m_config.filmGrain) ss << "  Film grain parameter sets: " << m_stats.filmGrainRecords << std::endl;
+    if (m_config.backgroundReference) {
+        ss << "  Background references sent: " << m_stats.backgroundRecords << std::endl;
+    }
+    if (m_config.enhancementQuantStep > 0) {
+        ss << "  Enhancement layer: " << m_stats.enhancementBytes << " bytes (quantizer step "
+           << m_config.enhancementQuantStep << ")" << std::endl;
+    }
+    if (!m_config.gopCacheDir.empty()) {
+        ss << "GOP Cache Statistics:" << std::endl
+           << "  Reused GOPs: " << m_stats.gopCacheHits << std::endl
+           << "  Encoded GOPs: " << m_stats.gopCacheMisses << std::endl;
+    }
     if (m_algorithm) ss << "Algorithm Statistics:" << std::endl << m_algorithm->getStats();
 
     return ss.str();
@@ -0,0 +1,641 @@
+#include "core/inter_coder.hpp"
+#include "utils/bitstream.hpp"
+#include "utils/deblocking_filter.hpp"
+#include "utils/residual_coder.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace vcompress {
+namespace core {
+
+using utils::LANE_SAMPLES;
+
+// Largest payload a refresh record may announce when there is no reference to check it against: the raw
+// samples of an 8192x8192 frame, which no downsampled payload reaches
+static constexpr uint32_t MAX_REFRESH_PAYLOAD_BYTES = 8192u * 8192u * 3u;
+
+InterFrameCoder::InterFrameCoder(const algorithm::BaseCompressionAlgorithm *algorithm)
+    : m_algorithm(algorithm), m_pool(nullptr) {}
+
+/// @brief Residual coding needs a prediction of the same size with an identical header
+bool InterFrameCoder::isPredictable(const std::vector<uint8_t> &payload,
+                                    const std::vector<uint8_t> *prediction,
+                                    algorithm::PayloadLayout &layout) const {
+    return prediction && prediction->size() == payload.size() &&
+           m_algorithm->describePayload(payload, layout) &&
+           std::equal(payload.begin(), payload.begin() + layout.header_bytes, prediction->begin());
+}
+
+/// @brief Whole rows of the sample plane; layouts without a plane are split by bytes
+void InterFrameCoder::bandRange(const algorithm::PayloadLayout &layout, int band, int bands, size_t &begin,
+                                size_t &end) {
+    if (layout.width > 0 && layout.height > 0) {
+        size_t row_bytes = static_cast<size_t>(layout.width) * layout.channels;
+        begin = static_cast<size_t>(layout.height) * band / bands * row_bytes;
+        end = static_cast<size_t>(layout.height) * (band + 1) / bands * row_bytes;
+    } else {
+        begin = layout.sample_bytes * band / bands;
+        end = layout.sample_bytes * (band + 1) / bands;
+    }
+}
+
+std::vector<uint8_t> InterFrameCoder::encode(const std::vector<uint8_t> &payload,
+                                             const std::vector<uint8_t> *prediction, int quantStep,
+                                             std::vector<uint8_t> &reconstruction) const {
+    algorithm::PayloadLayout layout;
+    std::vector<uint8_t> record;
+    if (!isPredictable(payload, prediction, layout)) {
+        record.reserve(payload.size() + 1);
+        record.push_back(RAW);
+        record.insert(record.end(), payload.begin(), payload.end());
+        reconstruction = payload;
+        return record;
+    }
+
+    quantStep = std::clamp(quantStep, 1, 255);
+    record.push_back(RESIDUAL);
+    record.push_back(static_cast<uint8_t>(quantStep));
+
+    reconstruction.resize(payload.size());
+    std::copy(payload.begin(), payload.begin() + layout.header_bytes, reconstruction.begin());
+    size_t samples_end = layout.header_bytes + layout.sample_bytes;
+    {
+        utils::BitWriter writer(record);
+        utils::encodeResidual(writer, payload.data() + layout.header_bytes,
+                              prediction->data() + layout.header_bytes, layout.sample_bytes, quantStep,
+                              reconstruction.data() + layout.header_bytes);
+        // Anything after the sample plane is side information and must stay exact
+        utils::encodeResidual(writer, payload.data() + samples_end, prediction->data() + samples_end,
+                              payload.size() - samples_end, 1, reconstruction.data() + samples_end);
+    }
+    return record;
+}
+
+std::vector<uint8_t> InterFrameCoder::encodeRefresh(const std::vector<uint8_t> &payload,
+                                                    const std::vector<uint8_t> *prediction, int quantStep,
+                                                    int band, int bands,
+                                                    std::vector<uint8_t> &reconstruction) const {
+    algorithm::PayloadLayout layout;
+    if (!m_algorithm->describePayload(payload, layout)) {
+        return encode(payload, nullptr, quantStep, reconstruction);
+    }
+
+    // Without a usable reference, predict from mid-gray like a decoder that joins here
+    std::vector<uint8_t> gray;
+    if (!isPredictable(payload, prediction, layout)) {
+        gray.assign(payload.size(), 128);
+        std::copy(payload.begin(), payload.begin() + layout.header_bytes, gray.begin());
+        prediction = &gray;
+    }
+
+    bands = std::clamp(bands, 1, 0xFFFF);
+    band %= bands;
+    quantStep = std::clamp(quantStep, 1, 255);
+    uint16_t band_field = static_cast<uint16_t>(band), bands_field = static_cast<uint16_t>(bands);
+    uint32_t payload_size = static_cast<uint32_t>(payload.size());
+    uint16_t header_size = static_cast<uint16_t>(layout.header_bytes);
+    size_t begin, end;
+    bandRange(layout, band, bands, begin, end);
+
+    std::vector<uint8_t> record(REFRESH_HEADER_BYTES);
+    record[0] = REFRESH;
+    record[1] = static_cast<uint8_t>(quantStep);
+    std::memcpy(record.data() + 2, &band_field, 2);
+    std::memcpy(record.data() + 4, &bands_field, 2);
+    std::memcpy(record.data() + 6, &payload_size, 4);
+    std::memcpy(record.data() + 10, &header_size, 2);
+    const uint8_t *samples = payload.data() + layout.header_bytes;
+    record.insert(record.end(), payload.begin(), payload.begin() + layout.header_bytes);
+    record.insert(record.end(), samples + begin, samples + end);
+
+    reconstruction = payload;
+    const uint8_t *predicted = prediction->data() + layout.header_bytes;
+    uint8_t *reconstructed = reconstruction.data() + layout.header_bytes;
+    size_t samples_end = layout.header_bytes + layout.sample_bytes;
+    {
+        utils::BitWriter writer(record);
+        utils::encodeResidual(writer, samples, predicted, begin, quantStep, reconstructed);
+        utils::encodeResidual(writer, samples + end, predicted + end, layout.sample_bytes - end, quantStep,
+                              reconstructed + end);
+        utils::encodeResidual(writer, payload.data() + samples_end, prediction->data() + samples_end,
+                              payload.size() - samples_end, 1, reconstruction.data() + samples_end);
+    }
+    return record;
+}
+
+/// @brief Copy a block of `rows` rows of `span` bytes out of a plane into a contiguous buffer
+static void gatherBlock(const uint8_t *plane, size_t row_bytes, size_t offset, size_t span, int rows,
+                        uint8_t *block) {
+    for (int y = 0; y < rows; y++) std::memcpy(block + y * span, plane + offset + y * row_bytes, span);
+}
+
+/// @brief Copy a contiguous block back into a plane
+static void scatterBlock(const uint8_t *block, size_t span, int rows, uint8_t *plane, size_t row_bytes,
+                         size_t offset) {
+    for (int y = 0; y < rows; y++) std::memcpy(plane + offset + y * row_bytes, block + y * span, span);
+}
+
+/// @brief Rows, row span (bytes) and plane offset of block (bx, by); edge blocks are clipped to the plane
+static void blockExtent(const algorithm::PayloadLayout &layout, int blockSize, int bx, int by, int &rows,
+                        size_t &span, size_t &offset) {
+    size_t row_bytes = static_cast<size_t>(layout.width) * layout.channels;
+    rows = std::min(blockSize, layout.height - by * blockSize);
+    span = static_cast<size_t>(std::min(blockSize, layout.width - bx * blockSize)) * layout.channels;
+    offset = static_cast<size_t>(by) * blockSize * row_bytes +
+             static_cast<size_t>(bx) * blockSize * layout.channels;
+}
+
+/// @brief Quantizer step of a block class; at step 1 (lossless) every class stays lossless
+int InterFrameCoder::blockStep(uint32_t blockClass, int quantStep) {
+    if (blockClass == FINE) return std::max(1, quantStep / 2);
+    if (blockClass == COARSE && quantStep > 1) return std::min(255, quantStep * 2);
+    return quantStep;
+}
+
+std::vector<uint8_t> InterFrameCoder::encodeBlocks(const std::vector<uint8_t> &payload,
+                                                   const std::vector<uint8_t> *prediction, int quantStep,
+                                                   std::vector<uint8_t> &reconstruction) const {
+    algorithm::PayloadLayout layout;
+    if (!isPredictable(payload, prediction, layout) || layout.width <= 0 || layout.height <= 0) {
+        return encode(payload, prediction, quantStep, reconstruction);
+    }
+
+    quantStep = std::clamp(quantStep, 1, 255);
+    std::vector<uint8_t> record = {BLOCKS, static_cast<uint8_t>(quantStep), BLOCK_SIZE};
+    reconstruction = *prediction;
+    std::copy(payload.begin(), payload.begin() + layout.header_bytes, reconstruction.begin());
+
+    int channels = layout.channels;
+    size_t row_bytes = static_cast<size_t>(layout.width) * channels;
+    int blocks_x = (layout.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    int blocks_y = (layout.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<uint8_t> steps(static_cast<size_t>(blocks_x) * blocks_y);
+    std::vector<uint8_t> target, predicted, reconstructed;
+    const uint8_t *samples = payload.data() + layout.header_bytes;
+    const uint8_t *predicted_samples = prediction->data() + layout.header_bytes;
+    uint8_t *reconstructed_samples = reconstruction.data() + layout.header_bytes;
+    size_t samples_end = layout.header_bytes + layout.sample_bytes;
+    {
+        utils::BitWriter writer(record);
+        for (int by = 0; by < blocks_y; by++) {
+            for (int bx = 0; bx < blocks_x; bx++) {
+                int rows;
+                size_t span, offset;
+                blockExtent(layout, BLOCK_SIZE, bx, by, rows, span, offset);
+                target.resize(span * rows);
+                predicted.resize(span * rows);
+                reconstructed.resize(span * rows);
+                gatherBlock(samples, row_bytes, offset, span, rows, target.data());
+                gatherBlock(predicted_samples, row_bytes, offset, span, rows, predicted.data());
+
+                // Activity: mean absolute difference to the horizontally neighbouring pixel
+                int activity = 0, max_residual = 0;
+                for (size_t i = 0; i < target.size(); i++) {
+                    if (i % span >= static_cast<size_t>(channels)) {
+                        activity += std::abs(target[i] - target[i - channels]);
+                    }
+                    max_residual = std::max(max_residual, std::abs(target[i] - predicted[i]));
+                }
+                activity /= static_cast<int>(target.size());
+                uint32_t block_class = activity < 2 ? FINE : (activity > 16 ? COARSE : NORMAL);
+                int step = blockStep(block_class, quantStep);
+                // A residual that quantizes to zero everywhere costs nothing as a skip
+                if (2 * max_residual < step) block_class = SKIP;
+                writer.putBits(block_class, 2);
+                // Skipped blocks repeat already filtered samples; they must not be filtered again
+                steps[static_cast<size_t>(by) * blocks_x + bx] = block_class == SKIP ? 1 : step;
+                if (block_class == SKIP) continue;
+
+                utils::encodeResidual(writer, target.data(), predicted.data(), target.size(), step,
+                                      reconstructed.data());
+                scatterBlock(reconstructed.data(), span, rows, reconstructed_samples, row_bytes, offset);
+            }
+        }
+        // Anything after the sample plane is side information and must stay exact
+        utils::encodeResidual(writer, payload.data() + samples_end, prediction->data() + samples_end,
+                              payload.size() - samples_end, 1, reconstruction.data() + samples_end);
+    }
+    utils::deblockPlane(reconstructed_samples, layout.width, layout.height, channels, BLOCK_SIZE,
+                        steps.data(), m_pool);
+    return record;
+}
+
+bool InterFrameCoder::isBlockRecord(const std::vector<uint8_t> &record) {
+    return record.size() >= BLOCK_HEADER_BYTES && record[0] == BLOCKS;
+}
+
+/// @brief Absolute difference of two samples, without a branch
+static inline uint8_t absDifference(uint8_t a, uint8_t b) {
+    return static_cast<uint8_t>(std::max(a, b) - std::min(a, b));
+}
+
+/// @brief Sum of absolute differences between two sample planes, per block in raster order
+static std::vector<uint32_t> blockDifferences(const uint8_t *samples, const uint8_t *reference,
+                                              const algorithm::PayloadLayout &layout, int blockSize) {
+    int blocks_x = (layout.width + blockSize - 1) / blockSize;
+    int blocks_y = (layout.height + blockSize - 1) / blockSize;
+    size_t row_bytes = static_cast<size_t>(layout.width) * layout.channels;
+    size_t block_bytes = static_cast<size_t>(blockSize) * layout.channels;
+    std::vector<uint32_t> sums(static_cast<size_t>(blocks_x) * blocks_y, 0);
+    std::vector<uint8_t> difference(row_bytes);
+
+    for (int y = 0; y < layout.height; y++) {
+        const uint8_t *row_samples = samples + static_cast<size_t>(y) * row_bytes;
+        const uint8_t *row_reference = reference + static_cast<size_t>(y) * row_bytes;
+        size_t i = 0;
+        for (; i + LANE_SAMPLES <= row_bytes; i += LANE_SAMPLES) {
+            uint8_t lane_samples[LANE_SAMPLES], lane_reference[LANE_SAMPLES], lane_difference[LANE_SAMPLES];
+            std::memcpy(lane_samples, row_samples + i, LANE_SAMPLES);
+            std::memcpy(lane_reference, row_reference + i, LANE_SAMPLES);
+            for (int k = 0; k < LANE_SAMPLES; k++) {
+                lane_difference[k] = absDifference(lane_samples[k], lane_reference[k]);
+            }
+            std::memcpy(difference.data() + i, lane_difference, LANE_SAMPLES);
+        }
+        for (; i < row_bytes; i++) difference[i] = absDifference(row_samples[i], row_reference[i]);
+
+        uint32_t *row_sums = sums.data() + static_cast<size_t>(y / blockSize) * blocks_x;
+        for (int bx = 0; bx < blocks_x; bx++) {
+            size_t begin = bx * block_bytes, end = std::min(row_bytes, begin + block_bytes);
+            uint32_t sum = 0;
+            for (size_t j = begin; j < end; j++) sum += difference[j];
+            row_sums[bx] += sum;
+        }
+    }
+    return sums;
+}
+
+/// @brief Bits of a per-block index into `references` references (at least one)
+int InterFrameCoder::indexBits(size_t references) {
+    int bits = 1;
+    while ((size_t{1} << bits) < references) bits++;
+    return bits;
+}
+
+/// @brief Pack one index of `bits` bits per block, raster order, least significant bit first
+static std::vector<uint8_t> packIndices(const std::vector<uint8_t> &indices, int bits) {
+    std::vector<uint8_t> referenceMap((indices.size() * bits + 7) / 8, 0);
+    for (size_t i = 0; i < indices.size(); i++) {
+        for (int b = 0; b < bits; b++) {
+            size_t bit = i * bits + b;
+            referenceMap[bit / 8] |= static_cast<uint8_t>((indices[i] >> b & 1u) << (bit % 8));
+        }
+    }
+    return referenceMap;
+}
+
+static std::vector<uint8_t> unpackIndices(const uint8_t *referenceMap, size_t blocks, int bits) {
+    std::vector<uint8_t> indices(blocks, 0);
+    for (size_t i = 0; i < blocks; i++) {
+        for (int b = 0; b < bits; b++) {
+            size_t bit = i * bits + b;
+            indices[i] |= static_cast<uint8_t>((referenceMap[bit / 8] >> (bit % 8) & 1u) << b);
+        }
+    }
+    return indices;
+}
+
+/**
+ * @brief Index of the reference with the smallest sum of absolute differences to the payload, per block
+ *  A reference only wins a block when it is strictly better than every lower index; references that cannot
+ *  predict the payload (missing, another size or header) are never chosen.
+ */
+std::vector<uint8_t> InterFrameCoder::selectReferences(const std::vector<uint8_t> &payload,
+                                                       const ReferenceList &references,
+                                                       const algorithm::PayloadLayout &layout) const {
+    const uint8_t *samples = payload.data() + layout.header_bytes;
+    std::vector<uint32_t> best =
+        blockDifferences(samples, references[0]->data() + layout.header_bytes, layout, BLOCK_SIZE);
+    std::vector<uint8_t> indices(best.size(), 0);
+    for (size_t r = 1; r < references.size(); r++) {
+        algorithm::PayloadLayout reference_layout;
+        if (!isPredictable(payload, references[r], reference_layout)) continue;
+        std::vector<uint32_t> sums =
+            blockDifferences(samples, references[r]->data() + layout.header_bytes, layout, BLOCK_SIZE);
+        for (size_t block = 0; block < sums.size(); block++) {
+            if (sums[block] >= best[block]) continue;
+            best[block] = sums[block];
+            indices[block] = static_cast<uint8_t>(r);
+        }
+    }
+    return indices;
+}
+
+/// @brief Replace every block of `mixed` whose index is not 0 with the samples of that reference
+void InterFrameCoder::mixReferences(const std::vector<uint8_t> &indices, const ReferenceList &references,
+                                    const algorithm::PayloadLayout &layout, int blockSize,
+                                    std::vector<uint8_t> &mixed) {
+    int blocks_x = (layout.width + blockSize - 1) / blockSize;
+    int blocks_y = (layout.height + blockSize - 1) / blockSize;
+    size_t row_bytes = static_cast<size_t>(layout.width) * layout.channels;
+    uint8_t *samples = mixed.data() + layout.header_bytes;
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            uint8_t index = indices[static_cast<size_t>(by) * blocks_x + bx];
+            if (index == 0) continue;
+            const uint8_t *stored = references[index]->data() + layout.header_bytes;
+            int rows;
+            size_t span, offset;
+            blockExtent(layout, blockSize, bx, by, rows, span, offset);
+            for (int y = 0; y < rows; y++) {
+                std::memcpy(samples + offset + y * row_bytes, stored + offset + y * row_bytes, span);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Choose a reference per block and code the payload against the mixed prediction
+ *  When every block keeps references[0] (or it cannot predict the payload), `inner` receives a plain
+ *  record against references[0] and the result is false.
+ */
+bool InterFrameCoder::codeMixture(const std::vector<uint8_t> &payload, const ReferenceList &references,
+                                  int quantStep, bool blocks, std::vector<uint8_t> &referenceMap,
+                                  std::vector<uint8_t> &inner, std::vector<uint8_t> &reconstruction) const {
+    algorithm::PayloadLayout layout;
+    std::vector<uint8_t> indices;
+    if (isPredictable(payload, references[0], layout) && layout.width > 0 && layout.height > 0) {
+        indices = selectReferences(payload, references, layout);
+    }
+    if (std::none_of(indices.begin(), indices.end(), [](uint8_t index) { return index != 0; })) {
+        inner = blocks ? encodeBlocks(payload, references[0], quantStep, reconstruction)
+                       : encode(payload, references[0], quantStep, reconstruction);
+        return false;
+    }
+
+    std::vector<uint8_t> mixed = *references[0];
+    mixReferences(indices, references, layout, BLOCK_SIZE, mixed);
+    inner = blocks ? encodeBlocks(payload, &mixed, quantStep, reconstruction)
+                   : encode(payload, &mixed, quantStep, reconstruction);
+    referenceMap = packIndices(indices, indexBits(references.size()));
+    return true;
+}
+
+std::vector<uint8_t> InterFrameCoder::encodeMixed(const std::vector<uint8_t> &payload,
+                                                  const std::vector<uint8_t> *prediction,
+                                                  const std::vector<uint8_t> *background, int quantStep,
+                                                  bool blocks, std::vector<uint8_t> &reconstruction) const {
+    std::vector<uint8_t> referenceMap, inner;
+    if (!codeMixture(payload, {prediction, background}, quantStep, blocks, referenceMap, inner,
+                     reconstruction)) {
+        return inner;
+    }
+
+    uint32_t map_size = static_cast<uint32_t>(referenceMap.size());
+    std::vector<uint8_t> record(MIXED_HEADER_BYTES);
+    record[0] = MIXED;
+    record[1] = BLOCK_SIZE;
+    std::memcpy(record.data() + 2, &map_size, 4);
+    record.insert(record.end(), referenceMap.begin(), referenceMap.end());
+    record.insert(record.end(), inner.begin(), inner.end());
+    return record;
+}
+
+std::vector<uint8_t> InterFrameCoder::encodeMulti(const std::vector<uint8_t> &payload,
+                                                  const ReferenceList &references,
+                                                  const std::vector<uint8_t> *background, int quantStep,
+                                                  bool blocks, std::vector<uint8_t> &reconstruction) const {
+    if (references.empty()) return encode(payload, nullptr, quantStep, reconstruction);
+    size_t count = std::min<size_t>(references.size(), 255);
+    ReferenceList candidates(references.begin(), references.begin() + count);
+    uint8_t short_term = static_cast<uint8_t>(candidates.size());
+    if (background) candidates.push_back(background);
+
+    std::vector<uint8_t> referenceMap, inner;
+    if (!codeMixture(payload, candidates, quantStep, blocks, referenceMap, inner, reconstruction)) {
+        return inner;
+    }
+
+    uint32_t map_size = static_cast<uint32_t>(referenceMap.size());
+    std::vector<uint8_t> record(MULTI_HEADER_BYTES);
+    record[0] = MULTI;
+    record[1] = BLOCK_SIZE;
+    record[2] = short_term;
+    record[3] = background ? 1 : 0;
+    std::memcpy(record.data() + 4, &map_size, 4);
+    record.insert(record.end(), referenceMap.begin(), referenceMap.end());
+    record.insert(record.end(), inner.begin(), inner.end());
+    return record;
+}
+
+std::vector<uint8_t> InterFrameCoder::mixedInnerRecord(const std::vector<uint8_t> &record) {
+    if (record.empty() || (record[0] != MIXED && record[0] != MULTI)) return {};
+    size_t header_bytes = record[0] == MULTI ? MULTI_HEADER_BYTES : MIXED_HEADER_BYTES;
+    if (record.size() < header_bytes) return {};
+    uint32_t map_size;
+    std::memcpy(&map_size, record.data() + header_bytes - 4, 4);
+    if (record.size() - header_bytes < map_size) return {};
+    return std::vector<uint8_t>(record.begin() + header_bytes + map_size, record.end());
+}
+
+bool InterFrameCoder::multiReferenceCounts(const std::vector<uint8_t> &record, int &shortTerm,
+                                           int &longTerm) {
+    if (record.size() < MULTI_HEADER_BYTES || record[0] != MULTI) return false;
+    shortTerm = record[2];
+    longTerm = record[3];
+    return true;
+}
+
+bool InterFrameCoder::refreshBand(const std::vector<uint8_t> &record, int &band, int &bands) {
+    if (record.size() < REFRESH_HEADER_BYTES || record[0] != REFRESH) return false;
+    uint16_t band_field, bands_field;
+    std::memcpy(&band_field, record.data() + 2, 2);
+    std::memcpy(&bands_field, record.data() + 4, 2);
+    band = band_field;
+    bands = bands_field;
+    return true;
+}
+
+bool InterFrameCoder::decode(const std::vector<uint8_t> &record, const std::vector<uint8_t> *prediction,
+                             std::vector<uint8_t> &payload, const std::vector<uint8_t> *background,
+                             const ReferenceList *references) const {
+    if (record.empty()) return false;
+    if (record[0] == RAW) {
+        payload.assign(record.begin() + 1, record.end());
+        return true;
+    }
+    if (record[0] == REFRESH) return decodeRefresh(record, prediction, payload);
+    if (record[0] == BLOCKS) return decodeBlocks(record, prediction, payload);
+    if (record[0] == MIXED) return decodeMixed(record, prediction, background, payload);
+    if (record[0] == MULTI) return decodeMulti(record, background, references, payload);
+
+    algorithm::PayloadLayout layout;
+    if (record[0] != RESIDUAL || record.size() < 2 || !prediction ||
+        !m_algorithm->describePayload(*prediction, layout)) {
+        return false;
+    }
+
+    int quantStep = record[1];
+    payload.resize(prediction->size());
+    std::copy(prediction->begin(), prediction->begin() + layout.header_bytes, payload.begin());
+    size_t samples_end = layout.header_bytes + layout.sample_bytes;
+
+    utils::BitReader reader(record.data() + 2, record.size() - 2);
+    return utils::decodeResidual(reader, prediction->data() + layout.header_bytes, layout.sample_bytes,
+                                 quantStep, payload.data() + layout.header_bytes) &&
+           utils::decodeResidual(reader, prediction->data() + samples_end,
+                                 prediction->size() - samples_end, 1, payload.data() + samples_end);
+}
+
+bool InterFrameCoder::decodeRefresh(const std::vector<uint8_t> &record,
+                                    const std::vector<uint8_t> *prediction,
+                                    std::vector<uint8_t> &payload) const {
+    int band, bands;
+    if (!refreshBand(record, band, bands) || bands == 0 || band >= bands) return false;
+    int quantStep = record[1];
+    uint32_t payload_size;
+    uint16_t header_size;
+    std::memcpy(&payload_size, record.data() + 6, 4);
+    std::memcpy(&header_size, record.data() + 10, 2);
+    if (header_size > payload_size || record.size() < REFRESH_HEADER_BYTES + header_size) return false;
+    // The size is untrusted: a reconstruction always has the size of the reference, and a decoder joining
+    // here without one can only bound it
+    bool joining = !prediction || prediction->empty();
+    if (joining ? payload_size > MAX_REFRESH_PAYLOAD_BYTES : payload_size != prediction->size()) return false;
+
+    // The header alone determines the layout; the samples start out mid-gray
+    const uint8_t *header = record.data() + REFRESH_HEADER_BYTES;
+    payload.assign(payload_size, 128);
+    std::copy(header, header + header_size, payload.begin());
+    algorithm::PayloadLayout layout;
+    if (!m_algorithm->describePayload(payload, layout) || layout.header_bytes != header_size) return false;
+
+    std::vector<uint8_t> gray;
+    if (!isPredictable(payload, prediction, layout)) {
+        gray = payload;
+        prediction = &gray;
+    }
+
+    size_t begin, end;
+    bandRange(layout, band, bands, begin, end);
+    const uint8_t *band_samples = header + header_size;
+    if (record.size() < REFRESH_HEADER_BYTES + header_size + (end - begin)) return false;
+
+    uint8_t *samples = payload.data() + layout.header_bytes;
+    const uint8_t *predicted = prediction->data() + layout.header_bytes;
+    size_t samples_end = layout.header_bytes + layout.sample_bytes;
+    std::copy(band_samples, band_samples + (end - begin), samples + begin);
+
+    size_t coded_offset = REFRESH_HEADER_BYTES + header_size + (end - begin);
+    utils::BitReader reader(record.data() + coded_offset, record.size() - coded_offset);
+    return utils::decodeResidual(reader, predicted, begin, quantStep, samples) &&
+           utils::decodeResidual(reader, predicted + end, layout.sample_bytes - end, quantStep,
+                                 samples + end) &&
+           utils::decodeResidual(reader, prediction->data() + samples_end, payload_size - samples_end, 1,
+                                 payload.data() + samples_end);
+}
+
+bool InterFrameCoder::decodeBlocks(const std::vector<uint8_t> &record,
+                                   const std::vector<uint8_t> *prediction,
+                                   std::vector<uint8_t> &payload) const {
+    algorithm::PayloadLayout layout;
+    if (!isBlockRecord(record) || !prediction || !m_algorithm->describePayload(*prediction, layout) ||
+        layout.width <= 0 || layout.height <= 0 || record[2] < 4) {
+        return false;
+    }
+    int quantStep = record[1], block_size = record[2], channels = layout.channels;
+    payload = *prediction;
+
+    size_t row_bytes = static_cast<size_t>(layout.width) * channels;
+    int blocks_x = (layout.width + block_size - 1) / block_size;
+    int blocks_y = (layout.height + block_size - 1) / block_size;
+    std::vector<uint8_t> steps(static_cast<size_t>(blocks_x) * blocks_y);
+    std::vector<uint8_t> predicted, reconstructed;
+    const uint8_t *predicted_samples = prediction->data() + layout.header_bytes;
+    uint8_t *samples = payload.data() + layout.header_bytes;
+    size_t samples_end = layout.header_bytes + layout.sample_bytes;
+
+    utils::BitReader reader(record.data() + BLOCK_HEADER_BYTES, record.size() - BLOCK_HEADER_BYTES);
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            uint32_t block_class;
+            if (!reader.getBits(2, block_class)) return false;
+            int step = blockStep(block_class, quantStep);
+            steps[static_cast<size_t>(by) * blocks_x + bx] = block_class == SKIP ? 1 : step;
+            if (block_class == SKIP) continue;
+
+            int rows;
+            size_t span, offset;
+            blockExtent(layout, block_size, bx, by, rows, span, offset);
+            predicted.resize(span * rows);
+            reconstructed.resize(span * rows);
+            gatherBlock(predicted_samples, row_bytes, offset, span, rows, predicted.data());
+            if (!utils::decodeResidual(reader, predicted.data(), predicted.size(), step,
+                                       reconstructed.data())) {
+                return false;
+            }
+            scatterBlock(reconstructed.data(), span, rows, samples, row_bytes, offset);
+        }
+    }
+    if (!utils::decodeResidual(reader, prediction->data() + samples_end, prediction->size() - samples_end,
+                               1, payload.data() + samples_end)) {
+        return false;
+    }
+    utils::deblockPlane(samples, layout.width, layout.height, channels, block_size, steps.data(),
+                        m_pool);
+    return true;
+}
+
+bool InterFrameCoder::decodeMixed(const std::vector<uint8_t> &record, const std::vector<uint8_t> *prediction,
+                                  const std::vector<uint8_t> *background,
+                                  std::vector<uint8_t> &payload) const {
+    return background && decodeMixture(record, MIXED_HEADER_BYTES, {prediction, background}, payload);
+}
+
+/// @brief The record names how many references of the window and whether the background it indexes
+bool InterFrameCoder::decodeMulti(const std::vector<uint8_t> &record, const std::vector<uint8_t> *background,
+                                  const ReferenceList *references, std::vector<uint8_t> &payload) const {
+    int short_term, long_term;
+    if (!multiReferenceCounts(record, short_term, long_term) || !references || short_term < 1 ||
+        static_cast<size_t>(short_term) > references->size() || long_term > 1 || (long_term && !background)) {
+        return false;
+    }
+    ReferenceList candidates(references->begin(), references->begin() + short_term);
+    if (long_term) candidates.push_back(background);
+    return decodeMixture(record, MULTI_HEADER_BYTES, candidates, payload);
+}
+
+/// @brief Mix the references selected by a mixed or multi-reference record and decode its inner record
+bool InterFrameCoder::decodeMixture(const std::vector<uint8_t> &record, size_t headerBytes,
+                                    const ReferenceList &references, std::vector<uint8_t> &payload) const {
+    algorithm::PayloadLayout layout;
+    const std::vector<uint8_t> *prediction = references[0];
+    if (record.size() < headerBytes || record[1] < 4 || !prediction ||
+        !m_algorithm->describePayload(*prediction, layout) || layout.width <= 0 || layout.height <= 0) {
+        return false;
+    }
+    int block_size = record[1], bits = indexBits(references.size());
+    size_t blocks = static_cast<size_t>((layout.width + block_size - 1) / block_size) *
+                    ((layout.height + block_size - 1) / block_size);
+    size_t map_size = (blocks * bits + 7) / 8;
+    std::vector<uint8_t> inner = mixedInnerRecord(record);
+    if (record.size() != headerBytes + map_size + inner.size() || inner.empty() || inner[0] == MIXED ||
+        inner[0] == MULTI) {
+        return false;
+    }
+
+    std::vector<uint8_t> indices = unpackIndices(record.data() + headerBytes, blocks, bits);
+    for (uint8_t index : indices) {
+        if (index >= references.size() || !references[index] ||
+            references[index]->size() != prediction->size()) {
+            return false;
+        }
+    }
+    std::vector<uint8_t> mixed = *prediction;
+    mixReferences(indices, references, layout, block_size, mixed);
+    return decode(inner, &mixed, payload);
+}
+
+std::vector<uint8_t> InterFrameCoder::averagePrediction(const std::vector<uint8_t> &a,
+                                                        const std::vector<uint8_t> &b) {
+    std::vector<uint8_t> average;
+    if (a.size() != b.size()) return average;
+    average.resize(a.size());
+    for (size_t i = 0; i < a.size(); i++) average[i] = static_cast<uint8_t>((a[i] + b[i] + 1) / 2);
+    return average;
+}
+
+} // namespace core
+} // namespace vcompress
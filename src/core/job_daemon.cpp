@@ -0,0 +1,287 @@
+#include "core/job_daemon.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace vcompress {
+namespace core {
+
+static const size_t MAX_MESSAGE_BYTES = 1u << 20;
+// Blocking calls wake up this often to notice a shutdown
+static const int POLL_INTERVAL_MS = 200;
+
+/// @brief Wait until `fd` has data (or a connection); false once the daemon is stopping
+static bool waitReadable(int fd, const std::atomic<bool> &stopping) {
+    pollfd entry = {fd, POLLIN, 0};
+    while (!stopping) {
+        int ready = poll(&entry, 1, POLL_INTERVAL_MS);
+        if (ready > 0) return true;
+        if (ready < 0 && errno != EINTR) return false;
+    }
+    return false;
+}
+
+static bool readExact(int fd, char *data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        size -= received;
+    }
+    return true;
+}
+
+static bool writeExact(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/// @brief | length (4, big-endian) | JSON |
+static bool readMessage(int fd, std::string &message, const std::atomic<bool> &stopping) {
+    uint8_t prefix[4];
+    if (!waitReadable(fd, stopping) || !readExact(fd, reinterpret_cast<char *>(prefix), 4)) return false;
+    size_t length = (static_cast<size_t>(prefix[0]) << 24) | (prefix[1] << 16) | (prefix[2] << 8) | prefix[3];
+    if (length > MAX_MESSAGE_BYTES) return false;
+    message.resize(length);
+    return readExact(fd, &message[0], length);
+}
+
+static bool writeMessage(int fd, const std::string &message) {
+    uint32_t length = static_cast<uint32_t>(message.size());
+    uint8_t prefix[4] = {static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+                         static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+    return writeExact(fd, reinterpret_cast<const char *>(prefix), 4) &&
+           writeExact(fd, message.data(), message.size());
+}
+
+static cv::FileStorage openResponse() {
+    return cv::FileStorage(".json", cv::FileStorage::WRITE | cv::FileStorage::MEMORY |
+                                        cv::FileStorage::FORMAT_JSON);
+}
+
+static std::string errorResponse(const std::string &error) {
+    cv::FileStorage response = openResponse();
+    response << "status" << "error" << "error" << error;
+    return response.releaseAndGetString();
+}
+
+JobDaemon::JobDaemon() : m_listenFd(-1), m_stopping(false), m_nextJobNumber(0) {}
+
+JobDaemon::~JobDaemon() {
+    m_stopping = true;
+    m_queueChanged.notify_all();
+    if (m_dispatcher.joinable()) m_dispatcher.join();
+    reapClients(true);
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        unlink(m_socketPath.c_str());
+    }
+}
+
+bool JobDaemon::open(const std::string &socketPath, const BatchConfig &config) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path is too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    // Only a socket left behind by an earlier daemon is replaced, never a file that happens to be there
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "Error: " << socketPath << " exists and is not a socket" << std::endl;
+            return false;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0) {
+        std::cerr << "Error: Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    bool bound = bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    if (!bound || chmod(socketPath.c_str(), 0600) < 0 || listen(m_listenFd, 16) < 0) {
+        std::cerr << "Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (bound) unlink(socketPath.c_str());
+        close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    m_socketPath = socketPath;
+    m_runner.config() = config;
+    return true;
+}
+
+bool JobDaemon::enqueue(BatchJob &job) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (job.id.empty()) job.id = "job" + std::to_string(m_nextJobNumber++);
+    auto tracked = std::make_shared<TrackedJob>();
+    tracked->job = job;
+
+    auto existing = m_jobs.find(tracked->job.id);
+    if (existing != m_jobs.end() &&
+        (existing->second->state == "queued" || existing->second->state == "running")) {
+        return false;
+    }
+    m_jobs[tracked->job.id] = tracked;
+    m_queue.push_back(tracked);
+    m_queueChanged.notify_one();
+    return true;
+}
+
+bool JobDaemon::serve() {
+    if (m_listenFd < 0) return false;
+    std::cout << "Daemon listening on " << m_socketPath << std::endl;
+    m_dispatcher = std::thread(&JobDaemon::dispatch, this);
+
+    while (waitReadable(m_listenFd, m_stopping)) {
+        int client = accept(m_listenFd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Error: accept failed: " << std::strerror(errno) << std::endl;
+            m_stopping = true;
+            break;
+        }
+        reapClients(false);
+        Client &entry = m_clients.emplace_back();
+        entry.thread = std::thread(&JobDaemon::serveClient, this, client, std::ref(entry));
+    }
+
+    // Stop accepting, then let the queued and running jobs finish
+    close(m_listenFd);
+    unlink(m_socketPath.c_str());
+    m_listenFd = -1;
+    m_queueChanged.notify_all();
+    reapClients(true);
+    m_dispatcher.join();
+
+    std::cout << m_runner.getStats() << std::endl;
+    return true;
+}
+
+/**
+ * @brief Hand queued jobs to the runner in submission order
+ *  Admission blocks here rather than in a client thread, so clients get their answer immediately.
+ */
+void JobDaemon::dispatch() {
+    while (true) {
+        std::shared_ptr<TrackedJob> tracked;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueChanged.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty()) break;
+            tracked = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        m_runner.submit(
+            tracked->job, [tracked](int frames) { tracked->frames = frames; },
+            [this, tracked](const BatchResult &result) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                tracked->result = result;
+                tracked->state = result.success ? "done" : "failed";
+            });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (tracked->state == "queued") tracked->state = "running";
+    }
+    m_runner.wait();
+}
+
+/// @brief Join the threads of closed connections, or of every connection if `all`
+void JobDaemon::reapClients(bool all) {
+    for (auto client = m_clients.begin(); client != m_clients.end();) {
+        if (all || client->finished) {
+            client->thread.join();
+            client = m_clients.erase(client);
+        } else {
+            ++client;
+        }
+    }
+}
+
+void JobDaemon::serveClient(int fd, Client &client) {
+    std::string request;
+    while (readMessage(fd, request, m_stopping)) {
+        if (!writeMessage(fd, handleRequest(request))) break;
+    }
+    close(fd);
+    client.finished = true;
+}
+
+std::string JobDaemon::handleRequest(const std::string &request) {
+    try {
+        cv::FileStorage message(request, cv::FileStorage::READ | cv::FileStorage::MEMORY |
+                                             cv::FileStorage::FORMAT_JSON);
+        std::string command, id;
+        cv::read(message["command"], command, "");
+        cv::read(message["id"], id, "");
+
+        if (command == "submit") {
+            BatchJob job;
+            std::string error;
+            if (!BatchRunner::parseJob(message["job"], job, error)) return errorResponse(error);
+            if (m_stopping) return errorResponse("the daemon is shutting down");
+            if (!enqueue(job)) return errorResponse("job " + job.id + " is already queued or running");
+
+            cv::FileStorage response = openResponse();
+            response << "status" << "queued" << "id" << job.id;
+            return response.releaseAndGetString();
+        }
+        if (command == "status") return describeJobs(id);
+        if (command == "shutdown") {
+            m_stopping = true;
+            m_queueChanged.notify_all();
+            cv::FileStorage response = openResponse();
+            response << "status" << "stopping";
+            return response.releaseAndGetString();
+        }
+        return errorResponse("unknown command '" + command + "'");
+    } catch (const cv::Exception &e) {
+        return errorResponse(std::string("invalid request: ") + e.what());
+    }
+}
+
+/// @brief State and progress of one job, or of every job if `id` is empty
+std::string JobDaemon::describeJobs(const std::string &id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!id.empty() && m_jobs.find(id) == m_jobs.end()) return errorResponse("unknown job '" + id + "'");
+
+    cv::FileStorage response = openResponse();
+    response << "status" << "ok" << "jobs" << "[";
+    for (const auto &entry : m_jobs) {
+        if (!id.empty() && entry.first != id) continue;
+        const TrackedJob &tracked = *entry.second;
+        response << "{" << "id" << tracked.job.id << "mode" << tracked.job.mode << "input"
+                 << tracked.job.input << "output" << tracked.job.output << "state" << tracked.state
+                 << "frames" << tracked.frames.load();
+        if (tracked.state == "done" || tracked.state == "failed") {
+            response << "error" << tracked.result.error << "input_bytes"
+                     << static_cast<double>(tracked.result.inputBytes) << "output_bytes"
+                     << static_cast<double>(tracked.result.outputBytes) << "seconds"
+                     << tracked.result.seconds;
+        }
+        response << "}";
+    }
+    response << "]";
+    return response.releaseAndGetString();
+}
+
+} // namespace core
+} // namespace vcompress
@@ -0,0 +1,184 @@
+#include "core/ladder_encoder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace vcompress {
+namespace core {
+
+LadderEncoder::LadderEncoder() : m_fileReader(std::make_unique<utils::FileReader>()), m_pool(nullptr) {
+    m_stats.framesDecoded = 0;
+    m_stats.totalProcessingTime = 0.0;
+}
+
+LadderEncoder::~LadderEncoder() = default;
+
+std::string LadderEncoder::rungPath(const std::string &basePath, const LadderRung &rung) {
+    if (!rung.compressedDataPath.empty()) return rung.compressedDataPath;
+
+    size_t slash = basePath.find_last_of('/');
+    size_t dot = basePath.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = basePath.size();
+    return basePath.substr(0, dot) + "_" + rung.algorithmName + "_q" + std::to_string(rung.quality) +
+           basePath.substr(dot);
+}
+
+bool LadderEncoder::parseRungs(const std::string &spec, int defaultQuality, std::vector<LadderRung> &rungs) {
+    std::stringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t colon = item.find(':');
+        std::string algo = item.substr(0, colon);
+        int quality = defaultQuality;
+        if (colon != std::string::npos) {
+            const char *digits = item.c_str() + colon + 1;
+            char *end = nullptr;
+            long parsed = std::strtol(digits, &end, 10);
+            if (end == digits || *end != '\0') {
+                std::cerr << "Error: Ladder rung '" << item << "' needs a numeric quality." << std::endl;
+                return false;
+            }
+            quality = static_cast<int>(std::clamp(parsed, 1L, 100L));
+        }
+        if (!algorithm::AlgorithmFactory::isAlgorithmAvailable(algo)) {
+            std::cerr << "Error: Algorithm '" << algo << "' in the ladder is not available." << std::endl;
+            return false;
+        }
+        rungs.emplace_back(algo, std::clamp(quality, 1, 100));
+    }
+    return true;
+}
+
+bool LadderEncoder::configure(const LadderConfig &config) {
+    m_config = config;
+    if (m_config.rungs.empty()) {
+        std::cerr << "Error: A ladder needs at least one rung" << std::endl;
+        return false;
+    }
+    if (m_config.base.liveMode) {
+        std::cerr << "Error: Ladder encoding is not available in live mode" << std::endl;
+        return false;
+    }
+    // The ladder drives the rung encoders frame by frame, bypassing the GOP cache, checkpoints and frame
+    // ranges of VideoEncoder::encode; reject them before a rung configure creates any of their files
+    if (!m_config.base.gopCacheDir.empty() || m_config.base.resume) {
+        std::cerr << "Error: Ladder encoding supports neither the GOP cache nor resuming" << std::endl;
+        return false;
+    }
+    if (m_config.base.startFrame > 0 || m_config.base.endFrame > 0) {
+        std::cerr << "Error: Ladder encoding always covers the whole input, not a frame range" << std::endl;
+        return false;
+    }
+
+    if (!m_pool) {
+        size_t threads = m_config.threads > 0 ? m_config.threads : m_config.rungs.size();
+        m_ownedPool = std::make_unique<utils::ThreadPool>(threads);
+        m_pool = m_ownedPool.get();
+    }
+
+    m_encoders.clear();
+    for (auto &rung : m_config.rungs) {
+        rung.compressedDataPath = rungPath(m_config.base.compressedDataPath, rung);
+
+        EncoderConfig rungConfig = m_config.base;
+        rungConfig.algorithmName = rung.algorithmName;
+        rungConfig.quality = rung.quality;
+        rungConfig.compressedDataPath = rung.compressedDataPath;
+
+        auto encoder = std::make_unique<VideoEncoder>();
+        encoder->setThreadPool(m_pool);
+        if (!encoder->configure(rungConfig)) {
+            std::cerr << "Error: Failed to configure rung " << rung.algorithmName << " q" << rung.quality
+                      << std::endl;
+            return false;
+        }
+        m_encoders.push_back(std::move(encoder));
+    }
+    return true;
+}
+
+/**
+ * @brief Fan every decoded frame out to all rungs
+ *  Decoding the next frame overlaps with encoding the current one; the rungs of a frame are joined
+ *  before the next frame is handed out, since each encoder consumes frames in order.
+ */
+bool LadderEncoder::encode() {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const EncoderConfig &base = m_config.base;
+
+    if (base.keepAudio) {
+        std::cout << "Extracting audio once for " << m_encoders.size() << " ladder outputs..." << std::endl;
+        if (!utils::extractAudio(base.inputPath, base.tempAudioPath)) {
+            std::cerr << "Failed to extract audio from input video" << std::endl;
+            return false;
+        }
+    }
+
+    m_fileReader->setFrameCacheDir(base.frameCacheDir); // Created by the rung encoders' configure
+    if (!m_fileReader->openFile(base.inputPath)) {
+        std::cerr << "Error: Could not open input video: " << base.inputPath << std::endl;
+        return false;
+    }
+    int width = m_fileReader->getWidth();
+    int height = m_fileReader->getHeight();
+    double fps = m_fileReader->getFPS();
+    for (size_t i = 0; i < m_encoders.size(); i++) {
+        if (!m_encoders[i]->beginStream(m_config.rungs[i].compressedDataPath, width, height, fps)) {
+            return false;
+        }
+    }
+
+    cv::Mat image;
+    std::shared_ptr<const algorithm::Frame> current;
+    utils::ThreadPool::TaskGroup rungs;
+    while (m_fileReader->readNextFrame(image)) {
+        // Shared preprocessing: the frame is converted out of the decoder's buffer once for all rungs
+        auto next = std::make_shared<const algorithm::Frame>(
+            m_encoders.front()->makeInputFrame(image, m_stats.framesDecoded));
+        m_pool->wait(rungs);
+
+        current = std::move(next);
+        for (auto &encoder : m_encoders) {
+            VideoEncoder *rungEncoder = encoder.get();
+            m_pool->submit([rungEncoder, current]() { rungEncoder->encodeFrame(*current); }, &rungs);
+        }
+
+        m_stats.framesDecoded++;
+        if (m_stats.framesDecoded % 500 == 0) {
+            std::cout << "Decoded " << m_stats.framesDecoded << " frames for the ladder..." << std::endl;
+        }
+    }
+    m_pool->wait(rungs);
+
+    for (auto &encoder : m_encoders) m_pool->submit([&encoder]() { encoder->endStream(); }, &rungs);
+    m_pool->wait(rungs);
+    m_fileReader->close();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    m_stats.totalProcessingTime = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::cout << "Ladder encoding completed: " << m_stats.framesDecoded << " frames into "
+              << m_encoders.size() << " outputs" << std::endl;
+    for (const auto &rung : m_config.rungs) std::cout << "  " << rung.compressedDataPath << std::endl;
+    std::cout << getStats() << std::endl;
+    return true;
+}
+
+std::string LadderEncoder::getStats() const {
+    std::stringstream ss;
+    ss << "Ladder Statistics:" << std::endl
+       << "  Source frames decoded: " << m_stats.framesDecoded << std::endl
+       << "  Outputs: " << m_encoders.size() << std::endl
+       << "  Worker threads: " << (m_pool ? m_pool->size() : 0) << std::endl
+       << "  Total processing time: " << m_stats.totalProcessingTime << " seconds" << std::endl;
+    for (size_t i = 0; i < m_encoders.size(); i++) {
+        ss << "Rung " << i << " (" << m_config.rungs[i].compressedDataPath << "):" << std::endl
+           << m_encoders[i]->getStats();
+    }
+    return ss.str();
+}
+
+} // namespace core
+} // namespace vcompress
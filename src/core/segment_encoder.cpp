@@ -0,0 +1,446 @@
+#include "core/segment_encoder.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <spawn.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace vcompress {
+namespace core {
+
+static const int POLL_INTERVAL_MS = 1000;
+// Frames between refreshes of a worker's claim
+static const int CLAIM_REFRESH_FRAMES = 50;
+// Failed or stale attempts at one segment before the encode is given up
+static const int MAX_SEGMENT_ATTEMPTS = 3;
+
+static std::string segmentName(int index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "seg_%05d", index);
+    return name;
+}
+
+static bool fileExists(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+static bool makeDirectory(const std::string &path) {
+    return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+}
+
+/// @brief Sorted visible entries of a directory
+static std::vector<std::string> listDirectory(const std::string &path) {
+    std::vector<std::string> names;
+    if (DIR *directory = opendir(path.c_str())) {
+        while (dirent *entry = readdir(directory)) {
+            if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+        }
+        closedir(directory);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+/// @brief Readers on other nodes see either no file or the complete file
+static bool writeFileAtomically(const std::string &path, const std::string &content) {
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        if (!(file << content) || !file.flush()) return false;
+    }
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+/// @brief "key value" lines; the value is the rest of the line
+static std::map<std::string, std::string> readSettingsFile(const std::string &path) {
+    std::map<std::string, std::string> settings;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space != std::string::npos) settings[line.substr(0, space)] = line.substr(space + 1);
+    }
+    return settings;
+}
+
+/// @brief Remove the files of a directory and the directory itself
+static void removeDirectory(const std::string &path) {
+    for (const auto &name : listDirectory(path)) std::remove((path + "/" + name).c_str());
+    rmdir(path.c_str());
+}
+
+/// @brief Host and process, unique across the nodes sharing the directory
+static std::string workerId() {
+    char host[HOST_NAME_MAX + 1] = {};
+    gethostname(host, sizeof(host) - 1);
+    return std::string(host) + "-" + std::to_string(getpid());
+}
+
+bool SegmentCoordinator::run(const SegmentConfig &config) {
+    m_config = config;
+    const EncoderConfig &encoder = m_config.encoder;
+    if (encoder.liveMode || encoder.intraRefreshPeriod > 0 || encoder.keyFrameInterval <= 0) {
+        std::cerr << "Error: Distributed encoding splits at key frames; it needs a key frame interval and "
+                     "cannot be combined with live mode or intra refresh"
+                  << std::endl;
+        return false;
+    }
+    if (!encoder.gopCacheDir.empty() || !encoder.frameCacheDir.empty()) {
+        // The caches are directories of the node that fills them; workers on other nodes would not see them
+        std::cerr << "Error: The GOP and frame caches are local to one node; they cannot be combined with "
+                     "distributed encoding"
+                  << std::endl;
+        return false;
+    }
+    const std::string &dir = m_config.sharedDir;
+    if (!makeDirectory(dir) || !makeDirectory(dir + "/todo") || !makeDirectory(dir + "/claimed") ||
+        !makeDirectory(dir + "/done") || !makeDirectory(dir + "/failed")) {
+        std::cerr << "Error: Could not create the shared directory " << dir << std::endl;
+        return false;
+    }
+    std::remove((dir + "/complete").c_str());
+    m_segments.clear();
+    m_staleClaims.clear();
+
+    // A restarted coordinator picks up the existing plan and the segments already done, if the plan was
+    // made with the same settings; every segment gets its attempts again
+    auto settings = readSettingsFile(dir + "/settings");
+    if (settings.count("segments")) {
+        int count = std::atoi(settings["segments"].c_str());
+        for (int i = 0; i < count; i++) m_segments.push_back(segmentName(i));
+        std::ifstream file(dir + "/settings");
+        std::string stored((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::string current;
+        if (!settingsText(current) || stored != current) {
+            std::cerr << "Error: " << dir << " holds an unfinished encode with other settings; remove it or "
+                         "rerun with the same settings"
+                      << std::endl;
+            return false;
+        }
+        for (const auto &name : listDirectory(dir + "/failed")) {
+            std::remove((dir + "/failed/" + name).c_str());
+        }
+        std::cout << "Continuing the distributed encode in " << dir << std::endl;
+    } else if (!planSegments() || !writeSettings()) {
+        return false;
+    }
+
+    if (encoder.keepAudio && !utils::extractAudio(encoder.inputPath, encoder.tempAudioPath)) {
+        std::cerr << "Failed to extract audio from input video" << std::endl;
+        return false;
+    }
+
+    std::vector<pid_t> workers;
+    for (int i = 0; i < m_config.localWorkers; i++) {
+        std::string programName = "vcompress", mode = "worker";
+        char *argv[] = {&programName[0], &mode[0], const_cast<char *>(dir.c_str()), nullptr};
+        pid_t pid;
+        if (posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, argv, environ) == 0) workers.push_back(pid);
+    }
+    std::cout << "Waiting for " << m_segments.size() << " segments (" << workers.size()
+              << " local workers)..." << std::endl;
+
+    size_t reported = SIZE_MAX;
+    bool success = true;
+    while (true) {
+        size_t done = 0;
+        for (const auto &name : m_segments) done += fileExists(dir + "/done/" + name + ".vcomp");
+        if (done == m_segments.size()) break;
+        if (done != reported) {
+            std::cout << "Segments done: " << done << "/" << m_segments.size() << std::endl;
+            reported = done;
+        }
+        int requeued = requeueStaleClaims();
+        if (requeued > 0) std::cout << "Requeued " << requeued << " stale segments" << std::endl;
+        std::string failed = exhaustedSegment();
+        if (!failed.empty()) {
+            std::cerr << "Error: Segment " << failed << " failed " << MAX_SEGMENT_ATTEMPTS
+                      << " times; giving up the distributed encode" << std::endl;
+            success = false;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+    }
+
+    success = success && concatenateSegments();
+    writeFileAtomically(dir + "/complete", success ? "ok\n" : "failed\n");
+    for (pid_t pid : workers) waitpid(pid, nullptr, 0);
+    // A finished encode leaves only the marker, so the next run in this directory plans afresh; a failed
+    // one keeps its plan and the segments done, to be continued
+    if (success) removePlan();
+    return success;
+}
+
+/// @brief A segment that failed or went stale MAX_SEGMENT_ATTEMPTS times, empty if there is none
+std::string SegmentCoordinator::exhaustedSegment() const {
+    std::map<std::string, int> attempts = m_staleClaims;
+    for (const auto &name : listDirectory(m_config.sharedDir + "/failed")) {
+        attempts[name.substr(0, name.find('.'))]++;
+    }
+    for (const auto &[name, count] : attempts) {
+        if (count >= MAX_SEGMENT_ATTEMPTS) return name;
+    }
+    return "";
+}
+
+/// @brief Remove the settings and the task directories of a finished encode
+void SegmentCoordinator::removePlan() const {
+    const std::string &dir = m_config.sharedDir;
+    std::remove((dir + "/settings").c_str());
+    for (const char *subdirectory : {"/todo", "/claimed", "/done", "/failed"}) {
+        removeDirectory(dir + subdirectory);
+    }
+}
+
+/// @brief Segments of `segmentGops` key frame intervals; the last one runs to the end of the input
+bool SegmentCoordinator::planSegments() {
+    utils::FileReader reader;
+    if (!reader.openFile(m_config.encoder.inputPath)) return false;
+    int frameCount = reader.getFrameCount();
+    reader.close();
+
+    int segmentFrames = std::max(1, m_config.segmentGops) * m_config.encoder.keyFrameInterval;
+    int count = std::max(1, (frameCount + segmentFrames - 1) / segmentFrames);
+    for (int i = 0; i < count; i++) {
+        int start = i * segmentFrames;
+        int end = i + 1 < count ? start + segmentFrames : 0;
+        std::string name = segmentName(i);
+        if (!writeFileAtomically(m_config.sharedDir + "/todo/" + name,
+                                 std::to_string(start) + " " + std::to_string(end) + "\n")) {
+            std::cerr << "Error: Could not write segment task " << name << std::endl;
+            return false;
+        }
+        m_segments.push_back(name);
+    }
+    return true;
+}
+
+/// @brief Written after the tasks, so workers never see settings without a complete plan
+bool SegmentCoordinator::writeSettings() const {
+    std::string text;
+    if (!settingsText(text)) return false;
+    if (!writeFileAtomically(m_config.sharedDir + "/settings", text)) {
+        std::cerr << "Error: Could not write the encode settings to " << m_config.sharedDir << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief The settings file for the current configuration and plan
+bool SegmentCoordinator::settingsText(std::string &text) const {
+    const EncoderConfig &encoder = m_config.encoder;
+    char inputPath[PATH_MAX], sidecarPath[PATH_MAX];
+    std::stringstream ss;
+    ss << "input " << (realpath(encoder.inputPath.c_str(), inputPath) ? inputPath : encoder.inputPath) << "\n"
+       << "algorithm " << encoder.algorithmName << "\n"
+       << "quality " << encoder.quality << "\n"
+       << "bitrate " << encoder.bitrate << "\n"
+       << "key_frame_interval " << encoder.keyFrameInterval << "\n"
+       << "temporal " << encoder.temporalFactor << "\n"
+       << "bframes " << encoder.bFrames << "\n"
+       << "inter " << encoder.interPrediction << "\n"
+       << "block_coding " << encoder.blockCoding << "\n"
+       << "background " << encoder.backgroundReference << "\n"
+       << "references " << encoder.referenceFrames << "\n"
+       << "adaptive " << encoder.adaptiveFactor << "\n"
+       << "enhance " << encoder.enhancementQuantStep << "\n"
+       << "denoise " << encoder.denoiseStrength << "\n"
+       << "bit_depth " << encoder.bitDepth << "\n"
+       << "film_grain " << encoder.filmGrain << "\n"
+       << "segments " << m_segments.size() << "\n";
+    if (!encoder.roiRegions.empty()) {
+        ss << "roi_regions";
+        for (const auto &roi : encoder.roiRegions) {
+            ss << " " << roi.x << " " << roi.y << " " << roi.width << " " << roi.height;
+        }
+        ss << "\n";
+    }
+    if (!encoder.roiSidecarPath.empty()) {
+        // Workers run in other directories, or on other nodes that mount the shared directory
+        if (!realpath(encoder.roiSidecarPath.c_str(), sidecarPath)) {
+            std::cerr << "Error: Could not find the ROI sidecar " << encoder.roiSidecarPath << std::endl;
+            return false;
+        }
+        ss << "roi_sidecar " << sidecarPath << "\n";
+    }
+    text = ss.str();
+    return true;
+}
+
+/// @brief Hand out again the segments whose worker stopped refreshing its claim
+int SegmentCoordinator::requeueStaleClaims() {
+    const std::string &dir = m_config.sharedDir;
+    int requeued = 0;
+    for (const auto &name : listDirectory(dir + "/claimed")) {
+        struct stat info;
+        std::string claimPath = dir + "/claimed/" + name;
+        if (stat(claimPath.c_str(), &info) != 0) continue;
+        if (std::time(nullptr) - info.st_mtime < m_config.leaseSeconds) continue;
+        if (fileExists(dir + "/done/" + name + ".vcomp")) {
+            std::remove(claimPath.c_str());
+        } else if (std::rename(claimPath.c_str(), (dir + "/todo/" + name).c_str()) == 0) {
+            m_staleClaims[name]++;
+            requeued++;
+        }
+    }
+    return requeued;
+}
+
+/// @brief Copy the records of every segment, in order, behind one header
+bool SegmentCoordinator::concatenateSegments() const {
+    const std::string &dir = m_config.sharedDir;
+    const std::string &outputPath = m_config.encoder.compressedDataPath;
+    utils::CompressedFormat output, segment;
+    std::vector<uint8_t> data;
+    uint8_t type;
+    int32_t timestamp;
+    int64_t records = 0;
+
+    for (size_t i = 0; i < m_segments.size(); i++) {
+        std::string segmentPath = dir + "/done/" + m_segments[i] + ".vcomp";
+        if (!segment.openForReading(segmentPath)) {
+            std::cerr << "Error: Could not read segment " << segmentPath << std::endl;
+            return false;
+        }
+        if (i == 0 && !output.openForWriting(outputPath, segment.getOriginalWidth(),
+                                             segment.getOriginalHeight(), segment.getOriginalFPS(),
+                                             segment.getAlgorithmId())) {
+            std::cerr << "Error: Could not create output file: " << outputPath << std::endl;
+            return false;
+        }
+        while (segment.readFrame(data, type, timestamp)) {
+            if (!output.writeFrame(data, type, timestamp)) return false;
+            records++;
+        }
+        segment.close();
+    }
+    output.close();
+
+    std::cout << "Assembled " << records << " records from " << m_segments.size() << " segments into "
+              << outputPath << std::endl;
+    return true;
+}
+
+bool SegmentWorker::readSettings() {
+    auto settings = readSettingsFile(m_sharedDir + "/settings");
+    if (!settings.count("input")) return false;
+    m_encoder.inputPath = settings["input"];
+    m_encoder.algorithmName = settings["algorithm"];
+    m_encoder.quality = std::atoi(settings["quality"].c_str());
+    m_encoder.bitrate = std::atoi(settings["bitrate"].c_str());
+    m_encoder.keyFrameInterval = std::atoi(settings["key_frame_interval"].c_str());
+    m_encoder.temporalFactor = std::atoi(settings["temporal"].c_str());
+    m_encoder.bFrames = std::atoi(settings["bframes"].c_str());
+    m_encoder.interPrediction = std::atoi(settings["inter"].c_str()) != 0;
+    m_encoder.blockCoding = std::atoi(settings["block_coding"].c_str()) != 0;
+    m_encoder.backgroundReference = std::atoi(settings["background"].c_str()) != 0;
+    if (settings.count("references")) m_encoder.referenceFrames = std::atoi(settings["references"].c_str());
+    m_encoder.adaptiveFactor = std::atoi(settings["adaptive"].c_str()) != 0;
+    m_encoder.enhancementQuantStep = std::atoi(settings["enhance"].c_str());
+    m_encoder.denoiseStrength = std::atoi(settings["denoise"].c_str());
+    if (settings.count("bit_depth")) m_encoder.bitDepth = std::atoi(settings["bit_depth"].c_str());
+    m_encoder.filmGrain = std::atoi(settings["film_grain"].c_str()) != 0;
+    std::istringstream rois(settings["roi_regions"]);
+    algorithm::RegionOfInterest roi;
+    while (rois >> roi.x >> roi.y >> roi.width >> roi.height) m_encoder.roiRegions.push_back(roi);
+    m_encoder.roiSidecarPath = settings["roi_sidecar"];
+    m_encoder.keepAudio = false;
+    return m_encoder.keyFrameInterval > 0;
+}
+
+/// @brief rename() moves a task for exactly one worker; the claim time starts now
+bool SegmentWorker::claimSegment(std::string &name) {
+    for (const auto &candidate : listDirectory(m_sharedDir + "/todo")) {
+        std::string claimPath = m_sharedDir + "/claimed/" + candidate;
+        if (std::rename((m_sharedDir + "/todo/" + candidate).c_str(), claimPath.c_str()) == 0) {
+            utimensat(AT_FDCWD, claimPath.c_str(), nullptr, 0);
+            name = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SegmentWorker::encodeSegment(const std::string &name) {
+    std::string claimPath = m_sharedDir + "/claimed/" + name;
+    int start = 0, end = 0;
+    {
+        std::ifstream task(claimPath);
+        if (!(task >> start >> end)) return false;
+    }
+
+    // Each worker writes its own part file; a segment that was handed out twice is published once
+    EncoderConfig config = m_encoder;
+    config.startFrame = start;
+    config.endFrame = end;
+    config.compressedDataPath = m_sharedDir + "/done/" + name + "." + workerId() + ".part";
+
+    VideoEncoder encoder;
+    encoder.setProgressCallback([&claimPath](int frames) {
+        if (frames % CLAIM_REFRESH_FRAMES == 0) utimensat(AT_FDCWD, claimPath.c_str(), nullptr, 0);
+    });
+    std::cout << "Encoding " << name << " (frames " << start << " to "
+              << (end > 0 ? std::to_string(end) : "end") << ")" << std::endl;
+    if (!encoder.configure(config) || !encoder.encode()) {
+        // Every attempt is recorded under a name of its own, so the coordinator counts the attempts of a
+        // segment without workers on different nodes writing to the same file
+        std::remove(config.compressedDataPath.c_str());
+        auto attempt = std::chrono::system_clock::now().time_since_epoch().count();
+        std::string attemptId = workerId() + "." + std::to_string(attempt);
+        writeFileAtomically(m_sharedDir + "/failed/" + name + "." + attemptId, "failed\n");
+        std::rename(claimPath.c_str(), (m_sharedDir + "/todo/" + name).c_str());
+        return false;
+    }
+    std::rename(config.compressedDataPath.c_str(), (m_sharedDir + "/done/" + name + ".vcomp").c_str());
+    std::remove(claimPath.c_str());
+    return true;
+}
+
+/// @brief Claim segments until the coordinator marks the encode complete
+bool SegmentWorker::run(const std::string &sharedDir) {
+    m_sharedDir = sharedDir;
+    if (!readSettings()) {
+        std::cerr << "Error: No distributed encode settings in " << sharedDir << std::endl;
+        return false;
+    }
+
+    // A failed segment goes back to the queue and the worker carries on; the coordinator gives the encode
+    // up once a segment has failed too often
+    int segments = 0, failures = 0;
+    while (!fileExists(m_sharedDir + "/complete")) {
+        std::string name;
+        if (!claimSegment(name)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+            continue;
+        }
+        if (!encodeSegment(name)) {
+            std::cerr << "Error: Failed to encode " << name << std::endl;
+            failures++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+            continue;
+        }
+        segments++;
+    }
+    std::cout << "Worker " << workerId() << " encoded " << segments << " segments" << std::endl;
+    return failures == 0;
+}
+
+} // namespace core
+} // namespace vcompress
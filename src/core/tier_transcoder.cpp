@@ -0,0 +1,232 @@
+#include "core/tier_transcoder.hpp"
+#include "utils/compressed_format.hpp"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+namespace vcompress {
+namespace core {
+
+TierTranscoder::TierTranscoder() {
+    m_stats.recordsResampled = 0;
+    m_stats.recordsCopied = 0;
+    m_stats.recordsSkipped = 0;
+    m_stats.layersDropped = 0;
+    m_stats.inputBytes = 0;
+    m_stats.outputBytes = 0;
+    m_stats.totalProcessingTime = 0.0;
+}
+
+TierTranscoder::~TierTranscoder() = default;
+
+bool TierTranscoder::configure(const RetierConfig &config) {
+    m_config = config;
+    if (m_config.targetFactor == 0) return true; // Stripping copies payloads, no algorithm is needed
+    if (m_config.targetFactor < 2 || m_config.targetFactor > 255) {
+        std::cerr << "Error: The target factor must be between 2 and 255" << std::endl;
+        return false;
+    }
+    m_algorithm = algorithm::AlgorithmFactory::createAlgorithm(m_config.algorithmName);
+    if (!m_algorithm || !m_algorithm->initialize(algorithm::CompressionConfig())) {
+        std::cerr << "Error: Failed to create algorithm: " << m_config.algorithmName << std::endl;
+        return false;
+    }
+    m_interCoder = std::make_unique<InterFrameCoder>(m_algorithm.get());
+
+    // An algorithm without a downsample factor is rejected before any output
+    if (!m_algorithm->resamplesPayloads()) {
+        std::cerr << "Error: " << m_algorithm->getAlgorithmName() << " payloads cannot be resampled"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief Quantizer step stored in residual and refresh records; raw records were coded losslessly
+int TierTranscoder::quantStepOf(const std::vector<uint8_t> &record) {
+    return record.size() > 1 && record[0] != 0 ? record[1] : 1;
+}
+
+/**
+ * @brief Rewrite one anchor or B-frame record
+ *  References are advanced exactly as the decoder advances them, so the input side reconstructs the same
+ *  payloads as a decoder of the input and the output side the same payloads as a decoder of the output.
+ */
+bool TierTranscoder::recode(uint8_t frameType, const std::vector<uint8_t> &record,
+                            std::vector<uint8_t> &output) {
+    std::vector<uint8_t> payload, resampled, reconstruction;
+    if (frameType == algorithm::BIDIRECTIONAL_FRAME) {
+        std::vector<uint8_t> prediction = InterFrameCoder::averagePrediction(m_inputPast, m_inputFuture);
+        if (!m_interCoder->decode(record, prediction.empty() ? nullptr : &prediction, payload)) return false;
+    } else if (frameType == algorithm::PREDICTED_FRAME) {
+        InterFrameCoder::ReferenceList window = m_inputReferences.window(m_inputReferences.size());
+        if (!m_interCoder->decode(record, &m_inputFuture, payload,
+                                  m_inputBackground.empty() ? nullptr : &m_inputBackground, &window)) {
+            return false;
+        }
+    } else {
+        payload = record;
+    }
+
+    if (!m_algorithm->resamplePayload(payload, m_config.targetFactor, resampled)) return false;
+
+    int band, bands;
+    if (frameType == algorithm::BIDIRECTIONAL_FRAME) {
+        std::vector<uint8_t> prediction = InterFrameCoder::averagePrediction(m_outputPast, m_outputFuture);
+        output = encodeLike(record, resampled, prediction.empty() ? nullptr : &prediction, nullptr,
+                            reconstruction);
+        return true; // B-frames are never references
+    } else if (frameType == algorithm::PREDICTED_FRAME && InterFrameCoder::refreshBand(record, band, bands)) {
+        output = m_interCoder->encodeRefresh(resampled, &m_outputFuture, quantStepOf(record), band, bands,
+                                             reconstruction);
+    } else if (frameType == algorithm::PREDICTED_FRAME) {
+        output = encodeLike(record, resampled, &m_outputFuture,
+                            m_outputBackground.empty() ? nullptr : &m_outputBackground, reconstruction);
+    } else {
+        output = resampled;
+        reconstruction = resampled;
+        m_inputBackground.clear();
+        m_outputBackground.clear();
+        m_inputReferences.clear();
+        m_outputReferences.clear();
+    }
+
+    m_inputReferences.push(payload);
+    m_outputReferences.push(reconstruction);
+    m_inputPast = std::move(m_inputFuture);
+    m_inputFuture = std::move(payload);
+    m_outputPast = std::move(m_outputFuture);
+    m_outputFuture = std::move(reconstruction);
+    return true;
+}
+
+/**
+ * @brief Rewrite a background record, predicted on either side as the decoder predicts it
+ *  A record that cannot be rewritten leaves the output's background as it was, since a decoder of the
+ *  output never sees it.
+ */
+bool TierTranscoder::recodeBackground(const std::vector<uint8_t> &record, std::vector<uint8_t> &output) {
+    std::vector<uint8_t> payload, resampled, reconstruction;
+    if (!m_interCoder->decode(record, m_inputBackground.empty() ? &m_inputFuture : &m_inputBackground,
+                              payload) ||
+        !m_algorithm->resamplePayload(payload, m_config.targetFactor, resampled)) {
+        m_inputBackground.clear();
+        return false;
+    }
+    m_inputBackground = std::move(payload);
+    output = encodeLike(record, resampled, m_outputBackground.empty() ? &m_outputFuture : &m_outputBackground,
+                        nullptr, reconstruction);
+    m_outputBackground = std::move(reconstruction);
+    return true;
+}
+
+/**
+ * @brief Code a resampled payload in the mode of the input record
+ *  Block records stay block records, mixed records choose their blocks again between the output's
+ *  prediction and background, and multi-reference records between the same number of the output's anchors
+ *  (and its background when the input record indexed one).
+ */
+std::vector<uint8_t> TierTranscoder::encodeLike(const std::vector<uint8_t> &record,
+                                                const std::vector<uint8_t> &payload,
+                                                const std::vector<uint8_t> *prediction,
+                                                const std::vector<uint8_t> *background,
+                                                std::vector<uint8_t> &reconstruction) const {
+    std::vector<uint8_t> inner = InterFrameCoder::mixedInnerRecord(record);
+    const std::vector<uint8_t> &coded = inner.empty() ? record : inner;
+    bool blocks = InterFrameCoder::isBlockRecord(coded);
+    int shortTerm, longTerm;
+    if (InterFrameCoder::multiReferenceCounts(record, shortTerm, longTerm)) {
+        return m_interCoder->encodeMulti(payload, m_outputReferences.window(shortTerm),
+                                         longTerm ? background : nullptr, quantStepOf(coded), blocks,
+                                         reconstruction);
+    }
+    if (!inner.empty() && background) {
+        return m_interCoder->encodeMixed(payload, prediction, background, quantStepOf(coded), blocks,
+                                         reconstruction);
+    }
+    return blocks ? m_interCoder->encodeBlocks(payload, prediction, quantStepOf(coded), reconstruction)
+                  : m_interCoder->encode(payload, prediction, quantStepOf(coded), reconstruction);
+}
+
+bool TierTranscoder::run() {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    utils::CompressedFormat input, output;
+    if (!input.openForReading(m_config.inputPath)) {
+        std::cerr << "Error: Could not open compressed file: " << m_config.inputPath << std::endl;
+        return false;
+    }
+    if (!output.openForWriting(m_config.outputPath, input.getOriginalWidth(), input.getOriginalHeight(),
+                               input.getOriginalFPS(), input.getAlgorithmId())) {
+        std::cerr << "Error: Could not create output file: " << m_config.outputPath << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> record, rewritten;
+    uint8_t frameType;
+    int32_t timestamp;
+    m_inputPast.clear();
+    m_inputFuture.clear();
+    m_outputPast.clear();
+    m_outputFuture.clear();
+    m_inputBackground.clear();
+    m_outputBackground.clear();
+    m_inputReferences.clear();
+    m_outputReferences.clear();
+
+    while (input.readFrame(record, frameType, timestamp)) {
+        m_stats.inputBytes += record.size();
+        if (frameType == algorithm::ENHANCEMENT_LAYER) {
+            m_stats.layersDropped++;
+            continue;
+        }
+        if (m_config.targetFactor == 0 || frameType == algorithm::INTERPOLATED_FRAME ||
+            frameType == algorithm::FILM_GRAIN) {
+            rewritten = record;
+            m_stats.recordsCopied++;
+        } else if (frameType == algorithm::BACKGROUND_FRAME ? recodeBackground(record, rewritten)
+                                                            : recode(frameType, record, rewritten)) {
+            m_stats.recordsResampled++;
+        } else {
+            // Like the decoder, drop corrupt records and inter records without a usable reference
+            std::cerr << "Warning: Invalid record at " << timestamp << ", skipped" << std::endl;
+            m_stats.recordsSkipped++;
+            continue;
+        }
+
+        if (!output.writeFrame(rewritten, frameType, timestamp)) {
+            std::cerr << "Error: Could not write " << m_config.outputPath << std::endl;
+            return false;
+        }
+        m_stats.outputBytes += rewritten.size();
+    }
+    input.close();
+    output.close();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    m_stats.totalProcessingTime = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << getStats() << std::endl;
+    return true;
+}
+
+std::string TierTranscoder::getStats() const {
+    std::stringstream ss;
+    ss << "Retier Statistics:" << std::endl
+       << "  Target factor: "
+       << (m_config.targetFactor > 0 ? std::to_string(m_config.targetFactor) : std::string("unchanged"))
+       << std::endl
+       << "  Records resampled: " << m_stats.recordsResampled << std::endl
+       << "  Records copied: " << m_stats.recordsCopied << std::endl
+       << "  Records skipped: " << m_stats.recordsSkipped << std::endl
+       << "  Enhancement layers dropped: " << m_stats.layersDropped << std::endl
+       << "  Input size: " << m_stats.inputBytes << " bytes" << std::endl
+       << "  Output size: " << m_stats.outputBytes << " bytes" << std::endl;
+    if (m_stats.outputBytes > 0) {
+        ss << "  Size ratio: " << static_cast<double>(m_stats.inputBytes) / m_stats.outputBytes << ":1"
+           << std::endl;
+    }
+    ss << "  Total processing time: " << m_stats.totalProcessingTime << " seconds" << std::endl;
+    return ss.str();
+}
+
+} // namespace core
+} // namespace vcompress
@@ -0,0 +1,185 @@
+#include "core/watch_folder.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vcompress {
+namespace core {
+
+// Files found at startup count as complete once unmodified for this long
+static const int SETTLE_SECONDS = 5;
+static const int POLL_INTERVAL_MS = 200;
+// How often files skipped as unsettled are looked at again
+static const int SETTLE_CHECK_SECONDS = 1;
+static const char *VIDEO_EXTENSIONS[] = {".mp4", ".mov", ".mkv", ".avi", ".m4v"};
+
+std::atomic<bool> WatchFolder::s_stopRequested(false);
+
+WatchFolder::WatchFolder() = default;
+
+WatchFolder::~WatchFolder() = default;
+
+void WatchFolder::requestStop() { s_stopRequested = true; }
+
+static bool isDirectory(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+/// @brief Visible files with a known video extension (capture tools write dot-files while recording)
+static bool isVideoFile(const std::string &name) {
+    if (name.empty() || name[0] == '.') return false;
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    std::string extension = name.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return std::find(std::begin(VIDEO_EXTENSIONS), std::end(VIDEO_EXTENSIONS), extension) !=
+           std::end(VIDEO_EXTENSIONS);
+}
+
+bool WatchFolder::configure(const WatchConfig &config) {
+    m_config = config;
+    if (m_config.outputDir.empty()) m_config.outputDir = m_config.directory;
+    if (m_config.statePath.empty()) m_config.statePath = m_config.outputDir + "/.vcompress_watch_state";
+    if (!isDirectory(m_config.directory) || !isDirectory(m_config.outputDir)) {
+        std::cerr << "Error: Watch and output directories must exist" << std::endl;
+        return false;
+    }
+
+    m_runner.config() = m_config.batch;
+    m_runner.config().resultsDir = m_config.outputDir;
+    return loadState();
+}
+
+/// @brief State file: one "<size> <mtime> <name>" line per finished file; later lines win
+bool WatchFolder::loadState() {
+    std::ifstream state(m_config.statePath);
+    if (!state.is_open()) return true; // First run
+
+    std::string line;
+    while (std::getline(state, line)) {
+        size_t first = line.find(' ');
+        size_t second = first == std::string::npos ? first : line.find(' ', first + 1);
+        if (second == std::string::npos) continue;
+        m_finished[line.substr(second + 1)] = line.substr(0, second);
+    }
+    std::cout << "Loaded " << m_finished.size() << " finished files from " << m_config.statePath << std::endl;
+    return true;
+}
+
+void WatchFolder::recordFinished(const std::string &name, const std::string &signature) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished[name] = signature;
+    std::ofstream state(m_config.statePath, std::ios::app);
+    state << signature << " " << name << std::endl;
+    if (!state) std::cerr << "Error: Could not update watch state: " << m_config.statePath << std::endl;
+}
+
+void WatchFolder::scanDirectory() {
+    DIR *directory = opendir(m_config.directory.c_str());
+    if (!directory) return;
+    while (dirent *entry = readdir(directory)) considerFile(entry->d_name, true);
+    closedir(directory);
+}
+
+/// @brief Look at the files skipped as unsettled again; the ones still too recent stay in the set
+void WatchFolder::checkUnsettled() {
+    std::set<std::string> unsettled;
+    unsettled.swap(m_unsettled);
+    for (const auto &name : unsettled) considerFile(name, true);
+}
+
+/**
+ * @brief Submit a file unless this version of it is finished or being encoded
+ *  Submission blocks while the runner is at its limits; inotify keeps queueing events meanwhile. A file
+ *  that must be settled but was modified too recently is remembered for checkUnsettled.
+ */
+void WatchFolder::considerFile(const std::string &name, bool requireSettled) {
+    if (!isVideoFile(name)) return;
+    m_unsettled.erase(name);
+    std::string path = m_config.directory + "/" + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return;
+    if (requireSettled && std::time(nullptr) - info.st_mtime < SETTLE_SECONDS) {
+        m_unsettled.insert(name);
+        return;
+    }
+    std::string signature = std::to_string(info.st_size) + " " + std::to_string(info.st_mtime);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto finished = m_finished.find(name);
+        if (finished != m_finished.end() && finished->second == signature) return;
+        if (!m_inFlight.insert(name).second) return;
+    }
+
+    // The id keeps the extension: a.mp4 and a.mov are different inputs and must not share outputs
+    BatchJob job = m_config.jobTemplate;
+    job.id = name;
+    job.mode = "encode";
+    job.input = path;
+    job.output = m_config.outputDir + "/" + job.id + ".vcomp";
+    job.audioPath = m_config.keepAudio ? m_config.outputDir + "/" + job.id + ".aac" : "";
+
+    m_runner.submit(job, nullptr, [this, name, signature](const BatchResult &result) {
+        if (result.success) recordFinished(name, signature);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight.erase(name);
+    });
+}
+
+bool WatchFolder::run() {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, m_config.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Error: Could not watch " << m_config.directory << ": " << std::strerror(errno)
+                  << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    // The watch is in place before the scan, so no file completed in between is missed
+    std::cout << "Watching " << m_config.directory << " for new videos..." << std::endl;
+    scanDirectory();
+
+    bool healthy = true;
+    alignas(inotify_event) char buffer[64 * 1024];
+    pollfd entry = {fd, POLLIN, 0};
+    std::time_t lastSettleCheck = std::time(nullptr);
+    while (!s_stopRequested) {
+        if (!m_unsettled.empty() && std::time(nullptr) - lastSettleCheck >= SETTLE_CHECK_SECONDS) {
+            lastSettleCheck = std::time(nullptr);
+            checkUnsettled();
+        }
+        int ready = poll(&entry, 1, POLL_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            healthy = false;
+            break;
+        }
+        if (ready <= 0) continue;
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            if (event->mask & IN_Q_OVERFLOW) scanDirectory();
+            else if (event->len > 0 && !(event->mask & IN_ISDIR)) considerFile(event->name, false);
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    close(fd);
+
+    std::cout << "Stopping the watch, waiting for running encodes..." << std::endl;
+    m_runner.wait();
+    std::cout << m_runner.getStats() << std::endl;
+    return healthy;
+}
+
+} // namespace core
+} // namespace vcompress
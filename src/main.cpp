@@ -1,12 +1,23 @@
 #include "algorithms/base_algorithm.hpp"
 #include "algorithms/bilinear_downsample_algorithm.hpp"
 #include "algorithms/cv_downsample_algorithm.hpp"
+#include "algorithms/roi_downsample_algorithm.hpp"
+#include "algorithms/screen_content_algorithm.hpp"
+#include "algorithms/vq_algorithm.hpp"
+#include "core/batch_runner.hpp"
 #include "core/decoder.hpp"
 #include "core/encoder.hpp"
+#include "core/job_daemon.hpp"
+#include "core/ladder_encoder.hpp"
+#include "core/segment_encoder.hpp"
+#include "core/tier_transcoder.hpp"
+#include "core/watch_folder.hpp"
 #include "utils/audio.hpp"
 #include "utils/compressed_format.hpp"
 #include "utils/file_reader.hpp"
 #include "utils/file_writer.hpp"
+#include "utils/thread_pool.hpp"
+#include <csignal>
 
 // Configuration for the main program
 struct MainConfig {
@@ -21,16 +32,92 @@ struct MainConfig {
     int keyFrameInterval = 30;
     bool keepAudio = true;
     bool keepTempFiles = false;
+    bool adaptiveFactor = false;
+    int temporalFactor = 1;
+    int bFrames = 0;
+    int intraRefreshPeriod = 0;
+    int seekFrame = 0;
+    bool liveMode = false;
+    bool resume = false;
+    std::string gopCacheDir;
+    std::string frameCacheDir;
+    double latencyBudgetMs = 0.0;
+    std::vector<vcompress::core::LadderRung> ladderRungs;
+    int maxConcurrentJobs = 0;
+    int segmentGops = 10;
+    int localWorkers = 0;
+    int retierFactor = 4;
+    int enhancementQuantStep = 0;
+    int denoiseStrength = 0;
+    int bitDepth = 8;
+    bool filmGrain = false;
+    bool synthesizeGrain = true;
+    bool baseLayerOnly = false;
+    int sharpenStrength = 0;
+    bool deband = false;
+    bool dither = false;
+    bool interPrediction = false;
+    bool blockCoding = false;
+    bool backgroundReference = false;
+    int referenceFrames = 1;
+    std::vector<vcompress::algorithm::RegionOfInterest> roiRegions;
+    std::string roiSidecarPath;
 };
 
 void printUsage(const char *programName) {
     std::cout << "Usage: " << programName << " <input_video> <output_video> [options]" << std::endl;
+    std::cout << "       " << programName << " batch <manifest.json>" << std::endl;
+    std::cout << "       " << programName << " daemon <socket_path> [manifest.json]" << std::endl;
+    std::cout << "       " << programName << " watch <input_dir> <output_dir> [options]" << std::endl;
+    std::cout << "       " << programName << " distribute <shared_dir> <input_video> <output.vcomp> [options]"
+              << std::endl;
+    std::cout << "       " << programName << " worker <shared_dir>" << std::endl;
+    std::cout << "       " << programName << " retier <input.vcomp> <output.vcomp> [-a ALGO] [--factor N]"
+              << std::endl;
+    std::cout << "       " << programName << " strip <input.vcomp> <output.vcomp>" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  -a, --algo      Compression algorithm (default: CVDownsample)" << std::endl;
     std::cout << "  -q, --quality   Quality level (1-100, default: 75)" << std::endl;
     std::cout << "  -l, --list      List available algorithms" << std::endl;
     std::cout << "  -h, --help      Show this help message" << std::endl;
     std::cout << "  --keep-temp     Keep temporary files after processing" << std::endl;
+    std::cout << "  --adaptive-factor  Choose the factor per GOP from content complexity" << std::endl;
+    std::cout << "  --temporal N    Store every Nth frame, interpolate the rest on decode" << std::endl;
+    std::cout << "  --inter         Code delta frames as residuals against the previous anchor" << std::endl;
+    std::cout << "  --block-coding  Per-block residual quantizers with in-loop deblocking (implies --inter)"
+              << std::endl;
+    std::cout << "  --background    Long-term background reference for static cameras (implies --inter)"
+              << std::endl;
+    std::cout << "  --references N  Predict blocks from the best of the last N anchors (1-4)" << std::endl;
+    std::cout << "  --bframes N     B-frames between anchors (0-7, implies --inter)" << std::endl;
+    std::cout << "  --intra-refresh N  Refresh one band per frame over N frames instead of key frames"
+              << std::endl;
+    std::cout << "  --seek N        Start the output at the first recovery point from frame N" << std::endl;
+    std::cout << "  --resume        Continue an interrupted encode from its checkpoint" << std::endl;
+    std::cout << "  --gop-cache DIR  Reuse GOPs encoded from identical frames and settings" << std::endl;
+    std::cout << "  --frame-cache DIR  Keep decoded frames so later encodes skip decoding" << std::endl;
+    std::cout << "  --live          Live profile: no lookahead, per-frame flush (files are read at their fps)"
+              << std::endl;
+    std::cout << "  --latency-budget MS  Live capture-to-packet budget (default: one frame)" << std::endl;
+    std::cout << "  --ladder A:Q,...  One .vcomp per algorithm:quality from a single decode" << std::endl;
+    std::cout << "  --jobs N        Files encoded at once in watch mode (default: one per core)" << std::endl;
+    std::cout << "  --segment-gops N  GOPs per segment in distribute mode (default: 10)" << std::endl;
+    std::cout << "  --local-workers N  Worker processes distribute mode starts on this node" << std::endl;
+    std::cout << "  --factor N      Downsample factor of retier outputs (default: 4)" << std::endl;
+    std::cout << "  --enhance N     Enhancement layer with quantizer step N (1 = lossless)" << std::endl;
+    std::cout << "  --denoise N     Temporal denoise prefilter with strength N (1-10)" << std::endl;
+    std::cout << "  --bit-depth N   Store downsampled samples with N bits (5-8), dithered and bit-packed"
+              << std::endl;
+    std::cout << "  --film-grain    Send grain parameters and denoise; the decoder adds the grain back"
+              << std::endl;
+    std::cout << "  --no-grain      Decode without synthesizing film grain" << std::endl;
+    std::cout << "  --base-only     Decode the base layer only, skipping enhancement layers" << std::endl;
+    std::cout << "  --sharpen N     Decode with an unsharp mask of strength N (1-10) in the upsampler"
+              << std::endl;
+    std::cout << "  --deband        Decode with debanding of flat gradients in the upsampler" << std::endl;
+    std::cout << "  --dither        Decode with ordered dithering of the upsampled output" << std::endl;
+    std::cout << "  --roi x,y,w,h   Region of interest for ROIDownsample (repeatable)" << std::endl;
+    std::cout << "  --roi-sidecar   File with per-frame ROIs, one 'frame x y w h' per line" << std::endl;
 }
 
 // Register the downsample algorithm
@@ -43,6 +130,15 @@ void registerAlgorithms() {
                                         []() -> std::unique_ptr<BaseCompressionAlgorithm> {
                                             return std::make_unique<BilinearDownsampleAlgorithm>();
                                         });
+    AlgorithmFactory::registerAlgorithm("ROIDownsample", []() -> std::unique_ptr<BaseCompressionAlgorithm> {
+        return std::make_unique<ROIDownsampleAlgorithm>();
+    });
+    AlgorithmFactory::registerAlgorithm("ScreenContent", []() -> std::unique_ptr<BaseCompressionAlgorithm> {
+        return std::make_unique<ScreenContentAlgorithm>();
+    });
+    AlgorithmFactory::registerAlgorithm("VQ", []() -> std::unique_ptr<BaseCompressionAlgorithm> {
+        return std::make_unique<VQAlgorithm>();
+    });
 #ifdef USE_CUDA
     AlgorithmFactory::registerAlgorithm("CudaBilinearDownsample",
                                         []() -> std::unique_ptr<BaseCompressionAlgorithm> {
@@ -90,6 +186,197 @@ auto qualityHandler = [](int &i, int argc, char **argv, MainConfig &config) {
     return true;
 };
 
+auto temporalHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.temporalFactor = std::clamp(std::atoi(argv[++i]), 1, 8);
+    } else {
+        std::cerr << "Error: Missing argument for --temporal" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto bFramesHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.bFrames = std::clamp(std::atoi(argv[++i]), 0, 7);
+    } else {
+        std::cerr << "Error: Missing argument for --bframes" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto intraRefreshHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.intraRefreshPeriod = std::clamp(std::atoi(argv[++i]), 0, 240);
+    } else {
+        std::cerr << "Error: Missing argument for --intra-refresh" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto seekHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.seekFrame = std::max(0, std::atoi(argv[++i]));
+    } else {
+        std::cerr << "Error: Missing argument for --seek" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto latencyBudgetHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.latencyBudgetMs = std::max(0.0, std::atof(argv[++i]));
+    } else {
+        std::cerr << "Error: Missing argument for --latency-budget" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto ladderHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 >= argc) {
+        std::cerr << "Error: Missing argument for --ladder" << std::endl;
+        return false;
+    }
+    return vcompress::core::LadderEncoder::parseRungs(argv[++i], config.quality, config.ladderRungs);
+};
+
+auto jobsHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.maxConcurrentJobs = std::max(0, std::atoi(argv[++i]));
+    } else {
+        std::cerr << "Error: Missing argument for --jobs" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto segmentGopsHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.segmentGops = std::max(1, std::atoi(argv[++i]));
+    } else {
+        std::cerr << "Error: Missing argument for --segment-gops" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto factorHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.retierFactor = std::atoi(argv[++i]);
+    } else {
+        std::cerr << "Error: Missing argument for --factor" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto enhanceHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.enhancementQuantStep = std::clamp(std::atoi(argv[++i]), 1, 255);
+    } else {
+        std::cerr << "Error: Missing argument for --enhance" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto denoiseHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.denoiseStrength = std::clamp(std::atoi(argv[++i]), 0, 10);
+    } else {
+        std::cerr << "Error: Missing argument for --denoise" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto referencesHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.referenceFrames = std::clamp(std::atoi(argv[++i]), 1, 4);
+    } else {
+        std::cerr << "Error: Missing argument for --references" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto bitDepthHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.bitDepth = std::clamp(std::atoi(argv[++i]), 5, 8);
+    } else {
+        std::cerr << "Error: Missing argument for --bit-depth" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto sharpenHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.sharpenStrength = std::clamp(std::atoi(argv[++i]), 0, 10);
+    } else {
+        std::cerr << "Error: Missing argument for --sharpen" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto localWorkersHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.localWorkers = std::max(0, std::atoi(argv[++i]));
+    } else {
+        std::cerr << "Error: Missing argument for --local-workers" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto gopCacheHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.gopCacheDir = argv[++i];
+    } else {
+        std::cerr << "Error: Missing argument for --gop-cache" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto frameCacheHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.frameCacheDir = argv[++i];
+    } else {
+        std::cerr << "Error: Missing argument for --frame-cache" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto roiHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    vcompress::algorithm::RegionOfInterest roi;
+    if (i + 1 < argc &&
+        std::sscanf(argv[i + 1], "%d,%d,%d,%d", &roi.x, &roi.y, &roi.width, &roi.height) == 4) {
+        config.roiRegions.push_back(roi);
+        i++;
+    } else {
+        std::cerr << "Error: Expected x,y,w,h for --roi" << std::endl;
+        return false;
+    }
+    return true;
+};
+
+auto roiSidecarHandler = [](int &i, int argc, char **argv, MainConfig &config) {
+    if (i + 1 < argc) {
+        config.roiSidecarPath = argv[++i];
+    } else {
+        std::cerr << "Error: Missing argument for --roi-sidecar" << std::endl;
+        return false;
+    }
+    return true;
+};
+
 // clang-format off
 std::unordered_map<std::string, std::function<bool(int &i, int argc, char **argv, MainConfig &config)>>
     argHandlers = {
@@ -97,8 +384,51 @@ std::unordered_map<std::string, std::function<bool(int &i, int argc, char **argv
         {"-l", listHandler}, {"--list", listHandler},
         {"-a", algorithmHandler}, {"--algorithm", algorithmHandler},
         {"-q", qualityHandler}, {"--quality", qualityHandler},
+        {"--temporal", temporalHandler},
+        {"--bframes", bFramesHandler}, {"--references", referencesHandler},
+        {"--intra-refresh", intraRefreshHandler}, {"--seek", seekHandler},
+        {"--latency-budget", latencyBudgetHandler}, {"--ladder", ladderHandler},
+        {"--jobs", jobsHandler}, {"--segment-gops", segmentGopsHandler},
+        {"--local-workers", localWorkersHandler}, {"--gop-cache", gopCacheHandler},
+        {"--frame-cache", frameCacheHandler}, {"--factor", factorHandler},
+        {"--enhance", enhanceHandler}, {"--denoise", denoiseHandler},
+        {"--bit-depth", bitDepthHandler}, {"--sharpen", sharpenHandler},
+        {"--roi", roiHandler}, {"--roi-sidecar", roiSidecarHandler},
         {"--keep-temp", [](int &, int, char **, MainConfig &config) {
             config.keepTempFiles = true;
+            return true; }},
+        {"--adaptive-factor", [](int &, int, char **, MainConfig &config) {
+            config.adaptiveFactor = true;
+            return true; }},
+        {"--inter", [](int &, int, char **, MainConfig &config) {
+            config.interPrediction = true;
+            return true; }},
+        {"--block-coding", [](int &, int, char **, MainConfig &config) {
+            config.blockCoding = true;
+            return true; }},
+        {"--background", [](int &, int, char **, MainConfig &config) {
+            config.backgroundReference = true;
+            return true; }},
+        {"--live", [](int &, int, char **, MainConfig &config) {
+            config.liveMode = true;
+            return true; }},
+        {"--resume", [](int &, int, char **, MainConfig &config) {
+            config.resume = true;
+            return true; }},
+        {"--base-only", [](int &, int, char **, MainConfig &config) {
+            config.baseLayerOnly = true;
+            return true; }},
+        {"--film-grain", [](int &, int, char **, MainConfig &config) {
+            config.filmGrain = true;
+            return true; }},
+        {"--no-grain", [](int &, int, char **, MainConfig &config) {
+            config.synthesizeGrain = false;
+            return true; }},
+        {"--deband", [](int &, int, char **, MainConfig &config) {
+            config.deband = true;
+            return true; }},
+        {"--dither", [](int &, int, char **, MainConfig &config) {
+            config.dither = true;
             return true; }}
     };
 // clang-format on
@@ -145,6 +475,134 @@ int main(int argc, char **argv) {
 
     registerAlgorithms();
 
+    // Batch mode runs the encode/decode jobs of a manifest on shared pools
+    if (std::string(argv[1]) == "batch") {
+        vcompress::core::BatchRunner runner;
+        if (!runner.loadManifest(argv[2])) return -1;
+        return runner.run() ? 0 : -1;
+    }
+
+    // Daemon mode takes jobs over a Unix socket; a manifest sets the limits and the first jobs
+    if (std::string(argv[1]) == "daemon") {
+        vcompress::core::BatchRunner manifest;
+        manifest.config().resultsDir.clear();
+        if (argc > 3 && !manifest.loadManifest(argv[3])) return -1;
+
+        vcompress::core::JobDaemon daemon;
+        if (!daemon.open(argv[2], manifest.config())) return -1;
+        for (auto job : manifest.jobs()) daemon.enqueue(job);
+        return daemon.serve() ? 0 : -1;
+    }
+
+    // Watch mode encodes every video completed in <input_dir> with the regular options
+    if (std::string(argv[1]) == "watch") {
+        MainConfig config;
+        if (!parseCommandLineOptions(argc - 1, argv + 1, config)) return -1;
+
+        vcompress::core::WatchConfig watchConfig;
+        watchConfig.directory = config.inputPath;
+        watchConfig.outputDir = config.outputPath;
+        watchConfig.keepAudio = config.keepAudio;
+        watchConfig.batch.maxConcurrentJobs = config.maxConcurrentJobs;
+        vcompress::core::BatchJob &job = watchConfig.jobTemplate;
+        job.algorithmName = config.algorithmName;
+        job.quality = config.quality;
+        job.keyFrameInterval = config.keyFrameInterval;
+        job.temporalFactor = config.temporalFactor;
+        job.bFrames = config.bFrames;
+        job.intraRefreshPeriod = config.intraRefreshPeriod;
+        job.interPrediction = config.interPrediction;
+        job.blockCoding = config.blockCoding;
+        job.backgroundReference = config.backgroundReference;
+        job.referenceFrames = config.referenceFrames;
+        job.adaptiveFactor = config.adaptiveFactor;
+        job.gopCacheDir = config.gopCacheDir;
+        job.frameCacheDir = config.frameCacheDir;
+        job.enhancementQuantStep = config.enhancementQuantStep;
+        job.denoiseStrength = config.denoiseStrength;
+        job.bitDepth = config.bitDepth;
+        job.filmGrain = config.filmGrain;
+
+        vcompress::core::WatchFolder watcher;
+        if (!watcher.configure(watchConfig)) return -1;
+        std::signal(SIGINT, [](int) { vcompress::core::WatchFolder::requestStop(); });
+        std::signal(SIGTERM, [](int) { vcompress::core::WatchFolder::requestStop(); });
+        return watcher.run() ? 0 : -1;
+    }
+
+    // Retier mode moves a compressed file to a coarser downsample factor without decoding it
+    if (std::string(argv[1]) == "retier") {
+        MainConfig config;
+        if (!parseCommandLineOptions(argc - 1, argv + 1, config)) return -1;
+
+        vcompress::core::RetierConfig retierConfig;
+        retierConfig.inputPath = config.inputPath;
+        retierConfig.outputPath = config.outputPath;
+        retierConfig.algorithmName = config.algorithmName;
+        retierConfig.targetFactor = config.retierFactor;
+        vcompress::core::TierTranscoder transcoder;
+        if (!transcoder.configure(retierConfig)) return -1;
+        return transcoder.run() ? 0 : -1;
+    }
+
+    // Strip mode keeps the base layer of a compressed file and drops its enhancement layers
+    if (std::string(argv[1]) == "strip") {
+        if (argc < 4) {
+            printUsage(argv[0]);
+            return -1;
+        }
+        vcompress::core::RetierConfig retierConfig;
+        retierConfig.inputPath = argv[2];
+        retierConfig.outputPath = argv[3];
+        retierConfig.targetFactor = 0;
+        vcompress::core::TierTranscoder transcoder;
+        if (!transcoder.configure(retierConfig)) return -1;
+        return transcoder.run() ? 0 : -1;
+    }
+
+    // Distributed encoding: the coordinator splits the input into segments that workers claim
+    if (std::string(argv[1]) == "worker") {
+        vcompress::core::SegmentWorker worker;
+        return worker.run(argv[2]) ? 0 : -1;
+    }
+    if (std::string(argv[1]) == "distribute") {
+        MainConfig config;
+        if (argc < 5 || !parseCommandLineOptions(argc - 2, argv + 2, config)) return -1;
+
+        vcompress::core::SegmentConfig segmentConfig;
+        segmentConfig.sharedDir = argv[2];
+        segmentConfig.segmentGops = config.segmentGops;
+        segmentConfig.localWorkers = config.localWorkers;
+        vcompress::core::EncoderConfig &encoderConfig = segmentConfig.encoder;
+        encoderConfig.inputPath = config.inputPath;
+        encoderConfig.algorithmName = config.algorithmName;
+        encoderConfig.quality = config.quality;
+        encoderConfig.bitrate = config.bitrate;
+        encoderConfig.keyFrameInterval = config.keyFrameInterval;
+        encoderConfig.keepAudio = config.keepAudio;
+        encoderConfig.compressedDataPath = config.outputPath;
+        encoderConfig.tempAudioPath = config.outputPath + ".aac";
+        encoderConfig.temporalFactor = config.temporalFactor;
+        encoderConfig.bFrames = config.bFrames;
+        encoderConfig.interPrediction = config.interPrediction;
+        encoderConfig.blockCoding = config.blockCoding;
+        encoderConfig.backgroundReference = config.backgroundReference;
+        encoderConfig.referenceFrames = config.referenceFrames;
+        encoderConfig.adaptiveFactor = config.adaptiveFactor;
+        encoderConfig.intraRefreshPeriod = config.intraRefreshPeriod;
+        encoderConfig.liveMode = config.liveMode;
+        encoderConfig.enhancementQuantStep = config.enhancementQuantStep;
+        encoderConfig.denoiseStrength = config.denoiseStrength;
+        encoderConfig.bitDepth = config.bitDepth;
+        encoderConfig.filmGrain = config.filmGrain;
+        encoderConfig.roiRegions = config.roiRegions;
+        encoderConfig.roiSidecarPath = config.roiSidecarPath;
+        encoderConfig.gopCacheDir = config.gopCacheDir;
+        encoderConfig.frameCacheDir = config.frameCacheDir;
+        vcompress::core::SegmentCoordinator coordinator;
+        return coordinator.run(segmentConfig) ? 0 : -1;
+    }
+
     MainConfig config;
     if (!parseCommandLineOptions(argc, argv, config)) {
         return -1;
@@ -155,7 +613,42 @@ int main(int argc, char **argv) {
         vcompress::core::EncoderConfig encoderConfig(
             config.inputPath, config.outputPath, config.algorithmName, config.quality, config.bitrate,
             config.keyFrameInterval, false, config.keepAudio, config.keepTempFiles);
+        encoderConfig.roiRegions = config.roiRegions;
+        encoderConfig.roiSidecarPath = config.roiSidecarPath;
+        encoderConfig.adaptiveFactor = config.adaptiveFactor;
+        encoderConfig.temporalFactor = config.temporalFactor;
+        encoderConfig.bFrames = config.bFrames;
+        encoderConfig.interPrediction = config.interPrediction;
+        encoderConfig.blockCoding = config.blockCoding;
+        encoderConfig.backgroundReference = config.backgroundReference;
+        encoderConfig.referenceFrames = config.referenceFrames;
+        encoderConfig.intraRefreshPeriod = config.intraRefreshPeriod;
+        encoderConfig.liveMode = config.liveMode;
+        encoderConfig.latencyBudgetMs = config.latencyBudgetMs;
+        encoderConfig.resume = config.resume;
+        encoderConfig.gopCacheDir = config.gopCacheDir;
+        encoderConfig.frameCacheDir = config.frameCacheDir;
+        encoderConfig.enhancementQuantStep = config.enhancementQuantStep;
+        encoderConfig.denoiseStrength = config.denoiseStrength;
+        encoderConfig.bitDepth = config.bitDepth;
+        encoderConfig.filmGrain = config.filmGrain;
+
+        // Ladder mode only produces the compressed outputs
+        if (!config.ladderRungs.empty()) {
+            vcompress::core::LadderConfig ladderConfig;
+            ladderConfig.base = encoderConfig;
+            ladderConfig.rungs = config.ladderRungs;
+            vcompress::core::LadderEncoder ladder;
+            if (!ladder.configure(ladderConfig) || !ladder.encode()) {
+                std::cerr << "Failed to encode the ladder" << std::endl;
+                return -1;
+            }
+            return 0;
+        }
+
+        vcompress::utils::ThreadPool pool;
         vcompress::core::VideoEncoder encoder;
+        encoder.setThreadPool(&pool);
         if (!encoder.configure(encoderConfig)) {
             std::cerr << "Failed to configure encoder" << std::endl;
             return -1;
@@ -170,7 +663,15 @@ int main(int argc, char **argv) {
         vcompress::core::DecoderConfig decoderConfig(config.inputPath, config.outputPath,
                                                      config.algorithmName, config.quality, config.keepAudio,
                                                      config.keepTempFiles);
+        decoderConfig.seekFrame = config.seekFrame;
+        decoderConfig.baseLayerOnly = config.baseLayerOnly;
+        decoderConfig.synthesizeGrain = config.synthesizeGrain;
+        decoderConfig.sharpenStrength = config.sharpenStrength;
+        decoderConfig.deband = config.deband;
+        decoderConfig.dither = config.dither;
+        vcompress::utils::ThreadPool pool;
         vcompress::core::VideoDecoder decoder;
+        decoder.setThreadPool(&pool);
         if (!decoder.configure(decoderConfig)) {
             std::cerr << "Failed to configure decoder" << std::endl;
             return -1;
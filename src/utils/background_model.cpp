@@ -0,0 +1,83 @@
+#include "utils/background_model.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace vcompress {
+namespace utils {
+
+/// @brief Count a still update of one sample, and move its background once it has settled
+static inline void updateSample(uint8_t input, uint8_t &last, uint8_t &still, uint16_t &background,
+                                int fraction_bits, int still_levels, int settle_updates) {
+    int is_still = std::abs(input - last) <= still_levels;
+    int run = std::min((still + 1) * is_still, settle_updates);
+    int settled = run >= settle_updates;
+    // The shift of a signed step rounds towards minus infinity; the bias makes it round to nearest
+    int delta = (input << fraction_bits) - background;
+    background = static_cast<uint16_t>(background + settled * ((delta + 2) >> 2));
+    still = static_cast<uint8_t>(run);
+    last = input;
+}
+
+void BackgroundModel::update(const uint8_t *samples, size_t count) {
+    if (m_background.size() != count) {
+        m_background.resize(count);
+        m_last.assign(samples, samples + count);
+        m_still.assign(count, 0);
+        for (size_t i = 0; i < count; i++) {
+            m_background[i] = static_cast<uint16_t>(samples[i] << FRACTION_BITS);
+        }
+        return;
+    }
+
+    uint16_t *background = m_background.data();
+    uint8_t *last = m_last.data();
+    uint8_t *still = m_still.data();
+    size_t i = 0;
+    for (; i + LANE_SAMPLES <= count; i += LANE_SAMPLES) {
+        uint8_t input[LANE_SAMPLES], lane_last[LANE_SAMPLES], lane_still[LANE_SAMPLES];
+        uint16_t lane_background[LANE_SAMPLES];
+        std::memcpy(input, samples + i, sizeof(input));
+        std::memcpy(lane_last, last + i, sizeof(lane_last));
+        std::memcpy(lane_still, still + i, sizeof(lane_still));
+        std::memcpy(lane_background, background + i, sizeof(lane_background));
+        for (int k = 0; k < LANE_SAMPLES; k++) {
+            updateSample(input[k], lane_last[k], lane_still[k], lane_background[k], FRACTION_BITS,
+                         STILL_LEVELS, SETTLE_UPDATES);
+        }
+        std::memcpy(last + i, lane_last, sizeof(lane_last));
+        std::memcpy(still + i, lane_still, sizeof(lane_still));
+        std::memcpy(background + i, lane_background, sizeof(lane_background));
+    }
+    for (; i < count; i++) {
+        updateSample(samples[i], last[i], still[i], background[i], FRACTION_BITS, STILL_LEVELS,
+                     SETTLE_UPDATES);
+    }
+}
+
+void BackgroundModel::read(uint8_t *samples) const {
+    const int half = 1 << (FRACTION_BITS - 1);
+    for (size_t i = 0; i < m_background.size(); i++) {
+        samples[i] = static_cast<uint8_t>((m_background[i] + half) >> FRACTION_BITS);
+    }
+}
+
+double BackgroundModel::distance(const uint8_t *samples) const {
+    if (m_background.empty()) return 0.0;
+    const int half = 1 << (FRACTION_BITS - 1);
+    int64_t total = 0;
+    for (size_t i = 0; i < m_background.size(); i++) {
+        total += std::abs(((m_background[i] + half) >> FRACTION_BITS) - samples[i]);
+    }
+    return static_cast<double>(total) / m_background.size();
+}
+
+void BackgroundModel::reset() {
+    m_background.clear();
+    m_last.clear();
+    m_still.clear();
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,100 @@
+#include "utils/bit_depth.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+static constexpr int GROUP_SAMPLES = 8;
+
+size_t packedSize(size_t count, int bits) {
+    return (count + GROUP_SAMPLES - 1) / GROUP_SAMPLES * bits;
+}
+
+/// @brief Level of a sample: (value * scale + bias) >> 16, with scale = (levels - 1) / 255 in 16.16
+static inline uint8_t quantizeSample(uint8_t value, uint32_t scale, uint32_t bias) {
+    return static_cast<uint8_t>((value * scale + bias) >> 16);
+}
+
+void packBitDepth(const uint8_t *plane, int width, int height, int channels, int bits, uint8_t *packed) {
+    static const int BAYER[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    uint32_t scale = (((1u << bits) - 1) << 16) / 255;
+    size_t row_samples = static_cast<size_t>(width) * channels;
+    size_t count = row_samples * height;
+
+    // Dither offsets (2b + 1) / 32 of a level in 16.16, one row per phase of the pattern
+    std::vector<uint32_t> biases(row_samples * 4);
+    for (int phase = 0; phase < 4; phase++) {
+        for (size_t i = 0; i < row_samples; i++) {
+            int x = static_cast<int>(i / channels);
+            biases[phase * row_samples + i] = static_cast<uint32_t>(2 * BAYER[phase][x & 3] + 1) << 11;
+        }
+    }
+
+    std::vector<uint8_t> levels(packedSize(count, GROUP_SAMPLES), 0);
+    for (int y = 0; y < height; y++) {
+        const uint8_t *in = plane + y * row_samples;
+        const uint32_t *bias = biases.data() + (y & 3) * row_samples;
+        uint8_t *out = levels.data() + y * row_samples;
+        size_t i = 0;
+        for (; i + LANE_SAMPLES <= row_samples; i += LANE_SAMPLES) {
+            uint8_t values[LANE_SAMPLES], lane_levels[LANE_SAMPLES];
+            uint32_t lane_bias[LANE_SAMPLES];
+            std::memcpy(values, in + i, sizeof(values));
+            std::memcpy(lane_bias, bias + i, sizeof(lane_bias));
+            for (int k = 0; k < LANE_SAMPLES; k++) {
+                lane_levels[k] = quantizeSample(values[k], scale, lane_bias[k]);
+            }
+            std::memcpy(out + i, lane_levels, sizeof(lane_levels));
+        }
+        for (; i < row_samples; i++) out[i] = quantizeSample(in[i], scale, bias[i]);
+    }
+
+    // Whole groups of eight levels become `bits` bytes, so no bit-level loop is needed
+    for (size_t group = 0; group * GROUP_SAMPLES < count; group++) {
+        const uint8_t *level = levels.data() + group * GROUP_SAMPLES;
+        uint64_t word = 0;
+        for (int k = 0; k < GROUP_SAMPLES; k++) word |= static_cast<uint64_t>(level[k]) << (bits * k);
+        for (int b = 0; b < bits; b++) packed[group * bits + b] = static_cast<uint8_t>(word >> (8 * b));
+    }
+}
+
+void unpackBitDepth(const uint8_t *packed, size_t count, int bits, uint8_t *plane) {
+    uint8_t expand[256];
+    int top = (1 << bits) - 1;
+    for (int level = 0; level <= top; level++) {
+        expand[level] = static_cast<uint8_t>((level * 255 + top / 2) / top);
+    }
+
+    uint64_t mask = (1u << bits) - 1;
+    size_t group = 0;
+    for (; (group + 1) * GROUP_SAMPLES <= count; group++) {
+        uint64_t word = 0;
+        for (int b = 0; b < bits; b++) word |= static_cast<uint64_t>(packed[group * bits + b]) << (8 * b);
+        uint8_t *out = plane + group * GROUP_SAMPLES;
+        for (int k = 0; k < GROUP_SAMPLES; k++) out[k] = expand[(word >> (bits * k)) & mask];
+    }
+    if (group * GROUP_SAMPLES < count) {
+        uint64_t word = 0;
+        for (int b = 0; b < bits; b++) word |= static_cast<uint64_t>(packed[group * bits + b]) << (8 * b);
+        for (size_t k = 0; group * GROUP_SAMPLES + k < count; k++) {
+            plane[group * GROUP_SAMPLES + k] = expand[(word >> (bits * k)) & mask];
+        }
+    }
+}
+
+void packPayloadPlane(std::vector<uint8_t> &payload, size_t header_bytes, int width, int height, int channels,
+                      int bits) {
+    size_t count = static_cast<size_t>(width) * height * channels;
+    std::vector<uint8_t> packed(header_bytes + 1 + packedSize(count, bits));
+    std::copy(payload.begin(), payload.begin() + header_bytes, packed.begin());
+    packed[header_bytes] = static_cast<uint8_t>(bits);
+    packBitDepth(payload.data() + header_bytes, width, height, channels, bits,
+                 packed.data() + header_bytes + 1);
+    payload = std::move(packed);
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,44 @@
+#include "utils/buffer_pool.hpp"
+
+namespace vcompress {
+namespace utils {
+
+BufferPool::BufferPool(size_t maxCachedBytes) : m_cachedBytes(0), m_maxCachedBytes(maxCachedBytes) {}
+
+/// @brief Best fit among the cached buffers, so small requests do not pin the largest buffers
+std::vector<uint8_t> BufferPool::acquire(size_t size) {
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t best = m_free.size();
+        for (size_t i = 0; i < m_free.size(); i++) {
+            if (m_free[i].capacity() >= size &&
+                (best == m_free.size() || m_free[i].capacity() < m_free[best].capacity())) {
+                best = i;
+            }
+        }
+        if (best != m_free.size()) {
+            buffer = std::move(m_free[best]);
+            m_free[best] = std::move(m_free.back());
+            m_free.pop_back();
+            m_cachedBytes -= buffer.capacity();
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void BufferPool::release(std::vector<uint8_t> &&buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (buffer.capacity() == 0 || m_cachedBytes + buffer.capacity() > m_maxCachedBytes) return;
+    m_cachedBytes += buffer.capacity();
+    m_free.push_back(std::move(buffer));
+}
+
+size_t BufferPool::cachedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cachedBytes;
+}
+
+} // namespace utils
+} // namespace vcompress
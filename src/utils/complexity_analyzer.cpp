@@ -0,0 +1,56 @@
+#include "utils/complexity_analyzer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+// Gradient energy thresholds (per decimated sample) separating flat, regular and detailed content
+static const double FLAT_ENERGY_THRESHOLD = 6.0;
+static const double DETAILED_ENERGY_THRESHOLD = 18.0;
+
+/// @brief Point-sampled luma plane (BT.601 integer weights on BGR input)
+std::vector<uint8_t> decimatedLuma(const uint8_t *bgr, int width, int height, int step, int &luma_width,
+                                   int &luma_height) {
+    step = std::max(1, step);
+    luma_width = width / step;
+    luma_height = height / step;
+
+    std::vector<uint8_t> luma(luma_width * luma_height);
+    for (int y = 0; y < luma_height; y++) {
+        const uint8_t *row = bgr + static_cast<size_t>(y * step) * width * 3;
+        for (int x = 0; x < luma_width; x++) {
+            const uint8_t *p = row + x * step * 3;
+            luma[y * luma_width + x] = static_cast<uint8_t>((29 * p[0] + 150 * p[1] + 77 * p[2]) >> 8);
+        }
+    }
+    return luma;
+}
+
+/// @brief Mean |dx| + |dy| of the decimated luma plane
+double gradientEnergy(const uint8_t *bgr, int width, int height, int step) {
+    int luma_width, luma_height;
+    std::vector<uint8_t> luma = decimatedLuma(bgr, width, height, step, luma_width, luma_height);
+    if (luma_width < 2 || luma_height < 2) return 0.0;
+
+    int64_t energy = 0;
+    for (int y = 0; y < luma_height - 1; y++) {
+        const uint8_t *row = luma.data() + y * luma_width;
+        for (int x = 0; x < luma_width - 1; x++) {
+            energy += std::abs(row[x + 1] - row[x]) + std::abs(row[x + luma_width] - row[x]);
+        }
+    }
+    return static_cast<double>(energy) / ((luma_width - 1) * (luma_height - 1));
+}
+
+/// @brief Detailed content keeps more samples, flat content tolerates a higher factor
+int selectDownsampleFactor(double energy, int base_factor, int min_factor, int max_factor) {
+    int factor = base_factor;
+    if (energy > DETAILED_ENERGY_THRESHOLD) factor--;
+    else if (energy < FLAT_ENERGY_THRESHOLD) factor++;
+    return std::max(min_factor, std::min(max_factor, factor));
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,160 @@
+#include "utils/deblocking_filter.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace vcompress {
+namespace utils {
+
+// Rows per stripe below which a stripe costs more to schedule than it saves
+static const int MIN_STRIPE_ROWS = 32;
+
+/// @brief Filter thresholds for the larger quantizer step of the two blocks of an edge (alpha 0 = off)
+static void edgeThresholds(int step, uint8_t &alpha, uint8_t &beta, uint8_t &tc) {
+    if (step <= 1) {
+        alpha = beta = tc = 0;
+        return;
+    }
+    alpha = static_cast<uint8_t>(std::min(255, 2 * step));
+    beta = static_cast<uint8_t>(std::min(255, step / 2 + 2));
+    tc = static_cast<uint8_t>(std::max(1, step / 2));
+}
+
+/// @brief Normal filter of one edge sample; branch free, so the lane loop vectorizes
+static inline void filterSample(int p1, uint8_t &p0, uint8_t &q0, int q1, int alpha, int beta, int tc) {
+    int p = p0, q = q0;
+    int delta = ((q - p) * 4 + (p1 - q1) + 4) >> 3;
+    delta = std::min(std::max(delta, -tc), tc);
+    int apply = (std::abs(p - q) < alpha) & (std::abs(p1 - p) < beta) & (std::abs(q1 - q) < beta);
+    delta *= apply;
+    p0 = static_cast<uint8_t>(std::min(std::max(p + delta, 0), 255));
+    q0 = static_cast<uint8_t>(std::min(std::max(q - delta, 0), 255));
+}
+
+/// @brief Filter `count` edge samples; p0 and q0 are updated in place and may alias p1 and q1
+static void filterSegments(const uint8_t *p1, uint8_t *p0, uint8_t *q0, const uint8_t *q1,
+                           const uint8_t *alpha, const uint8_t *beta, const uint8_t *tc, size_t count) {
+    size_t i = 0;
+    for (; i + LANE_SAMPLES <= count; i += LANE_SAMPLES) {
+        uint8_t a1[LANE_SAMPLES], a0[LANE_SAMPLES], b0[LANE_SAMPLES], b1[LANE_SAMPLES];
+        uint8_t lane_alpha[LANE_SAMPLES], lane_beta[LANE_SAMPLES], lane_tc[LANE_SAMPLES];
+        std::memcpy(a1, p1 + i, LANE_SAMPLES);
+        std::memcpy(a0, p0 + i, LANE_SAMPLES);
+        std::memcpy(b0, q0 + i, LANE_SAMPLES);
+        std::memcpy(b1, q1 + i, LANE_SAMPLES);
+        std::memcpy(lane_alpha, alpha + i, LANE_SAMPLES);
+        std::memcpy(lane_beta, beta + i, LANE_SAMPLES);
+        std::memcpy(lane_tc, tc + i, LANE_SAMPLES);
+        for (int k = 0; k < LANE_SAMPLES; k++) {
+            filterSample(a1[k], a0[k], b0[k], b1[k], lane_alpha[k], lane_beta[k], lane_tc[k]);
+        }
+        std::memcpy(p0 + i, a0, LANE_SAMPLES);
+        std::memcpy(q0 + i, b0, LANE_SAMPLES);
+    }
+    for (; i < count; i++) {
+        uint8_t a0 = p0[i], b0 = q0[i];
+        filterSample(p1[i], a0, b0, q1[i], alpha[i], beta[i], tc[i]);
+        p0[i] = a0;
+        q0[i] = b0;
+    }
+}
+
+/// @brief Run body(begin, end) over [0, count) in up to one stripe per worker and wait for all of them
+static void runStripes(ThreadPool *pool, int count, int minPerStripe,
+                       const std::function<void(int, int)> &body) {
+    int stripes = pool ? std::min(static_cast<int>(pool->size()), count / std::max(1, minPerStripe)) : 1;
+    if (stripes <= 1) {
+        body(0, count);
+        return;
+    }
+    ThreadPool::TaskGroup group;
+    for (int stripe = 0; stripe < stripes; stripe++) {
+        int begin = count * stripe / stripes, end = count * (stripe + 1) / stripes;
+        pool->submit([&body, begin, end]() { body(begin, end); }, &group);
+    }
+    pool->wait(group);
+}
+
+void deblockPlane(uint8_t *plane, int width, int height, int channels, int blockSize,
+                  const uint8_t *blockSteps, ThreadPool *pool) {
+    if (blockSize < 4 || width <= 0 || height <= 0 || channels <= 0) return;
+    int blocks_x = (width + blockSize - 1) / blockSize;
+    int blocks_y = (height + blockSize - 1) / blockSize;
+    size_t row_samples = static_cast<size_t>(width) * channels;
+
+    // Vertical edges: the edge samples of a row are gathered into contiguous segments, filtered, and
+    // scattered back; the thresholds change once per block row
+    if (blocks_x > 1) {
+        size_t edge_samples = static_cast<size_t>(blocks_x - 1) * channels;
+        runStripes(pool, height, MIN_STRIPE_ROWS, [&](int y0, int y1) {
+            std::vector<uint8_t> p1(edge_samples), p0(edge_samples), q0(edge_samples), q1(edge_samples);
+            std::vector<uint8_t> alpha(edge_samples), beta(edge_samples), tc(edge_samples);
+            int threshold_row = -1;
+            for (int y = y0; y < y1; y++) {
+                const uint8_t *steps = blockSteps + static_cast<size_t>(y / blockSize) * blocks_x;
+                if (y / blockSize != threshold_row) {
+                    threshold_row = y / blockSize;
+                    for (int edge = 0; edge < blocks_x - 1; edge++) {
+                        for (int c = 0; c < channels; c++) {
+                            size_t i = static_cast<size_t>(edge) * channels + c;
+                            edgeThresholds(std::max(steps[edge], steps[edge + 1]), alpha[i], beta[i], tc[i]);
+                        }
+                    }
+                }
+                uint8_t *row = plane + static_cast<size_t>(y) * row_samples;
+                for (int edge = 0; edge < blocks_x - 1; edge++) {
+                    int x = (edge + 1) * blockSize;
+                    for (int c = 0; c < channels; c++) {
+                        size_t i = static_cast<size_t>(edge) * channels + c;
+                        p1[i] = row[(x - 2) * channels + c];
+                        p0[i] = row[(x - 1) * channels + c];
+                        q0[i] = row[x * channels + c];
+                        q1[i] = row[std::min(x + 1, width - 1) * channels + c];
+                    }
+                }
+                filterSegments(p1.data(), p0.data(), q0.data(), q1.data(), alpha.data(), beta.data(),
+                               tc.data(), edge_samples);
+                for (int edge = 0; edge < blocks_x - 1; edge++) {
+                    int x = (edge + 1) * blockSize;
+                    for (int c = 0; c < channels; c++) {
+                        size_t i = static_cast<size_t>(edge) * channels + c;
+                        row[(x - 1) * channels + c] = p0[i];
+                        row[x * channels + c] = q0[i];
+                    }
+                }
+            }
+        });
+    }
+
+    // Horizontal edges: the four rows around an edge are contiguous, so they are filtered in place
+    if (blocks_y > 1) {
+        runStripes(pool, blocks_y - 1, MIN_STRIPE_ROWS / blockSize, [&](int edge0, int edge1) {
+            std::vector<uint8_t> alpha(row_samples), beta(row_samples), tc(row_samples);
+            for (int edge = edge0; edge < edge1; edge++) {
+                const uint8_t *above = blockSteps + static_cast<size_t>(edge) * blocks_x;
+                const uint8_t *below = above + blocks_x;
+                for (int x = 0; x < width; x++) {
+                    int block = x / blockSize;
+                    size_t i = static_cast<size_t>(x) * channels;
+                    edgeThresholds(std::max(above[block], below[block]), alpha[i], beta[i], tc[i]);
+                    for (int c = 1; c < channels; c++) {
+                        alpha[i + c] = alpha[i];
+                        beta[i + c] = beta[i];
+                        tc[i + c] = tc[i];
+                    }
+                }
+                int y = (edge + 1) * blockSize;
+                uint8_t *q0 = plane + static_cast<size_t>(y) * row_samples;
+                filterSegments(q0 - 2 * row_samples, q0 - row_samples, q0,
+                               plane + static_cast<size_t>(std::min(y + 1, height - 1)) * row_samples,
+                               alpha.data(), beta.data(), tc.data(), row_samples);
+            }
+        });
+    }
+}
+
+} // namespace utils
+} // namespace vcompress
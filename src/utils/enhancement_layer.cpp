@@ -0,0 +1,45 @@
+#include "utils/enhancement_layer.hpp"
+#include "utils/residual_coder.hpp"
+#include <cstring>
+
+namespace vcompress {
+namespace utils {
+
+static const size_t RECORD_HEADER_BYTES = 4 + 4 + 1;
+
+std::vector<uint8_t> packEnhancementLayer(const uint8_t *source, const uint8_t *base, int width, int height,
+                                          int quantStep) {
+    std::vector<uint8_t> data(RECORD_HEADER_BYTES);
+    std::memcpy(data.data(), &width, 4);
+    std::memcpy(data.data() + 4, &height, 4);
+    data[8] = static_cast<uint8_t>(quantStep);
+
+    // The encoder never predicts from the enhanced frame, so the reconstruction is scratch
+    size_t count = static_cast<size_t>(width) * height * 3;
+    std::vector<uint8_t> reconstruction(count);
+    {
+        BitWriter writer(data);
+        encodeResidual(writer, source, base, count, quantStep, reconstruction.data());
+    }
+    return data;
+}
+
+bool applyEnhancementLayer(const std::vector<uint8_t> &data, uint8_t *frame, int width, int height) {
+    if (data.size() < RECORD_HEADER_BYTES) return false;
+    int record_width, record_height;
+    std::memcpy(&record_width, data.data(), 4);
+    std::memcpy(&record_height, data.data() + 4, 4);
+    int quant_step = data[8];
+    if (record_width != width || record_height != height || quant_step == 0) return false;
+
+    // Decode into a copy, so a corrupt record leaves the base layer intact
+    size_t count = static_cast<size_t>(width) * height * 3;
+    std::vector<uint8_t> enhanced(count);
+    BitReader reader(data.data() + RECORD_HEADER_BYTES, data.size() - RECORD_HEADER_BYTES);
+    if (!decodeResidual(reader, frame, count, quant_step, enhanced.data())) return false;
+    std::memcpy(frame, enhanced.data(), count);
+    return true;
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -1,11 +1,30 @@
 #include "utils/file_reader.hpp"
+#include "utils/content_hash.hpp"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace vcompress {
 namespace utils {
 
+/**
+ * Frame cache file:
+ *   | "VFRC" | version (4) | width (4) | height (4) | fourcc (4) | frame count (4) | fps (8) | padding |
+ *   | frame 0 (width * height * 3, BGR) | frame 1 | ...
+ */
+static const char CACHE_MAGIC[4] = {'V', 'F', 'R', 'C'};
+static const uint32_t CACHE_VERSION = 1;
+static const size_t CACHE_HEADER_BYTES = 64;
+
 /// @brief Constructor
-FileReader::FileReader() : m_isOpen(false), m_width(0), m_height(0), m_fps(0), m_frameCount(0), m_fourcc(0) {}
+FileReader::FileReader()
+    : m_cacheMapping(nullptr), m_cacheMappingSize(0), m_cacheFrameIndex(0), m_cacheFramesWritten(0),
+      m_isOpen(false), m_width(0), m_height(0), m_fps(0), m_frameCount(0), m_fourcc(0) {}
 
 /// @brief Destructor
 FileReader::~FileReader() { close(); }
@@ -25,9 +44,13 @@ void FileReader::updateVideoProperties() {
 bool FileReader::openFile(const std::string &filename) {
     if (m_isOpen) close();
 
-    m_isOpen = m_videoCapture.open(filename);
+    std::string cachePath = m_frameCacheDir.empty() ? "" : cachePathFor(filename);
+    bool cached = !cachePath.empty() && openCachedFrames(cachePath);
+    m_isOpen = cached || m_videoCapture.open(filename);
     if (m_isOpen) {
-        updateVideoProperties();
+        if (!cached) updateVideoProperties();
+        if (!cached && !cachePath.empty()) beginCacheFill(cachePath);
+        if (cached) std::cout << "Serving decoded frames from cache: " << cachePath << std::endl;
         std::cout << "Opened input video file: " << filename << std::endl;
         std::cout << "  Dimensions: " << m_width << "x" << m_height << std::endl;
         std::cout << "  FPS: " << m_fps << std::endl;
@@ -49,7 +72,22 @@ bool FileReader::readNextFrame(cv::Mat &frame) {
     if (!m_isOpen) {
         return false;
     }
-    return m_videoCapture.read(frame);
+    if (m_cacheMapping) {
+        // The mapping is private, so a caller writing into the frame never reaches the cache file
+        if (m_cacheFrameIndex >= m_frameCount) return false;
+        size_t frameBytes = static_cast<size_t>(m_width) * m_height * 3;
+        frame = cv::Mat(m_height, m_width, CV_8UC3,
+                        m_cacheMapping + CACHE_HEADER_BYTES + m_cacheFrameIndex * frameBytes);
+        m_cacheFrameIndex++;
+        return true;
+    }
+
+    bool read = m_videoCapture.read(frame);
+    if (m_cacheWriter.is_open()) {
+        if (read) appendCachedFrame(frame);
+        else finishCacheFill();
+    }
+    return read;
 }
 
 /// @brief Read the next frame and convert to the Frame format
@@ -75,6 +113,28 @@ bool FileReader::readNextFrame(algorithm::Frame &frame, int frameNumber) {
     return true;
 }
 
+/// @brief Seek by frame index, verified against the position the backend reports
+bool FileReader::seekToFrame(int frameNumber) {
+    if (!m_isOpen) return false;
+    if (m_cacheMapping) {
+        if (frameNumber > m_frameCount) return false;
+        m_cacheFrameIndex = frameNumber;
+        return true;
+    }
+    abandonCacheFill(); // The cache only stores complete sequential reads
+    if (m_videoCapture.set(cv::CAP_PROP_POS_FRAMES, frameNumber) &&
+        static_cast<int>(m_videoCapture.get(cv::CAP_PROP_POS_FRAMES)) == frameNumber) {
+        return true;
+    }
+
+    std::cout << "Inexact seek, skipping " << frameNumber << " frames from the start..." << std::endl;
+    if (!m_videoCapture.set(cv::CAP_PROP_POS_FRAMES, 0)) return false;
+    for (int i = 0; i < frameNumber; i++) {
+        if (!m_videoCapture.grab()) return false;
+    }
+    return true;
+}
+
 /// @brief Get the width
 int FileReader::getWidth() const { return m_width; }
 
@@ -101,6 +161,8 @@ double FileReader::getDuration() const {
 /// @brief Close the video file
 void FileReader::close() {
     if (m_isOpen) {
+        abandonCacheFill();
+        closeCachedFrames();
         m_videoCapture.release();
         m_isOpen = false;
         m_width = 0;
@@ -111,5 +173,123 @@ void FileReader::close() {
     }
 }
 
+/// @brief <cache dir>/<hash of the absolute path, size and modification time>.frames
+std::string FileReader::cachePathFor(const std::string &filename) const {
+    char absolutePath[PATH_MAX];
+    struct stat info;
+    if (!realpath(filename.c_str(), absolutePath) || stat(absolutePath, &info) != 0) return "";
+
+    ContentHash hash;
+    hash.update(std::string(absolutePath));
+    hash.update(static_cast<int64_t>(info.st_size));
+    hash.update(static_cast<int64_t>(info.st_mtim.tv_sec));
+    hash.update(static_cast<int64_t>(info.st_mtim.tv_nsec));
+    return m_frameCacheDir + "/" + hash.hex() + ".frames";
+}
+
+/// @brief Map a complete cache file and take the video properties from its header
+bool FileReader::openCachedFrames(const std::string &cachePath) {
+    FILE *file = std::fopen(cachePath.c_str(), "rb");
+    if (!file) return false;
+
+    uint8_t header[CACHE_HEADER_BYTES];
+    bool valid = std::fread(header, 1, CACHE_HEADER_BYTES, file) == CACHE_HEADER_BYTES &&
+                 std::memcmp(header, CACHE_MAGIC, 4) == 0;
+    uint32_t version = 0;
+    int32_t width = 0, height = 0, fourcc = 0, frameCount = 0;
+    double fps = 0.0;
+    if (valid) {
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&width, header + 8, 4);
+        std::memcpy(&height, header + 12, 4);
+        std::memcpy(&fourcc, header + 16, 4);
+        std::memcpy(&frameCount, header + 20, 4);
+        std::memcpy(&fps, header + 24, 8);
+    }
+
+    struct stat info;
+    size_t expectedSize = CACHE_HEADER_BYTES + static_cast<size_t>(width) * height * 3 * frameCount;
+    valid = valid && version == CACHE_VERSION && width > 0 && height > 0 && frameCount > 0 &&
+            fstat(fileno(file), &info) == 0 && static_cast<size_t>(info.st_size) == expectedSize;
+    void *mapping = valid ? mmap(nullptr, expectedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0)
+                          : MAP_FAILED;
+    std::fclose(file);
+    if (mapping == MAP_FAILED) return false;
+
+    madvise(mapping, expectedSize, MADV_SEQUENTIAL);
+    m_cacheMapping = static_cast<uint8_t *>(mapping);
+    m_cacheMappingSize = expectedSize;
+    m_cacheFrameIndex = 0;
+    m_width = width;
+    m_height = height;
+    m_fourcc = fourcc;
+    m_frameCount = frameCount;
+    m_fps = fps;
+    return true;
+}
+
+void FileReader::closeCachedFrames() {
+    if (m_cacheMapping) munmap(m_cacheMapping, m_cacheMappingSize);
+    m_cacheMapping = nullptr;
+    m_cacheMappingSize = 0;
+}
+
+/// @brief Start writing decoded frames to a private partial file; the frame count is filled in at the end
+void FileReader::beginCacheFill(const std::string &cachePath) {
+    m_cachePath = cachePath;
+    m_cachePartialPath = cachePath + "." + std::to_string(getpid()) + ".partial";
+    m_cacheFramesWritten = 0;
+    m_cacheWriter.open(m_cachePartialPath, std::ios::binary | std::ios::trunc);
+    if (!m_cacheWriter.is_open()) return;
+
+    uint8_t header[CACHE_HEADER_BYTES] = {};
+    m_cacheWriter.write(reinterpret_cast<const char *>(header), CACHE_HEADER_BYTES);
+}
+
+void FileReader::appendCachedFrame(const cv::Mat &frame) {
+    // Only fixed-size 8-bit BGR frames can be served from a flat file
+    if (frame.type() != CV_8UC3 || frame.cols != m_width || frame.rows != m_height || !frame.isContinuous()) {
+        abandonCacheFill();
+        return;
+    }
+    m_cacheWriter.write(reinterpret_cast<const char *>(frame.data), frame.total() * frame.elemSize());
+    if (!m_cacheWriter) {
+        abandonCacheFill(); // Typically a full disk
+        return;
+    }
+    m_cacheFramesWritten++;
+}
+
+/// @brief The source was read to the end: write the header and publish the file under its final name
+void FileReader::finishCacheFill() {
+    if (m_cacheFramesWritten == 0) {
+        abandonCacheFill();
+        return;
+    }
+    uint8_t header[CACHE_HEADER_BYTES] = {};
+    int32_t fourcc = m_fourcc, frameCount = m_cacheFramesWritten;
+    std::memcpy(header, CACHE_MAGIC, 4);
+    std::memcpy(header + 4, &CACHE_VERSION, 4);
+    std::memcpy(header + 8, &m_width, 4);
+    std::memcpy(header + 12, &m_height, 4);
+    std::memcpy(header + 16, &fourcc, 4);
+    std::memcpy(header + 20, &frameCount, 4);
+    std::memcpy(header + 24, &m_fps, 8);
+    m_cacheWriter.seekp(0);
+    m_cacheWriter.write(reinterpret_cast<const char *>(header), CACHE_HEADER_BYTES);
+    m_cacheWriter.close();
+    if (m_cacheWriter.fail() || std::rename(m_cachePartialPath.c_str(), m_cachePath.c_str()) != 0) {
+        std::remove(m_cachePartialPath.c_str());
+        return;
+    }
+    std::cout << "Cached " << frameCount << " decoded frames in " << m_cachePath << std::endl;
+}
+
+void FileReader::abandonCacheFill() {
+    if (!m_cacheWriter.is_open()) return;
+    m_cacheWriter.close();
+    std::remove(m_cachePartialPath.c_str());
+}
+
 } // namespace utils
 } // namespace vcompress
\ No newline at end of file
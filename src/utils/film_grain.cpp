@@ -0,0 +1,230 @@
+#include "utils/film_grain.hpp"
+#include "utils/complexity_analyzer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vcompress {
+namespace utils {
+
+static const int GRAIN_BLOCK = 16;
+static constexpr int NOISE_BLOCK = 16;
+static const size_t RECORD_BYTES = 1 + FilmGrainParams::LUMA_BANDS + 1 + 2;
+
+// Standard deviation of the white noise: a sum of four uniform bytes, centered
+static const double WHITE_SIGMA = 147.8;
+
+double FilmGrainParams::meanSigma() const {
+    int total = 0;
+    for (int band = 0; band < LUMA_BANDS; band++) total += sigma[band];
+    return total / (4.0 * LUMA_BANDS);
+}
+
+/**
+ * @brief High-pass response of the grain model for a smoothing mix `m` (0-1)
+ *  The grain kernel is (1 - m) * delta + m * [1 2 1] x [1 2 1] / 16 applied to white noise; the estimator's
+ *  high-pass subtracts the 3x3 mean. Returns the high-pass to grain variance ratio and the lag-1
+ *  correlation of the high-pass, so measured statistics can be mapped back onto the model.
+ */
+static void modelHighPass(double m, double &gain, double &correlation) {
+    static const int taps[3] = {1, 2, 1};
+    double grain[5][5] = {}, high_pass[5][5] = {};
+    grain[2][2] = 1.0 - m;
+    for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 3; x++) grain[y + 1][x + 1] += m * taps[y] * taps[x] / 16.0;
+    }
+    for (int y = 0; y < 5; y++) {
+        for (int x = 0; x < 5; x++) {
+            double mean = 0.0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int sy = y + dy, sx = x + dx;
+                    if (sy >= 0 && sy < 5 && sx >= 0 && sx < 5) mean += grain[sy][sx] / 9.0;
+                }
+            }
+            high_pass[y][x] = grain[y][x] - mean;
+        }
+    }
+    double grain_energy = 0.0, energy = 0.0, lag_product = 0.0;
+    for (int y = 0; y < 5; y++) {
+        for (int x = 0; x < 5; x++) {
+            grain_energy += grain[y][x] * grain[y][x];
+            energy += high_pass[y][x] * high_pass[y][x];
+            if (x < 4) lag_product += high_pass[y][x] * high_pass[y][x + 1];
+        }
+    }
+    gain = energy / grain_energy;
+    correlation = lag_product / energy;
+}
+
+FilmGrainParams estimateFilmGrain(const uint8_t *bgr, int width, int height, uint16_t seed) {
+    FilmGrainParams params;
+    params.seed = seed;
+    int luma_width, luma_height;
+    std::vector<uint8_t> luma = decimatedLuma(bgr, width, height, 1, luma_width, luma_height);
+
+    struct Block {
+        double variance;
+        double lagProduct;
+        double energy;
+    };
+    std::vector<Block> bands[FilmGrainParams::LUMA_BANDS];
+    for (int y0 = 1; y0 + GRAIN_BLOCK < luma_height; y0 += GRAIN_BLOCK) {
+        for (int x0 = 1; x0 + GRAIN_BLOCK < luma_width; x0 += GRAIN_BLOCK) {
+            // High-pass in ninths of a sample: 9 * pixel - sum of its 3x3 neighbourhood
+            int64_t sum_luma = 0, energy = 0, lag_product = 0;
+            for (int y = y0; y < y0 + GRAIN_BLOCK; y++) {
+                int previous = 0;
+                for (int x = x0; x < x0 + GRAIN_BLOCK; x++) {
+                    const uint8_t *p = luma.data() + y * luma_width + x;
+                    int neighbourhood = p[-luma_width - 1] + p[-luma_width] + p[-luma_width + 1] + p[-1] +
+                                        p[0] + p[1] + p[luma_width - 1] + p[luma_width] + p[luma_width + 1];
+                    int high_pass = 9 * p[0] - neighbourhood;
+                    sum_luma += p[0];
+                    energy += high_pass * high_pass;
+                    if (x > x0) lag_product += high_pass * previous;
+                    previous = high_pass;
+                }
+            }
+            int band = static_cast<int>(sum_luma / (GRAIN_BLOCK * GRAIN_BLOCK)) >> 5;
+            double variance = energy / (81.0 * GRAIN_BLOCK * GRAIN_BLOCK);
+            bands[band].push_back({variance, static_cast<double>(lag_product), static_cast<double>(energy)});
+        }
+    }
+
+    // High-pass variance per band from its quietest quarter of blocks, and the lag-1 statistics of those
+    double lag_product = 0.0, energy = 0.0;
+    double band_variance[FilmGrainParams::LUMA_BANDS] = {};
+    bool measured[FilmGrainParams::LUMA_BANDS] = {};
+    for (int band = 0; band < FilmGrainParams::LUMA_BANDS; band++) {
+        std::vector<Block> &blocks = bands[band];
+        if (blocks.empty()) continue;
+        std::sort(blocks.begin(), blocks.end(),
+                  [](const Block &a, const Block &b) { return a.variance < b.variance; });
+        size_t quiet = std::max<size_t>(1, blocks.size() / 4);
+        for (size_t i = 0; i < quiet; i++) {
+            band_variance[band] += blocks[i].variance / quiet;
+            lag_product += blocks[i].lagProduct;
+            energy += blocks[i].energy * (GRAIN_BLOCK - 1) / GRAIN_BLOCK;
+        }
+        measured[band] = true;
+    }
+    if (energy <= 0.0) return params;
+
+    // The mix whose high-pass correlation matches the measurement, then the grain variance it implies
+    double measured_correlation = lag_product / energy;
+    double best_error = 1e9, best_gain = 1.0;
+    for (int code = 0; code <= 255; code++) {
+        double gain, correlation;
+        modelHighPass(code / 255.0, gain, correlation);
+        if (std::abs(correlation - measured_correlation) < best_error) {
+            best_error = std::abs(correlation - measured_correlation);
+            best_gain = gain;
+            params.correlation = static_cast<uint8_t>(code);
+        }
+    }
+
+    for (int band = 0; band < FilmGrainParams::LUMA_BANDS; band++) {
+        int source = band;
+        for (int distance = 1; !measured[source] && distance < FilmGrainParams::LUMA_BANDS; distance++) {
+            if (band - distance >= 0 && measured[band - distance]) {
+                source = band - distance;
+            } else if (band + distance < FilmGrainParams::LUMA_BANDS && measured[band + distance]) {
+                source = band + distance;
+            }
+        }
+        double sigma = std::sqrt(band_variance[source] / best_gain);
+        params.sigma[band] = static_cast<uint8_t>(std::min(255.0, std::round(4.0 * sigma)));
+    }
+    return params;
+}
+
+std::vector<uint8_t> packFilmGrain(const FilmGrainParams &params) {
+    std::vector<uint8_t> data(RECORD_BYTES);
+    data[0] = FilmGrainParams::LUMA_BANDS;
+    std::memcpy(data.data() + 1, params.sigma, FilmGrainParams::LUMA_BANDS);
+    data[1 + FilmGrainParams::LUMA_BANDS] = params.correlation;
+    std::memcpy(data.data() + 2 + FilmGrainParams::LUMA_BANDS, &params.seed, 2);
+    return data;
+}
+
+bool unpackFilmGrain(const std::vector<uint8_t> &data, FilmGrainParams &params) {
+    if (data.size() < RECORD_BYTES || data[0] != FilmGrainParams::LUMA_BANDS) return false;
+    std::memcpy(params.sigma, data.data() + 1, FilmGrainParams::LUMA_BANDS);
+    params.correlation = data[1 + FilmGrainParams::LUMA_BANDS];
+    std::memcpy(&params.seed, data.data() + 2 + FilmGrainParams::LUMA_BANDS, 2);
+    return true;
+}
+
+/// @brief Approximately Gaussian noise sample (sigma WHITE_SIGMA) from a Murmur3-finalized counter
+static inline int16_t whiteNoise(uint32_t index, uint32_t key) {
+    uint32_t h = index * 0x9E3779B1u ^ key;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return static_cast<int16_t>((h & 0xFF) + ((h >> 8) & 0xFF) + ((h >> 16) & 0xFF) + (h >> 24) - 510);
+}
+
+void FilmGrainSynthesizer::apply(const FilmGrainParams &params, int frameIndex, uint8_t *bgr, int width,
+                                 int height) {
+    if (width <= 0 || height <= 0) return;
+    size_t pixels = static_cast<size_t>(width) * height;
+    m_white.resize(pixels);
+    m_rows.resize(pixels);
+    m_grain.resize(pixels);
+
+    uint32_t key = params.seed * 0x27D4EB2Fu + static_cast<uint32_t>(frameIndex) * 0x165667B1u;
+    int16_t *white = m_white.data();
+    // Fixed-size blocks give the generator loop a constant trip count, which the compiler vectorizes at -O2
+    size_t i = 0;
+    for (; i + NOISE_BLOCK <= pixels; i += NOISE_BLOCK) {
+        for (int k = 0; k < NOISE_BLOCK; k++) white[i + k] = whiteNoise(static_cast<uint32_t>(i + k), key);
+    }
+    for (; i < pixels; i++) white[i] = whiteNoise(static_cast<uint32_t>(i), key);
+
+    // [1 2 1] horizontally, then vertically (edges clamped): the smoothed copy is 16x the white scale
+    for (int y = 0; y < height; y++) {
+        const int16_t *in = white + static_cast<size_t>(y) * width;
+        int16_t *out = m_rows.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            int left = in[std::max(x - 1, 0)], right = in[std::min(x + 1, width - 1)];
+            out[x] = static_cast<int16_t>(left + 2 * in[x] + right);
+        }
+    }
+    int mix = (params.correlation * 256 + 127) / 255;
+    for (int y = 0; y < height; y++) {
+        const int16_t *above = m_rows.data() + static_cast<size_t>(std::max(y - 1, 0)) * width;
+        const int16_t *row = m_rows.data() + static_cast<size_t>(y) * width;
+        const int16_t *below = m_rows.data() + static_cast<size_t>(std::min(y + 1, height - 1)) * width;
+        const int16_t *in = white + static_cast<size_t>(y) * width;
+        int16_t *out = m_grain.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            int smooth = above[x] + 2 * row[x] + below[x];
+            out[x] = static_cast<int16_t>(((256 - mix) * 16 * in[x] + mix * smooth) >> 8);
+        }
+    }
+
+    // Blend variance relative to white: (1-m)^2 + (6/16)^2 m^2 + 2 m (1-m) / 4, with m = mix / 256
+    double m = mix / 256.0;
+    double mix_sigma = std::sqrt((1 - m) * (1 - m) + 0.140625 * m * m + 0.5 * m * (1 - m));
+    int scale[FilmGrainParams::LUMA_BANDS];
+    for (int band = 0; band < FilmGrainParams::LUMA_BANDS; band++) {
+        scale[band] = static_cast<int>(std::lround(params.sigma[band] / 4.0 * 65536.0 /
+                                                   (WHITE_SIGMA * 16.0 * mix_sigma)));
+    }
+
+    const int16_t *grain = m_grain.data();
+    for (i = 0; i < pixels; i++) {
+        uint8_t *p = bgr + i * 3;
+        int band = ((29 * p[0] + 150 * p[1] + 77 * p[2]) >> 8) >> 5;
+        int delta = (grain[i] * scale[band] + 32768) >> 16;
+        p[0] = static_cast<uint8_t>(std::clamp(p[0] + delta, 0, 255));
+        p[1] = static_cast<uint8_t>(std::clamp(p[1] + delta, 0, 255));
+        p[2] = static_cast<uint8_t>(std::clamp(p[2] + delta, 0, 255));
+    }
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,181 @@
+#include "utils/motion.hpp"
+#include "algorithms/bilinear_downsample_algorithm.hpp"
+#include "utils/complexity_analyzer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace vcompress {
+namespace utils {
+
+using algorithm::calculateInterpolationParams;
+using algorithm::getPixelValue;
+
+// Search is done on the half-resolution luma; +-7 luma samples cover about +-14 full-resolution pixels
+static const int LUMA_STEP = 2;
+static const int SEARCH_RANGE = 7;
+static const size_t RECORD_HEADER_BYTES = 4 + 4 + 1 + 1 + 1;
+
+/// @brief Sum of absolute differences of a luma block against a displaced reference block (edge clamped)
+static int blockSAD(const std::vector<uint8_t> &target, const std::vector<uint8_t> &reference, int luma_width,
+                    int luma_height, int x0, int y0, int block_width, int block_height, int dx, int dy) {
+    int sad = 0;
+    for (int y = 0; y < block_height; y++) {
+        int ry = std::max(0, std::min(luma_height - 1, y0 + y + dy));
+        const uint8_t *target_row = target.data() + (y0 + y) * luma_width + x0;
+        const uint8_t *reference_row = reference.data() + ry * luma_width;
+        for (int x = 0; x < block_width; x++) {
+            int rx = std::max(0, std::min(luma_width - 1, x0 + x + dx));
+            sad += std::abs(target_row[x] - reference_row[rx]);
+        }
+    }
+    return sad;
+}
+
+/// @brief Three-step search per block; blocks that already match at zero motion are left untouched
+MotionField estimateMotion(const uint8_t *target, const uint8_t *reference, int width, int height,
+                           int blockSize) {
+    int luma_width, luma_height;
+    std::vector<uint8_t> target_luma =
+        decimatedLuma(target, width, height, LUMA_STEP, luma_width, luma_height);
+    std::vector<uint8_t> reference_luma =
+        decimatedLuma(reference, width, height, LUMA_STEP, luma_width, luma_height);
+
+    MotionField field;
+    field.blockSize = blockSize;
+    field.blocksX = (width + blockSize - 1) / blockSize;
+    field.blocksY = (height + blockSize - 1) / blockSize;
+    field.vectors.assign(field.blocksX * field.blocksY * 2, 0);
+
+    int luma_block = blockSize / LUMA_STEP;
+    for (int by = 0; by < field.blocksY; by++) {
+        for (int bx = 0; bx < field.blocksX; bx++) {
+            int x0 = bx * luma_block, y0 = by * luma_block;
+            int block_width = std::min(luma_block, luma_width - x0);
+            int block_height = std::min(luma_block, luma_height - y0);
+            if (block_width <= 0 || block_height <= 0) continue;
+
+            int best_dx = 0, best_dy = 0;
+            int best_sad = blockSAD(target_luma, reference_luma, luma_width, luma_height, x0, y0, block_width,
+                                    block_height, 0, 0);
+            if (best_sad <= block_width * block_height) continue; // Static block
+
+            for (int step = 4; step >= 1; step /= 2) {
+                int center_dx = best_dx, center_dy = best_dy;
+                for (int sy = -1; sy <= 1; sy++) {
+                    for (int sx = -1; sx <= 1; sx++) {
+                        int dx = center_dx + sx * step, dy = center_dy + sy * step;
+                        if (sx == 0 && sy == 0) continue;
+                        if (std::abs(dx) > SEARCH_RANGE || std::abs(dy) > SEARCH_RANGE) continue;
+                        int sad = blockSAD(target_luma, reference_luma, luma_width, luma_height, x0, y0,
+                                           block_width, block_height, dx, dy);
+                        if (sad < best_sad) {
+                            best_sad = sad;
+                            best_dx = dx;
+                            best_dy = dy;
+                        }
+                    }
+                }
+            }
+            field.vectors[(by * field.blocksX + bx) * 2] = static_cast<int8_t>(best_dx * LUMA_STEP);
+            field.vectors[(by * field.blocksX + bx) * 2 + 1] = static_cast<int8_t>(best_dy * LUMA_STEP);
+        }
+    }
+    return field;
+}
+
+/// @brief Motion vector at a pixel, bilinearly interpolated between the surrounding block centers
+static void vectorAt(const MotionField &field, int x, int y, float &vx, float &vy) {
+    float gx = std::max(0.0f, (x + 0.5f) / field.blockSize - 0.5f);
+    float gy = std::max(0.0f, (y + 0.5f) / field.blockSize - 0.5f);
+    auto [x_floor, x_ceil, x_fraction] = calculateInterpolationParams(gx, 1.0f, field.blocksX);
+    auto [y_floor, y_ceil, y_fraction] = calculateInterpolationParams(gy, 1.0f, field.blocksY);
+    x_floor = std::min(x_floor, field.blocksX - 1);
+    y_floor = std::min(y_floor, field.blocksY - 1);
+    if (x_floor == field.blocksX - 1) x_fraction = 0.0f;
+    if (y_floor == field.blocksY - 1) y_fraction = 0.0f;
+
+    const int8_t *v = field.vectors.data();
+    for (int i = 0; i < 2; i++) {
+        float top = v[(y_floor * field.blocksX + x_floor) * 2 + i] * (1 - x_fraction) +
+                    v[(y_floor * field.blocksX + x_ceil) * 2 + i] * x_fraction;
+        float bottom = v[(y_ceil * field.blocksX + x_floor) * 2 + i] * (1 - x_fraction) +
+                       v[(y_ceil * field.blocksX + x_ceil) * 2 + i] * x_fraction;
+        (i == 0 ? vx : vy) = top * (1 - y_fraction) + bottom * y_fraction;
+    }
+}
+
+/// @brief Bilinear sample of a BGR frame at a fractional, edge-clamped position
+static void sampleBilinear(const uint8_t *src, int width, int height, float x, float y, float *out) {
+    x = std::max(0.0f, std::min(static_cast<float>(width - 1), x));
+    y = std::max(0.0f, std::min(static_cast<float>(height - 1), y));
+    auto [x_floor, x_ceil, x_fraction] = calculateInterpolationParams(x, 1.0f, width);
+    auto [y_floor, y_ceil, y_fraction] = calculateInterpolationParams(y, 1.0f, height);
+    for (int c = 0; c < 3; c++) {
+        float top = getPixelValue(src, width, y_floor, x_floor, c) * (1 - x_fraction) +
+                    getPixelValue(src, width, y_floor, x_ceil, c) * x_fraction;
+        float bottom = getPixelValue(src, width, y_ceil, x_floor, c) * (1 - x_fraction) +
+                       getPixelValue(src, width, y_ceil, x_ceil, c) * x_fraction;
+        out[c] = top * (1 - y_fraction) + bottom * y_fraction;
+    }
+}
+
+/// @brief Warp both anchors along their fields and blend them by temporal distance
+void interpolateFrame(const uint8_t *previous, const uint8_t *next, const MotionField &forward,
+                      const MotionField &backward, float position, uint8_t *dst, int width, int height) {
+    float from_previous[3], from_next[3];
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float fx, fy, bx, by;
+            vectorAt(forward, x, y, fx, fy);
+            vectorAt(backward, x, y, bx, by);
+            sampleBilinear(previous, width, height, x + fx, y + fy, from_previous);
+            sampleBilinear(next, width, height, x + bx, y + by, from_next);
+            for (int c = 0; c < 3; c++) {
+                float result = from_previous[c] * (1 - position) + from_next[c] * position;
+                dst[(y * width + x) * 3 + c] = static_cast<uint8_t>(result + 0.5f);
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> packInterpolatedFrame(int width, int height, int position, int span,
+                                           const MotionField &forward, const MotionField &backward) {
+    std::vector<uint8_t> data(RECORD_HEADER_BYTES + forward.vectors.size() + backward.vectors.size());
+    std::memcpy(data.data(), &width, 4);
+    std::memcpy(data.data() + 4, &height, 4);
+    data[8] = static_cast<uint8_t>(forward.blockSize);
+    data[9] = static_cast<uint8_t>(position);
+    data[10] = static_cast<uint8_t>(span);
+    std::memcpy(data.data() + RECORD_HEADER_BYTES, forward.vectors.data(), forward.vectors.size());
+    std::memcpy(data.data() + RECORD_HEADER_BYTES + forward.vectors.size(), backward.vectors.data(),
+                backward.vectors.size());
+    return data;
+}
+
+bool unpackInterpolatedFrame(const std::vector<uint8_t> &data, int &width, int &height, int &position,
+                             int &span, MotionField &forward, MotionField &backward) {
+    if (data.size() < RECORD_HEADER_BYTES) return false;
+    std::memcpy(&width, data.data(), 4);
+    std::memcpy(&height, data.data() + 4, 4);
+    int block_size = data[8];
+    position = data[9];
+    span = data[10];
+    if (block_size == 0 || span == 0) return false;
+
+    for (MotionField *field : {&forward, &backward}) {
+        field->blockSize = block_size;
+        field->blocksX = (width + block_size - 1) / block_size;
+        field->blocksY = (height + block_size - 1) / block_size;
+    }
+    size_t field_bytes = static_cast<size_t>(forward.blocksX) * forward.blocksY * 2;
+    if (data.size() < RECORD_HEADER_BYTES + 2 * field_bytes) return false;
+
+    const int8_t *vectors = reinterpret_cast<const int8_t *>(data.data() + RECORD_HEADER_BYTES);
+    forward.vectors.assign(vectors, vectors + field_bytes);
+    backward.vectors.assign(vectors + field_bytes, vectors + 2 * field_bytes);
+    return true;
+}
+
+} // namespace utils
+} // namespace vcompress
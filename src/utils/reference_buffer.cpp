@@ -0,0 +1,33 @@
+#include "utils/reference_buffer.hpp"
+#include <algorithm>
+
+namespace vcompress {
+namespace utils {
+
+ReferenceBuffer::ReferenceBuffer(int capacity) : m_newest(0), m_count(0) { setCapacity(capacity); }
+
+void ReferenceBuffer::setCapacity(int capacity) {
+    m_slots.resize(std::clamp(capacity, 1, MAX_FRAMES));
+    m_newest = 0;
+    m_count = 0;
+}
+
+void ReferenceBuffer::push(const std::vector<uint8_t> &reconstruction) {
+    m_newest = (m_newest + 1) % capacity();
+    // assign() keeps the slot's capacity, so a payload of the same size is copied without allocating
+    m_slots[m_newest].assign(reconstruction.begin(), reconstruction.end());
+    m_count = std::min(m_count + 1, capacity());
+}
+
+const std::vector<uint8_t> &ReferenceBuffer::at(int index) const {
+    return m_slots[(m_newest - index + capacity()) % capacity()];
+}
+
+std::vector<const std::vector<uint8_t> *> ReferenceBuffer::window(int count) const {
+    std::vector<const std::vector<uint8_t> *> references;
+    for (int i = 0; i < std::min(count, m_count); i++) references.push_back(&at(i));
+    return references;
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,56 @@
+#include "utils/residual_coder.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace vcompress {
+namespace utils {
+
+/// @brief Lossless down to quality 84, then one more step per 16 quality points
+int residualQuantStep(int quality) { return std::max(1, (100 - quality) / 16); }
+
+/// @brief Clamp prediction + dequantized level to the 8-bit sample range
+static inline uint8_t reconstructSample(uint8_t prediction, int level, int quantStep) {
+    return static_cast<uint8_t>(std::max(0, std::min(255, prediction + level * quantStep)));
+}
+
+void encodeResidual(BitWriter &writer, const uint8_t *target, const uint8_t *prediction, size_t count,
+                    int quantStep, uint8_t *reconstruction) {
+    int half_step = quantStep / 2;
+    uint32_t run = 0;
+    for (size_t i = 0; i < count; i++) {
+        int residual = target[i] - prediction[i];
+        int level =
+            residual >= 0 ? (residual + half_step) / quantStep : -((-residual + half_step) / quantStep);
+        reconstruction[i] = reconstructSample(prediction[i], level, quantStep);
+        if (level == 0) {
+            run++;
+            continue;
+        }
+        writer.putUE(run);
+        // Levels are never zero here, so shift them by one to save a code
+        writer.putSE(level > 0 ? level - 1 : level);
+        run = 0;
+    }
+    writer.putUE(run);
+}
+
+bool decodeResidual(BitReader &reader, const uint8_t *prediction, size_t count, int quantStep,
+                    uint8_t *reconstruction) {
+    size_t i = 0;
+    while (true) {
+        uint32_t run;
+        if (!reader.getUE(run) || run > count - i) return false;
+        std::copy(prediction + i, prediction + i + run, reconstruction + i);
+        i += run;
+        if (i == count) return true;
+
+        int32_t coded;
+        if (!reader.getSE(coded)) return false;
+        int level = coded >= 0 ? coded + 1 : coded;
+        reconstruction[i] = reconstructSample(prediction[i], level, quantStep);
+        i++;
+    }
+}
+
+} // namespace utils
+} // namespace vcompress
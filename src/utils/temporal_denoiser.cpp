@@ -0,0 +1,58 @@
+#include "utils/temporal_denoiser.hpp"
+#include "utils/vector_lanes.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace vcompress {
+namespace utils {
+
+/// @brief Move one state sample towards the input by its motion-adaptive weight; returns the output sample
+static inline uint8_t filterSample(uint8_t input, uint16_t &state, int fraction_bits, int weight_one,
+                                   int min_weight, int slope) {
+    int delta = (input << fraction_bits) - state;
+    int weight = std::min(weight_one, min_weight + ((std::abs(delta) * slope) >> 8));
+    // The shift of a signed step rounds towards minus infinity; the bias makes it round to nearest
+    int value = state + ((delta * weight + 128) >> 8);
+    state = static_cast<uint16_t>(value);
+    return static_cast<uint8_t>((value + (1 << (fraction_bits - 1))) >> fraction_bits);
+}
+
+TemporalDenoiser::TemporalDenoiser(int strength) : m_strength(std::clamp(strength, 1, 10)) {
+    // Strength 1 averages about two frames and passes differences above 7; strength 10 averages about
+    // eleven frames and passes differences above 34 (8-bit sample units)
+    m_minWeight = WEIGHT_ONE / (1 + m_strength);
+    int threshold = (4 + 3 * m_strength) << FRACTION_BITS;
+    m_weightSlope = ((WEIGHT_ONE - m_minWeight) << 8) / threshold;
+}
+
+void TemporalDenoiser::process(const uint8_t *src, uint8_t *dst, size_t pixels, bool restart) {
+    size_t count = pixels * 3;
+    if (restart || m_state.size() != count) {
+        m_state.resize(count);
+        for (size_t i = 0; i < count; i++) m_state[i] = static_cast<uint16_t>(src[i] << FRACTION_BITS);
+        if (dst != src) std::memmove(dst, src, count);
+        return;
+    }
+
+    uint16_t *state = m_state.data();
+    size_t i = 0;
+    for (; i + LANE_SAMPLES <= count; i += LANE_SAMPLES) {
+        uint8_t input[LANE_SAMPLES], output[LANE_SAMPLES];
+        uint16_t lane_state[LANE_SAMPLES];
+        std::memcpy(input, src + i, sizeof(input));
+        std::memcpy(lane_state, state + i, sizeof(lane_state));
+        for (int k = 0; k < LANE_SAMPLES; k++) {
+            output[k] = filterSample(input[k], lane_state[k], FRACTION_BITS, WEIGHT_ONE, m_minWeight,
+                                     m_weightSlope);
+        }
+        std::memcpy(state + i, lane_state, sizeof(lane_state));
+        std::memcpy(dst + i, output, sizeof(output));
+    }
+    for (; i < count; i++) {
+        dst[i] = filterSample(src[i], state[i], FRACTION_BITS, WEIGHT_ONE, m_minWeight, m_weightSlope);
+    }
+}
+
+} // namespace utils
+} // namespace vcompress
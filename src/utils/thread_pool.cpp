@@ -0,0 +1,133 @@
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace vcompress {
+namespace utils {
+
+/// Pool and index of the worker running on this thread, so nested submissions stay local
+static thread_local const ThreadPool *t_pool = nullptr;
+static thread_local size_t t_workerIndex = 0;
+
+ThreadPool::ThreadPool(size_t threads) : m_queued(0), m_unfinished(0), m_nextQueue(0), m_stopping(false) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++) m_queues.push_back(std::make_unique<WorkerQueue>());
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskAvailable.notify_all();
+    for (auto &worker : m_workers) worker.join();
+}
+
+/// @brief Index of the calling worker, or size() for threads outside the pool
+size_t ThreadPool::currentWorker() const { return t_pool == this ? t_workerIndex : m_queues.size(); }
+
+void ThreadPool::submit(std::function<void()> task, TaskGroup *group) {
+    if (group) {
+        group->m_pending.fetch_add(1, std::memory_order_relaxed);
+        group->m_queued.fetch_add(1, std::memory_order_release);
+    }
+    m_unfinished.fetch_add(1, std::memory_order_relaxed);
+
+    // Counted before it is visible, so the count never drops below the number of queued tasks
+    m_queued.fetch_add(1, std::memory_order_release);
+    size_t worker = currentWorker();
+    size_t target = worker < m_queues.size() ? worker : m_nextQueue.fetch_add(1) % m_queues.size();
+    {
+        std::lock_guard<std::mutex> lock(m_queues[target]->mutex);
+        m_queues[target]->tasks.push_back(Task{std::move(task), group});
+    }
+
+    // Notifying under the sleep mutex orders the wake-up after a sleeper's check of m_queued
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_taskAvailable.notify_one();
+}
+
+/// @brief Take the newest or the oldest task of a queue, of the given group only if there is one
+bool ThreadPool::takeTask(std::deque<Task> &tasks, bool newest, const TaskGroup *only, Task &task) {
+    size_t count = tasks.size();
+    for (size_t i = 0; i < count; i++) {
+        size_t index = newest ? count - 1 - i : i;
+        if (only && tasks[index].group != only) continue;
+        task = std::move(tasks[index]);
+        tasks.erase(tasks.begin() + index);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Run one task: the newest of the home queue, else the oldest of any other queue
+ *  With `only`, just the tasks of that group are considered.
+ * @return false if there was no such task
+ */
+bool ThreadPool::tryRunTask(size_t home, const TaskGroup *only) {
+    Task task;
+    bool found = false;
+    if (home < m_queues.size()) {
+        std::lock_guard<std::mutex> lock(m_queues[home]->mutex);
+        found = takeTask(m_queues[home]->tasks, true, only, task);
+    }
+    for (size_t i = 1; !found && i <= m_queues.size(); i++) {
+        WorkerQueue &victim = *m_queues[(home + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        found = takeTask(victim.tasks, false, only, task);
+    }
+    if (!found) return false;
+
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    if (task.group) task.group->m_queued.fetch_sub(1, std::memory_order_relaxed);
+    task.function();
+
+    bool groupDone = task.group && task.group->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    bool allDone = m_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    if (groupDone || allDone) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_progress.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::wait() {
+    size_t home = currentWorker();
+    while (m_unfinished.load(std::memory_order_acquire) != 0) {
+        if (tryRunTask(home)) continue;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_progress.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+            return m_unfinished.load(std::memory_order_acquire) == 0 || m_queued.load() > 0;
+        });
+    }
+}
+
+void ThreadPool::wait(TaskGroup &group) {
+    size_t home = currentWorker();
+    while (!group.done()) {
+        if (tryRunTask(home, &group)) continue;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_progress.wait_for(lock, std::chrono::milliseconds(1),
+                            [&group]() { return group.done() || group.m_queued.load() > 0; });
+    }
+}
+
+/// @brief Run tasks until the pool stops and every queue is empty
+void ThreadPool::workerLoop(size_t index) {
+    t_pool = this;
+    t_workerIndex = index;
+    while (true) {
+        if (tryRunTask(index)) continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_taskAvailable.wait(lock, [this]() { return m_stopping || m_queued.load() > 0; });
+        if (m_stopping && m_queued.load() == 0) return;
+    }
+}
+
+} // namespace utils
+} // namespace vcompress
@@ -0,0 +1,117 @@
+#include "test.hpp"
+#include "core/encoder.hpp"
+#include <cstdio>
+#include <filesystem>
+
+using namespace vcompress;
+
+namespace {
+
+const int WIDTH = 96;
+const int HEIGHT = 64;
+const int FRAMES = 24;
+const int KEY_FRAME_INTERVAL = 8; // Three GOPs
+const char *CACHE_DIR = "test_gop_cache";
+const char *OUTPUT_PATH = "test_gop_cache.vcomp";
+
+/// @brief Write the test frames as an input video, frames in [changedFrom, changedTo) shifted in time
+bool writeInput(const std::string &path, int changedFrom, int changedTo) {
+    std::vector<int> frameNumbers;
+    for (int n = 0; n < FRAMES; n++) frameNumbers.push_back(n >= changedFrom && n < changedTo ? n + 50 : n);
+    return writeTestVideo(path, WIDTH, HEIGHT, frameNumbers);
+}
+
+struct CacheResult {
+    bool encoded = false;
+    int hits = 0;
+    int misses = 0;
+    std::string output;
+};
+
+core::EncoderConfig cacheConfig(const std::string &input, int quality) {
+    core::EncoderConfig config;
+    config.inputPath = input;
+    config.compressedDataPath = OUTPUT_PATH;
+    config.algorithmName = "BilinearDownsample";
+    config.quality = quality;
+    config.keyFrameInterval = KEY_FRAME_INTERVAL;
+    config.interPrediction = true;
+    config.keepAudio = false;
+    config.gopCacheDir = CACHE_DIR;
+    return config;
+}
+
+CacheResult encodeWith(const core::EncoderConfig &config) {
+    CacheResult result;
+    core::VideoEncoder encoder;
+    result.encoded = encoder.configure(config) && encoder.encode();
+    result.hits = encoder.getGopCacheHits();
+    result.misses = encoder.getGopCacheMisses();
+    result.output = readFile(OUTPUT_PATH);
+    return result;
+}
+
+CacheResult encodeCached(const std::string &input, int quality,
+                         const std::vector<algorithm::RegionOfInterest> &rois = {}) {
+    core::EncoderConfig config = cacheConfig(input, quality);
+    config.roiRegions = rois;
+    return encodeWith(config);
+}
+
+int checkCounts(const std::string &name, const CacheResult &result, int hits, int misses) {
+    return check(result.encoded && result.hits == hits && result.misses == misses,
+                 "GOP cache: " + name + " has " + std::to_string(hits) + " hits and " +
+                     std::to_string(misses) + " misses (got " + std::to_string(result.hits) + " and " +
+                     std::to_string(result.misses) + ")");
+}
+
+/// @brief GOPs cached from one input are reused for another input that only differs in its first GOP, so
+///  the long-term background may not carry anything across a key frame
+int testBackgroundIndependence(const std::string &input, const std::string &changedFirst) {
+    core::EncoderConfig config = cacheConfig(input, 75);
+    config.backgroundReference = true;
+    int failures = checkCounts("background, first encode", encodeWith(config), 0, 3);
+    config.inputPath = changedFirst;
+    CacheResult cached = encodeWith(config);
+    failures += checkCounts("background, first GOP changed", cached, 2, 1);
+    config.gopCacheDir.clear();
+    CacheResult straight = encodeWith(config);
+    failures += check(straight.encoded && !straight.output.empty() && cached.output == straight.output,
+                      "GOP cache: with a background reference, cached GOPs match a straight encode");
+    return failures;
+}
+
+} // namespace
+
+int gop_cache_main() {
+    std::filesystem::remove_all(CACHE_DIR);
+    const std::string input = "test_gop_cache_input.avi", changed = "test_gop_cache_changed.avi";
+    const std::string changedFirst = "test_gop_cache_changed_first.avi";
+    bool written = writeInput(input, FRAMES, FRAMES) &&
+                   writeInput(changed, KEY_FRAME_INTERVAL, 2 * KEY_FRAME_INTERVAL) &&
+                   writeInput(changedFirst, 0, KEY_FRAME_INTERVAL);
+    if (check(written, "GOP cache: write the input videos")) {
+        return 1;
+    }
+
+    // The key covers the source pixels and the coding settings, nothing else
+    CacheResult first = encodeCached(input, 75);
+    int failures = checkCounts("first encode", first, 0, 3);
+    CacheResult again = encodeCached(input, 75);
+    failures += checkCounts("same input and settings", again, 3, 0);
+    failures += check(!first.output.empty() && again.output == first.output,
+                      "GOP cache: a fully cached encode writes the same stream");
+    failures += checkCounts("other quality", encodeCached(input, 50), 0, 3);
+    failures += checkCounts("one GOP changed", encodeCached(changed, 75), 2, 1);
+    CacheResult withRois = encodeCached(input, 75, {algorithm::RegionOfInterest(8, 8, 32, 32)});
+    failures += checkCounts("ROIs added", withRois, 0, 3);
+    std::filesystem::remove_all(CACHE_DIR);
+    failures += testBackgroundIndependence(input, changedFirst);
+
+    std::filesystem::remove_all(CACHE_DIR);
+    std::remove(input.c_str());
+    std::remove(changed.c_str());
+    std::remove(changedFirst.c_str());
+    std::remove(OUTPUT_PATH);
+    return failures;
+}
@@ -0,0 +1,436 @@
+#include "test.hpp"
+#include "core/decoder.hpp"
+#include "core/encoder.hpp"
+#include "core/ladder_encoder.hpp"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+using namespace vcompress;
+
+namespace {
+
+const int WIDTH = 96;
+const int HEIGHT = 64;
+const int FRAMES = 24;
+const char *STREAM_PATH = "test_round_trip.vcomp";
+const char *INPUT_PATH = "test_round_trip_input.avi";
+
+using FrameSource = std::vector<uint8_t> (*)(int width, int height, int n);
+
+/// @brief Encode the test frames through the stream interface, in display order (BilinearDownsample unless
+///  the configuration names another algorithm)
+bool encodeStream(core::EncoderConfig config, FrameSource source = testFrame) {
+    if (config.algorithmName.empty()) config.algorithmName = "BilinearDownsample";
+    config.keepAudio = false;
+    core::VideoEncoder encoder;
+    if (!encoder.configure(config) || !encoder.beginStream(STREAM_PATH, WIDTH, HEIGHT, 30.0)) return false;
+    for (int n = 0; n < FRAMES; n++) {
+        std::vector<uint8_t> pixels = source(WIDTH, HEIGHT, n);
+        cv::Mat frame(HEIGHT, WIDTH, CV_8UC3, pixels.data());
+        encoder.encodeFrame(encoder.makeInputFrame(frame, n));
+    }
+    encoder.endStream();
+    return true;
+}
+
+/// @brief Decode the stream; the frames come back in output order
+std::vector<algorithm::Frame> decodeStream(int seekFrame = 0,
+                                           const std::string &algorithmName = "BilinearDownsample",
+                                           bool baseLayerOnly = false) {
+    core::DecoderConfig config;
+    config.compressedDataPath = STREAM_PATH;
+    config.algorithmName = algorithmName;
+    config.keepAudio = false;
+    config.seekFrame = seekFrame;
+    config.baseLayerOnly = baseLayerOnly;
+    core::VideoDecoder decoder;
+    std::vector<algorithm::Frame> frames;
+    if (!decoder.configure(config) ||
+        !decoder.decodeFrames([&frames](const algorithm::Frame &frame) { frames.push_back(frame); })) {
+        frames.clear();
+    }
+    return frames;
+}
+
+double psnr(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    if (a.size() != b.size() || a.empty()) return 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) sum += (a[i] - b[i]) * (a[i] - b[i]);
+    return sum == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 * a.size() / sum);
+}
+
+/// @brief PSNR of a rectangle of two frames
+double psnrRegion(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b,
+                  const algorithm::RegionOfInterest &region) {
+    if (a.size() != b.size() || a.empty()) return 0.0;
+    double sum = 0.0;
+    for (int y = region.y; y < region.y + region.height; y++) {
+        for (int x = region.x * 3; x < (region.x + region.width) * 3; x++) {
+            size_t i = static_cast<size_t>(y) * WIDTH * 3 + x;
+            sum += (a[i] - b[i]) * (a[i] - b[i]);
+        }
+    }
+    double samples = 3.0 * region.width * region.height;
+    return sum == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 * samples / sum);
+}
+
+/// @brief Frames first..FRAMES-1 come out once each, in display order
+int checkOutput(const std::string &name, const std::vector<algorithm::Frame> &frames, int first) {
+    int failures =
+        check(frames.size() == static_cast<size_t>(FRAMES - first), name + ": every frame is output");
+    for (size_t i = 0; i < frames.size(); i++) {
+        int timestamp = first + static_cast<int>(i);
+        failures += check(frames[i].timestamp == timestamp, name + ": frame " + std::to_string(timestamp) +
+                                                                " is output in display order");
+    }
+    return failures;
+}
+
+/// @brief Frames first..FRAMES-1 come out once each in display order, and each matches the intra-only decode
+///  of its source; a reference mismatch between encoder and decoder would drift away from it
+int checkFrames(const std::string &name, const std::vector<algorithm::Frame> &frames, int first,
+                const std::vector<algorithm::Frame> &intra) {
+    int failures = checkOutput(name, frames, first);
+    for (size_t i = 0; i < frames.size() && first + static_cast<int>(i) < FRAMES; i++) {
+        int timestamp = first + static_cast<int>(i);
+        // The downsampling alone costs ~29 dB on the test pattern; a neighbouring frame is ~25 dB away from
+        // the intra decode, the inter decode ~50 dB
+        double quality = psnr(frames[i].data, testFrame(WIDTH, HEIGHT, timestamp));
+        double match = psnr(frames[i].data, intra[timestamp].data);
+        failures += check(quality > 25.0 && match > 40.0,
+                          name + ": frame " + std::to_string(timestamp) + " decodes at " +
+                              std::to_string(quality) + " dB, " + std::to_string(match) +
+                              " dB from the intra decode");
+    }
+    return failures;
+}
+
+int testBidirectionalFrames(const std::vector<algorithm::Frame> &intra) {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    config.bFrames = 2;
+    if (check(encodeStream(config), "B-frames: encode")) return 1;
+    return checkFrames("B-frames", decodeStream(), 0, intra);
+}
+
+/// @brief A decoder seeking into an intra refresh stream starts at a recovery point, and from there on
+///  outputs exactly what a decoder that started at the first frame outputs; algorithms without a sample
+///  plane refuse intra refresh
+int testRefreshSeek(const std::vector<algorithm::Frame> &intra) {
+    core::EncoderConfig config;
+    config.intraRefreshPeriod = 4;
+    if (check(encodeStream(config), "Intra refresh: encode")) return 1;
+    std::vector<algorithm::Frame> full = decodeStream();
+    int failures = checkFrames("Intra refresh", full, 0, intra);
+
+    std::vector<algorithm::Frame> seeked = decodeStream(5);
+    failures += check(!seeked.empty() && seeked.front().timestamp >= 5 &&
+                          seeked.front().timestamp <= 5 + config.intraRefreshPeriod,
+                      "Intra refresh: a seek to 5 starts within one refresh cycle");
+    for (const auto &frame : seeked) {
+        if (frame.timestamp >= FRAMES || full.size() != static_cast<size_t>(FRAMES)) break;
+        failures += check(frame.data == full[frame.timestamp].data,
+                          "Intra refresh: seeked frame " + std::to_string(frame.timestamp) +
+                              " matches the full decode");
+    }
+    config.algorithmName = "VQ";
+    failures += check(!encodeStream(config), "Intra refresh: payloads without a sample plane refuse it");
+    return failures;
+}
+
+int testBlockCoding(const std::vector<algorithm::Frame> &intra) {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    config.blockCoding = true;
+    if (check(encodeStream(config), "Block coding: encode")) return 1;
+    return checkFrames("Block coding", decodeStream(), 0, intra);
+}
+
+int testMultipleReferences(const std::vector<algorithm::Frame> &intra) {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    config.referenceFrames = 3;
+    if (check(encodeStream(config), "Multiple references: encode")) return 1;
+    return checkFrames("Multiple references", decodeStream(), 0, intra);
+}
+
+/// @brief Every frame comes out in display order above `minimum` dB
+int checkQuality(const std::string &name, const std::vector<algorithm::Frame> &frames, double minimum) {
+    int failures = checkOutput(name, frames, 0);
+    for (const auto &frame : frames) {
+        double quality = psnr(frame.data, testFrame(WIDTH, HEIGHT, frame.timestamp));
+        failures += check(quality > minimum, name + ": frame " + std::to_string(frame.timestamp) +
+                                                 " decodes at " + std::to_string(quality) + " dB");
+    }
+    return failures;
+}
+
+/// @brief The factor is picked per GOP from the content; the decoder follows it from the payloads. Algorithms
+///  with a fixed factor refuse it
+int testAdaptiveFactor() {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    config.adaptiveFactor = true;
+    if (check(encodeStream(config), "Adaptive factor: encode")) return 1;
+    int failures = checkQuality("Adaptive factor", decodeStream(), 25.0);
+    config.algorithmName = "ScreenContent";
+    failures += check(!encodeStream(config), "Adaptive factor: an algorithm with a fixed factor refuses it");
+    return failures;
+}
+
+/// @brief Only every second frame is stored; the others are interpolated on decode and still come out in
+///  display order
+int testTemporalDownsampling() {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    if (check(encodeStream(config), "Temporal factor: full rate encode")) return 1;
+    size_t fullRate = readFile(STREAM_PATH).size();
+    config.temporalFactor = 2;
+    if (check(encodeStream(config), "Temporal factor: encode")) return 1;
+    int failures = check(readFile(STREAM_PATH).size() * 4 < fullRate * 3,
+                         "Temporal factor: the stream is smaller than at full rate");
+    return failures + checkQuality("Temporal factor", decodeStream(), 25.0);
+}
+
+/// @brief The enhancement layer lifts every frame well above the base layer, and skipping it decodes exactly
+///  what a stream without enhancement layers decodes
+int testEnhancementLayer() {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    if (check(encodeStream(config), "Enhancement layer: base layer encode")) return 1;
+    std::vector<algorithm::Frame> plain = decodeStream();
+    config.enhancementQuantStep = 4;
+    if (check(encodeStream(config), "Enhancement layer: encode")) return 1;
+    std::vector<algorithm::Frame> base = decodeStream(0, "BilinearDownsample", true);
+
+    // The base layer alone is ~29 dB; with the layer at step 4 ~46 dB
+    int failures = checkQuality("Enhancement layer", decodeStream(), 40.0);
+    failures += checkOutput("Enhancement layer: base layer only", base, 0);
+    failures += check(plain.size() == base.size(), "Enhancement layer: the plain stream decodes");
+    for (size_t i = 0; i < base.size() && i < plain.size(); i++) {
+        failures += check(base[i].data == plain[i].data, "Enhancement layer: frame " + std::to_string(i) +
+                                                             " of the base layer matches the plain stream");
+    }
+    return failures;
+}
+
+/// @brief A reduced bit depth shrinks the stored plane by bits / 8 and still decodes every frame; algorithms
+///  that always store 8-bit samples refuse it
+int testBitDepth() {
+    core::EncoderConfig config;
+    config.keyFrameInterval = 12;
+    if (check(encodeStream(config), "Bit depth: 8-bit encode")) return 1;
+    size_t fullDepth = readFile(STREAM_PATH).size();
+    config.bitDepth = 6;
+    if (check(encodeStream(config), "Bit depth: encode")) return 1;
+    int failures = check(readFile(STREAM_PATH).size() * 8 < fullDepth * 7,
+                         "Bit depth: the stream is smaller than at 8 bits");
+    failures += checkQuality("Bit depth", decodeStream(), 25.0);
+    config.algorithmName = "ROIDownsample";
+    failures += check(!encodeStream(config), "Bit depth: an algorithm without bit-packing refuses it");
+    return failures;
+}
+
+/// @brief Tiles under a ROI are kept at full resolution, the rest is downsampled
+int testRegionOfInterest() {
+    const algorithm::RegionOfInterest roi(16, 16, 32, 32), background(56, 16, 32, 32);
+    core::EncoderConfig config;
+    config.algorithmName = "ROIDownsample";
+    config.keyFrameInterval = 12;
+    config.roiRegions = {roi};
+    if (check(encodeStream(config), "ROI: encode")) return 1;
+    std::vector<algorithm::Frame> frames = decodeStream(0, config.algorithmName);
+    int failures = checkOutput("ROI", frames, 0);
+    for (const auto &frame : frames) {
+        std::vector<uint8_t> source = testFrame(WIDTH, HEIGHT, frame.timestamp);
+        double inside = psnrRegion(frame.data, source, roi);
+        double outside = psnrRegion(frame.data, source, background);
+        failures += check(inside > 40.0 && inside > outside + 10.0 && outside > 25.0,
+                          "ROI: frame " + std::to_string(frame.timestamp) + " decodes at " +
+                              std::to_string(inside) + " dB in the ROI, " + std::to_string(outside) +
+                              " dB outside");
+    }
+    return failures;
+}
+
+/// @brief The codebook is trained and sent once per GOP, so longer GOPs cost less per frame
+int testVectorQuantization() {
+    core::EncoderConfig config;
+    config.algorithmName = "VQ";
+    config.keyFrameInterval = 1;
+    if (check(encodeStream(config), "VQ: encode with one-frame GOPs")) return 1;
+    size_t intraBytes = readFile(STREAM_PATH).size();
+    config.keyFrameInterval = 12;
+    if (check(encodeStream(config), "VQ: encode")) return 1;
+    size_t gopBytes = readFile(STREAM_PATH).size();
+
+    std::vector<algorithm::Frame> frames = decodeStream(0, config.algorithmName);
+    int failures = checkOutput("VQ", frames, 0);
+    for (const auto &frame : frames) {
+        double quality = psnr(frame.data, testFrame(WIDTH, HEIGHT, frame.timestamp));
+        failures += check(quality > 28.0, "VQ: frame " + std::to_string(frame.timestamp) + " decodes at " +
+                                              std::to_string(quality) + " dB");
+    }
+    failures += check(gopBytes < intraBytes / 2,
+                      "VQ: a codebook per 12-frame GOP (" + std::to_string(gopBytes) +
+                          " bytes) is cheaper than one per frame (" + std::to_string(intraBytes) + " bytes)");
+    return failures;
+}
+
+/// @brief Screen recording frame n: a flat desktop with a title bar, lines of text and a window moving three
+///  pixels per frame, five colours in all
+std::vector<uint8_t> screenFrame(int width, int height, int n) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3, 236);
+    int windowX = 40 + 3 * n % 40;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *pixel = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+            bool text = y >= 16 && y < 48 && x >= 8 && x < 56 && y % 8 < 5 && (x * 7 + y * 3) % 5 < 2;
+            bool window = x >= windowX && x < windowX + 12 && y >= 20 && y < 44;
+            if (y < 8) {
+                pixel[0] = 120, pixel[1] = 80, pixel[2] = 40;
+            } else if (window) {
+                pixel[0] = 30, pixel[1] = 30, pixel[2] = 200;
+            } else if (text) {
+                pixel[0] = pixel[1] = pixel[2] = 20;
+            }
+        }
+    }
+    return pixels;
+}
+
+/// @brief Palette content round trips exactly
+int testScreenContent() {
+    core::EncoderConfig config;
+    config.algorithmName = "ScreenContent";
+    config.keyFrameInterval = 12;
+    if (check(encodeStream(config, screenFrame), "Screen content: encode")) return 1;
+    std::vector<algorithm::Frame> frames = decodeStream(0, config.algorithmName);
+    int failures = checkOutput("Screen content", frames, 0);
+    for (const auto &frame : frames) {
+        failures += check(frame.data == screenFrame(WIDTH, HEIGHT, frame.timestamp),
+                          "Screen content: frame " + std::to_string(frame.timestamp) + " decodes exactly");
+    }
+    return failures;
+}
+
+/**
+ * @brief An encode interrupted mid-GOP and resumed from its last checkpoint writes the same stream as an
+ *  uninterrupted one; intra refresh has no checkpoints and cannot be resumed
+ */
+int testCheckpointResume() {
+    std::vector<int> frameNumbers;
+    for (int n = 0; n < FRAMES; n++) frameNumbers.push_back(n);
+    if (check(writeTestVideo(INPUT_PATH, WIDTH, HEIGHT, frameNumbers), "Resume: write the input video")) {
+        return 1;
+    }
+    core::EncoderConfig config;
+    config.inputPath = INPUT_PATH;
+    config.compressedDataPath = STREAM_PATH;
+    config.algorithmName = "BilinearDownsample";
+    config.keyFrameInterval = 6;
+    config.bFrames = 2;
+    config.backgroundReference = true;
+    config.keepAudio = false;
+    config.checkpointSeconds = 0.0;
+
+    // Keep the output and the checkpoint as a crash after frame 15 would leave them: the last checkpoint is
+    // the one before key frame 12, and the output has records beyond it
+    const std::string checkpointPath = std::string(STREAM_PATH) + ".ckpt";
+    const std::string savedStream = "test_round_trip_saved.vcomp";
+    const std::string savedCheckpoint = savedStream + ".ckpt";
+    core::VideoEncoder encoder;
+    encoder.setProgressCallback([&](int frames) {
+        if (frames != 15) return;
+        std::error_code error;
+        auto overwrite = std::filesystem::copy_options::overwrite_existing;
+        std::filesystem::copy_file(STREAM_PATH, savedStream, overwrite, error);
+        std::filesystem::copy_file(checkpointPath, savedCheckpoint, overwrite, error);
+    });
+    bool encoded = encoder.configure(config) && encoder.encode();
+    std::string straight = readFile(STREAM_PATH);
+    int failures = check(encoded && !straight.empty(), "Resume: straight encode");
+    failures +=
+        check(!std::filesystem::exists(checkpointPath), "Resume: a finished encode removes its checkpoint");
+    failures += check(!readFile(savedCheckpoint).empty(), "Resume: a checkpoint is taken before a key frame");
+
+    std::filesystem::rename(savedStream, STREAM_PATH);
+    std::filesystem::rename(savedCheckpoint, checkpointPath);
+    config.resume = true;
+    core::VideoEncoder resumed;
+    int firstReported = 0;
+    resumed.setProgressCallback([&firstReported](int frames) {
+        if (firstReported == 0) firstReported = frames;
+    });
+    failures += check(resumed.configure(config) && resumed.encode() && readFile(STREAM_PATH) == straight,
+                      "Resume: the resumed encode matches the straight encode");
+    failures += check(firstReported > 12, "Resume: the encode continues at the checkpoint (first reported " +
+                                              std::to_string(firstReported) + " frames)");
+
+    config.bFrames = 0;
+    config.backgroundReference = false;
+    config.intraRefreshPeriod = 6;
+    core::VideoEncoder refreshing;
+    failures += check(!refreshing.configure(config), "Resume: intra refresh cannot be resumed");
+    std::remove(INPUT_PATH);
+    return failures;
+}
+
+/// @brief Ladder settings the rung encoders cannot honour are rejected up front
+int testLadderSettings() {
+    std::vector<core::LadderRung> rungs;
+    int failures = check(!core::LadderEncoder::parseRungs("BilinearDownsample:abc", 75, rungs),
+                         "Ladder: a non-numeric quality is rejected");
+    rungs.clear();
+    bool parsed = core::LadderEncoder::parseRungs("BilinearDownsample:40,BilinearDownsample", 75, rungs);
+    failures += check(parsed && rungs.size() == 2 && rungs[0].quality == 40 && rungs[1].quality == 75,
+                      "Ladder: explicit and default qualities");
+
+    const std::string cacheDir = "test_round_trip_ladder_cache";
+    core::LadderConfig config;
+    config.rungs = rungs;
+    config.base.compressedDataPath = STREAM_PATH;
+    config.base.keepAudio = false;
+    config.base.gopCacheDir = cacheDir;
+    core::LadderEncoder cached;
+    failures += check(!cached.configure(config) && !std::filesystem::exists(cacheDir),
+                      "Ladder: the GOP cache is rejected before its directory is created");
+    config.base.gopCacheDir.clear();
+    config.base.resume = true;
+    core::LadderEncoder resumed;
+    failures += check(!resumed.configure(config), "Ladder: resuming is rejected");
+    config.base.resume = false;
+    config.base.endFrame = 10;
+    core::LadderEncoder ranged;
+    failures += check(!ranged.configure(config), "Ladder: a frame range is rejected");
+    std::filesystem::remove_all(cacheDir);
+    return failures;
+}
+
+} // namespace
+
+int round_trip_main() {
+    // Every frame a key frame: the reference for what the predicted modes must reconstruct
+    core::EncoderConfig config;
+    config.keyFrameInterval = 1;
+    std::vector<algorithm::Frame> intra;
+    if (encodeStream(config)) intra = decodeStream();
+    if (check(intra.size() == static_cast<size_t>(FRAMES), "Intra only: every frame is output")) return 1;
+
+    int failures = testBidirectionalFrames(intra);
+    failures += testRefreshSeek(intra);
+    failures += testBlockCoding(intra);
+    failures += testMultipleReferences(intra);
+    failures += testAdaptiveFactor();
+    failures += testTemporalDownsampling();
+    failures += testEnhancementLayer();
+    failures += testBitDepth();
+    failures += testRegionOfInterest();
+    failures += testVectorQuantization();
+    failures += testScreenContent();
+    failures += testCheckpointResume();
+    failures += testLadderSettings();
+    std::remove(STREAM_PATH);
+    return failures;
+}
@@ -0,0 +1,133 @@
+#include "test.hpp"
+#include "core/segment_encoder.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+
+using namespace vcompress;
+
+namespace {
+
+const int WIDTH = 96;
+const int HEIGHT = 64;
+const int FRAMES = 40;
+const char *INPUT_PATH = "test_segment_input.avi";
+const char *SHARED_DIR = "test_segment_shared";
+const char *OUTPUT_PATH = "test_segment.vcomp";
+const char *STRAIGHT_PATH = "test_segment_straight.vcomp";
+
+/// @brief Two GOPs per segment and B-frames, so segments end on held back frames: three segments
+core::SegmentConfig segmentConfig(const std::string &input) {
+    core::SegmentConfig config;
+    config.sharedDir = SHARED_DIR;
+    config.segmentGops = 2;
+    config.encoder.inputPath = input;
+    config.encoder.compressedDataPath = OUTPUT_PATH;
+    config.encoder.algorithmName = "BilinearDownsample";
+    config.encoder.keyFrameInterval = 8;
+    config.encoder.bFrames = 2;
+    config.encoder.keepAudio = false;
+    return config;
+}
+
+/// @brief Run the coordinator and, once it has published the plan, one worker in this process
+bool runDistributed(const core::SegmentConfig &config) {
+    std::string settingsPath = std::string(SHARED_DIR) + "/settings";
+    std::future<bool> coordinated = std::async(std::launch::async, [config]() {
+        core::SegmentCoordinator coordinator;
+        return coordinator.run(config);
+    });
+    while (!std::filesystem::exists(settingsPath) &&
+           coordinated.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+    }
+    if (coordinated.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        core::SegmentWorker worker;
+        worker.run(SHARED_DIR);
+    }
+    return coordinated.get();
+}
+
+/// @brief Only the complete marker is left once an encode is assembled
+bool onlyMarkerLeft() {
+    int entries = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(SHARED_DIR)) {
+        entries++;
+        if (entry.path().filename() != "complete") return false;
+    }
+    return entries == 1;
+}
+
+int testConcatenation(const std::string &straight) {
+    int failures = check(runDistributed(segmentConfig(INPUT_PATH)), "Segments: distributed encode");
+    failures += check(!straight.empty() && readFile(OUTPUT_PATH) == straight,
+                      "Segments: the concatenated segments match a straight encode");
+    failures += check(onlyMarkerLeft(), "Segments: a finished encode removes its plan");
+
+    // A second run in the same directory plans afresh instead of waiting for the old plan
+    std::remove(OUTPUT_PATH);
+    failures += check(runDistributed(segmentConfig(INPUT_PATH)) && readFile(OUTPUT_PATH) == straight,
+                      "Segments: a second encode in the same directory");
+    return failures;
+}
+
+int testOtherSettings() {
+    // An unfinished plan made with another quality
+    std::filesystem::create_directories(SHARED_DIR);
+    std::ofstream settings(std::string(SHARED_DIR) + "/settings");
+    settings << "input " << INPUT_PATH << "\nquality 50\nsegments 3\n";
+    settings.close();
+    core::SegmentCoordinator coordinator;
+    int failures = check(!coordinator.run(segmentConfig(INPUT_PATH)),
+                         "Segments: an unfinished plan with other settings is rejected");
+    std::filesystem::remove_all(SHARED_DIR);
+    return failures;
+}
+
+int testFailingSegment() {
+    // The input disappears after planning, so every attempt at every segment fails
+    const std::string input = "test_segment_vanishing.avi";
+    std::filesystem::copy_file(INPUT_PATH, input, std::filesystem::copy_options::overwrite_existing);
+    core::SegmentConfig config = segmentConfig(input);
+    std::future<bool> coordinated = std::async(std::launch::async, [config]() {
+        core::SegmentCoordinator coordinator;
+        return coordinator.run(config);
+    });
+    while (!std::filesystem::exists(std::string(SHARED_DIR) + "/settings")) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::remove(input.c_str());
+    core::SegmentWorker worker;
+    int failures = check(!worker.run(SHARED_DIR), "Segments: the worker reports its failed segments");
+    failures += check(!coordinated.get(), "Segments: the encode fails once a segment keeps failing");
+    std::filesystem::remove_all(SHARED_DIR);
+    return failures;
+}
+
+} // namespace
+
+int segment_encoder_main() {
+    std::filesystem::remove_all(SHARED_DIR);
+    std::vector<int> frameNumbers;
+    for (int n = 0; n < FRAMES; n++) frameNumbers.push_back(n);
+    if (check(writeTestVideo(INPUT_PATH, WIDTH, HEIGHT, frameNumbers), "Segments: write the input video")) {
+        return 1;
+    }
+
+    core::EncoderConfig config = segmentConfig(INPUT_PATH).encoder;
+    config.compressedDataPath = STRAIGHT_PATH;
+    core::VideoEncoder encoder;
+    bool encoded = encoder.configure(config) && encoder.encode();
+    std::string straight = encoded ? readFile(STRAIGHT_PATH) : "";
+
+    int failures = testConcatenation(straight);
+    std::filesystem::remove_all(SHARED_DIR);
+    failures += testOtherSettings();
+    failures += testFailingSegment();
+
+    std::remove(INPUT_PATH);
+    std::remove(OUTPUT_PATH);
+    std::remove(STRAIGHT_PATH);
+    return failures;
+}
@@ -1,7 +1,73 @@
 #include "test.hpp"
+#include "algorithms/bilinear_downsample_algorithm.hpp"
+#include "algorithms/roi_downsample_algorithm.hpp"
+#include "algorithms/screen_content_algorithm.hpp"
+#include "algorithms/vq_algorithm.hpp"
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+int check(bool condition, const std::string &what) {
+    if (!condition) std::cerr << "FAILED: " << what << std::endl;
+    return condition ? 0 : 1;
+}
+
+template <typename Algorithm> static void registerAlgorithm(const std::string &name) {
+    using namespace vcompress::algorithm;
+    if (AlgorithmFactory::isAlgorithmAvailable(name)) return;
+    AlgorithmFactory::registerAlgorithm(name, []() -> std::unique_ptr<BaseCompressionAlgorithm> {
+        return std::make_unique<Algorithm>();
+    });
+}
+
+void registerTestAlgorithms() {
+    using namespace vcompress::algorithm;
+    registerAlgorithm<BilinearDownsampleAlgorithm>("BilinearDownsample");
+    registerAlgorithm<ROIDownsampleAlgorithm>("ROIDownsample");
+    registerAlgorithm<ScreenContentAlgorithm>("ScreenContent");
+    registerAlgorithm<VQAlgorithm>("VQ");
+}
+
+std::vector<uint8_t> testFrame(int width, int height, int n) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                double value = 128 + 60 * std::sin((x + 3 * n) * 0.11 + c) + 40 * std::cos(y * 0.09 - c);
+                pixels[(static_cast<size_t>(y) * width + x) * 3 + c] = static_cast<uint8_t>(value);
+            }
+        }
+    }
+    return pixels;
+}
+
+bool writeTestVideo(const std::string &path, int width, int height, const std::vector<int> &frameNumbers) {
+    cv::VideoWriter writer;
+    int fourcc = cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+    if (!writer.open(path, fourcc, 30.0, cv::Size(width, height))) return false;
+    for (int n : frameNumbers) {
+        std::vector<uint8_t> pixels = testFrame(width, height, n);
+        writer.write(cv::Mat(height, width, CV_8UC3, pixels.data()));
+    }
+    writer.release();
+    return true;
+}
+
+std::string readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
 
 int main(int argc, char **argv) {
-    int ret = pipeline_main(argc, argv);
-    (void)ret;
-    return 0;
-}
\ No newline at end of file
+    // With an input and an output video, run the copy pipeline; without arguments, the tests
+    if (argc == 3) return pipeline_main(argc, argv) == 0 ? 0 : 1;
+
+    registerTestAlgorithms();
+    int failures = thread_pool_main() + gop_cache_main() + segment_encoder_main() + round_trip_main();
+    if (failures == 0) {
+        std::cout << "All tests passed" << std::endl;
+    } else {
+        std::cerr << failures << " checks failed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
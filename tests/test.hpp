@@ -1,5 +1,28 @@
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <string>
+#include <vector>
 
-int pipeline_main(int argc, char **argv);
\ No newline at end of file
+int pipeline_main(int argc, char **argv);
+
+// Unit and round trip tests; each returns its number of failed checks
+int thread_pool_main();
+int gop_cache_main();
+int segment_encoder_main();
+int round_trip_main();
+
+/// @brief Report a failed check; returns 1 if it failed, so tests can add up their failures
+int check(bool condition, const std::string &what);
+
+/// @brief Register the algorithms the tests encode with (the executable's registration lives in main.cpp)
+void registerTestAlgorithms();
+
+/// @brief Source frame n: a smooth BGR pattern drifting three pixels per frame, so inter prediction has
+///  something to predict and a decode of the wrong frame stands out
+std::vector<uint8_t> testFrame(int width, int height, int n);
+
+/// @brief Write testFrame(frameNumbers[i]) as frame i of an input video
+bool writeTestVideo(const std::string &path, int width, int height, const std::vector<int> &frameNumbers);
+
+/// @brief Content of a file, empty if it cannot be read
+std::string readFile(const std::string &path);
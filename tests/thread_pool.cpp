@@ -0,0 +1,104 @@
+#include "test.hpp"
+#include "utils/thread_pool.hpp"
+#include <atomic>
+#include <thread>
+
+using vcompress::utils::ThreadPool;
+
+/// @brief Every task of a group has run once wait returns
+static int testGroupWait() {
+    ThreadPool pool(4);
+    ThreadPool::TaskGroup group;
+    std::atomic<int> count(0);
+    for (int i = 0; i < 1000; i++) pool.submit([&count]() { count++; }, &group);
+    pool.wait(group);
+    return check(count == 1000 && group.done(),
+                 "ThreadPool: wait(group) returns after all tasks of the group");
+}
+
+/// @brief Independent users of one pool each wait for their own group only
+static int testIndependentGroups() {
+    ThreadPool pool(2);
+    ThreadPool::TaskGroup first, second;
+    std::atomic<int> firstCount(0), secondCount(0);
+    for (int i = 0; i < 200; i++) {
+        pool.submit([&firstCount]() { firstCount++; }, &first);
+        pool.submit([&secondCount]() { secondCount++; }, &second);
+    }
+    pool.wait(first);
+    int failures =
+        check(firstCount == 200 && first.done(), "ThreadPool: first group complete after its wait");
+    pool.wait(second);
+    failures +=
+        check(secondCount == 200 && second.done(), "ThreadPool: second group complete after its wait");
+    return failures;
+}
+
+/// @brief Tasks that fork and join on the same pool finish even when they outnumber the workers
+static int testNestedForkJoin() {
+    ThreadPool pool(2);
+    ThreadPool::TaskGroup outer;
+    std::atomic<int> leaves(0);
+    for (int i = 0; i < 8; i++) {
+        pool.submit(
+            [&pool, &leaves]() {
+                ThreadPool::TaskGroup inner;
+                for (int j = 0; j < 16; j++) pool.submit([&leaves]() { leaves++; }, &inner);
+                pool.wait(inner);
+            },
+            &outer);
+    }
+    pool.wait(outer);
+    return check(leaves == 8 * 16, "ThreadPool: nested fork/join completes on a small pool");
+}
+
+/// @brief wait() covers tasks submitted without a group
+static int testWaitAll() {
+    ThreadPool pool(3);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 100; i++) pool.submit([&count]() { count++; });
+    pool.wait();
+    int failures = check(count == 100, "ThreadPool: wait() returns after ungrouped tasks");
+    failures += check(pool.size() == 3, "ThreadPool: size() is the requested number of workers");
+    failures += check(ThreadPool().size() > 0, "ThreadPool: default size is at least one worker");
+    return failures;
+}
+
+/// @brief Queued tasks still run when the pool is destroyed
+static int testDestructorDrains() {
+    std::atomic<int> count(0);
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 100; i++) pool.submit([&count]() { count++; });
+    }
+    return check(count == 100, "ThreadPool: the destructor finishes queued tasks");
+}
+
+/// @brief A thread waiting on a group helps with that group's tasks only, never with an unrelated task
+static int testWaitRunsOnlyGroup() {
+    ThreadPool pool(1);
+    std::atomic<bool> started(false), release(false), unrelatedRan(false);
+    pool.submit([&]() {
+        started = true;
+        while (!release) std::this_thread::yield();
+    });
+    while (!started) std::this_thread::yield();
+
+    // The only worker is busy, so the waiting thread has to run the group's tasks itself
+    pool.submit([&unrelatedRan]() { unrelatedRan = true; });
+    ThreadPool::TaskGroup group;
+    std::atomic<int> count(0);
+    for (int i = 0; i < 10; i++) pool.submit([&count]() { count++; }, &group);
+    pool.wait(group);
+    int failures = check(count == 10, "ThreadPool: the waiting thread runs the tasks of its group");
+    failures += check(!unrelatedRan, "ThreadPool: the waiting thread leaves other tasks to the workers");
+    release = true;
+    pool.wait();
+    failures += check(unrelatedRan, "ThreadPool: the other task runs on a worker");
+    return failures;
+}
+
+int thread_pool_main() {
+    return testGroupWait() + testIndependentGroups() + testNestedForkJoin() + testWaitAll() +
+           testDestructorDrains() + testWaitRunsOnlyGroup();
+}